@@ -0,0 +1,78 @@
+// Copyright 2011-2023:
+//   GobySoft, LLC (2013-)
+//   Massachusetts Institute of Technology (2007-2014)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <fstream>
+#include <iostream>
+
+#include "../../exception.h"
+#include "../../trace.h"
+
+// renders the binary traces written by dccl::TraceBuffer::write()
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help"))
+    {
+        std::cout << "usage: dccl_trace [trace_file (0-n)]\n"
+                  << "renders traces written by dccl::TraceBuffer::write() (reads standard input "
+                     "if no files are given)"
+                  << std::endl;
+        return 0;
+    }
+
+    auto render = [](std::istream& is, const std::string& source) {
+        std::vector<std::string> codec_names;
+        std::vector<dccl::TraceRecord> records;
+        try
+        {
+            dccl::TraceBuffer::read(is, &codec_names, &records);
+        }
+        catch (dccl::Exception& e)
+        {
+            std::cerr << "failed to read trace from " << source << ": " << e.what() << std::endl;
+            return false;
+        }
+        dccl::TraceBuffer::render(std::cout, codec_names, records);
+        return true;
+    };
+
+    if (argc < 2)
+        return render(std::cin, "standard input") ? 0 : 1;
+
+    int ret = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream ifs(argv[i], std::ios::binary);
+        if (!ifs.is_open())
+        {
+            std::cerr << "failed to open: " << argv[i] << std::endl;
+            ret = 1;
+            continue;
+        }
+
+        if (argc > 2)
+            std::cout << "== " << argv[i] << " ==" << std::endl;
+        if (!render(ifs, argv[i]))
+            ret = 1;
+    }
+    return ret;
+}
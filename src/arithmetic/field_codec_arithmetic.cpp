@@ -21,7 +21,10 @@
 //
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <cmath>
+
 #include "field_codec_arithmetic.h"
+#include "field_codec_range.h"
 #include "../codec.h"
 #include "../field_codec_manager.h"
 
@@ -35,11 +38,6 @@ const int dccl::arith::Model::CODE_VALUE_BITS;
 const int dccl::arith::Model::FREQUENCY_BITS;
 const dccl::arith::Model::freq_type dccl::arith::Model::MAX_FREQUENCY;
 
-#if DCCL_THREAD_SUPPORT
-std::recursive_mutex dccl::arith::Model::last_bits_map_mutex;
-#endif
-std::map<std::string, std::map<std::string, dccl::Bitset>> dccl::arith::Model::last_bits_map;
-
 // shared library load
 extern "C"
 {
@@ -69,6 +67,16 @@ extern "C"
         dccl->manager().add<ArithmeticFieldCodec<bool>>("dccl.arithmetic");
         dccl->manager().add<ArithmeticFieldCodec<const google::protobuf::EnumValueDescriptor*>>(
             "dccl.arithmetic");
+
+        dccl->manager().add<RangeFieldCodec<int32>>("dccl.range");
+        dccl->manager().add<RangeFieldCodec<int64>>("dccl.range");
+        dccl->manager().add<RangeFieldCodec<uint32>>("dccl.range");
+        dccl->manager().add<RangeFieldCodec<uint64>>("dccl.range");
+        dccl->manager().add<RangeFieldCodec<double>>("dccl.range");
+        dccl->manager().add<RangeFieldCodec<float>>("dccl.range");
+        dccl->manager().add<RangeFieldCodec<bool>>("dccl.range");
+        dccl->manager().add<RangeFieldCodec<const google::protobuf::EnumValueDescriptor*>>(
+            "dccl.range");
     }
     void dccl3_unload(dccl::Codec* dccl) { dccl_arithmetic_unload(dccl); }
 
@@ -96,32 +104,74 @@ extern "C"
         dccl->manager().remove<ArithmeticFieldCodec<bool>>("dccl.arithmetic");
         dccl->manager().remove<ArithmeticFieldCodec<const google::protobuf::EnumValueDescriptor*>>(
             "dccl.arithmetic");
+
+        dccl->manager().remove<RangeFieldCodec<int32>>("dccl.range");
+        dccl->manager().remove<RangeFieldCodec<int64>>("dccl.range");
+        dccl->manager().remove<RangeFieldCodec<uint32>>("dccl.range");
+        dccl->manager().remove<RangeFieldCodec<uint64>>("dccl.range");
+        dccl->manager().remove<RangeFieldCodec<double>>("dccl.range");
+        dccl->manager().remove<RangeFieldCodec<float>>("dccl.range");
+        dccl->manager().remove<RangeFieldCodec<bool>>("dccl.range");
+        dccl->manager().remove<RangeFieldCodec<const google::protobuf::EnumValueDescriptor*>>(
+            "dccl.range");
     }
 }
 
 dccl::arith::Model::symbol_type dccl::arith::Model::value_to_symbol(value_type value) const
 {
-    if (value < *user_model_.value_bound().begin() ||
-        value > *(user_model_.value_bound().end() - 1))
+    const auto& bounds = user_model_.value_bound();
+    // NaN compares false against both bounds, so must be rejected explicitly
+    if (std::isnan(value) || value < *bounds.begin() || value > *(bounds.end() - 1))
         return Model::OUT_OF_RANGE_SYMBOL;
 
-    google::protobuf::RepeatedField<double>::const_iterator upper_it =
-        std::upper_bound(user_model_.value_bound().begin(), user_model_.value_bound().end(), value);
+    // index of the first bound greater than value (as std::upper_bound)
+    int upper;
+    if (uniform_bounds_)
+    {
+        // estimate from the spacing, then correct for any rounding or unevenness
+        int n = bounds.size();
+        upper = std::max(0, std::min(n, static_cast<int>((value - bounds[0]) / bound_step_) + 1));
+        while (upper > 0 && bounds[upper - 1] > value) --upper;
+        while (upper < n && bounds[upper] <= value) ++upper;
+    }
+    else
+    {
+        upper = std::upper_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+    }
+
+    int lower = (upper == 0) ? upper : upper - 1;
+    if (upper == bounds.size())
+        upper = lower;
 
-    google::protobuf::RepeatedField<double>::const_iterator lower_it =
-        (upper_it == user_model_.value_bound().begin()) ? upper_it : upper_it - 1;
+    double lower_diff = std::abs(bounds[lower] * bounds[lower] - value * value);
+    double upper_diff = std::abs(bounds[upper] * bounds[upper] - value * value);
 
-    double lower_diff = std::abs((*lower_it) * (*lower_it) - value * value);
-    double upper_diff = std::abs((*upper_it) * (*upper_it) - value * value);
+    symbol_type symbol = (lower_diff < upper_diff) ? lower : upper;
 
-    //    std::cout << "value: " << value << std::endl;
-    //    std::cout << "lower_value: " << *lower_it << std::endl;
-    //    std::cout << "upper_value: " << *upper_it << std::endl;
+    // the last bound only closes the range of the last symbol
+    return std::min(symbol, max_symbol());
+}
 
-    symbol_type symbol =
-        ((lower_diff < upper_diff) ? lower_it : upper_it) - user_model_.value_bound().begin();
+void dccl::arith::Model::compile()
+{
+    const auto& bounds = user_model_.value_bound();
+    int n = bounds.size();
+    uniform_bounds_ = false;
+    if (n > 2)
+    {
+        bound_step_ = (bounds[n - 1] - bounds[0]) / (n - 1);
 
-    return symbol;
+        // the estimate in value_to_symbol() is then off by at most one bound
+        uniform_bounds_ = true;
+        for (int i = 0; i < n; ++i)
+        {
+            if (std::abs(bounds[i] - (bounds[0] + i * bound_step_)) > bound_step_ / 2)
+            {
+                uniform_bounds_ = false;
+                break;
+            }
+        }
+    }
 }
 
 dccl::arith::Model::value_type dccl::arith::Model::symbol_to_value(symbol_type symbol) const
@@ -139,21 +189,12 @@ dccl::arith::Model::value_type dccl::arith::Model::symbol_to_value(symbol_type s
 std::pair<dccl::arith::Model::freq_type, dccl::arith::Model::freq_type>
 dccl::arith::Model::symbol_to_cumulative_freq(symbol_type symbol, ModelState state) const
 {
-    const auto& c_freqs =
-        (state == ENCODER) ? encoder_cumulative_freqs_ : decoder_cumulative_freqs_;
+    const Frequencies& f = freqs(state);
+    std::size_t i = index(symbol);
 
-    auto c_freq_it = c_freqs.find(symbol);
     std::pair<freq_type, freq_type> c_freq_range;
-    c_freq_range.second = c_freq_it->second;
-    if (c_freq_it == c_freqs.begin())
-    {
-        c_freq_range.first = 0;
-    }
-    else
-    {
-        c_freq_it--;
-        c_freq_range.first = c_freq_it->second;
-    }
+    c_freq_range.second = f.cumulative(i);
+    c_freq_range.first = c_freq_range.second - f.freq(i);
     return c_freq_range;
 }
 
@@ -161,8 +202,7 @@ std::pair<dccl::arith::Model::symbol_type, dccl::arith::Model::symbol_type>
 dccl::arith::Model::cumulative_freq_to_symbol(std::pair<freq_type, freq_type> c_freq_pair,
                                               ModelState state) const
 {
-    const auto& c_freqs =
-        (state == ENCODER) ? encoder_cumulative_freqs_ : decoder_cumulative_freqs_;
+    const Frequencies& f = freqs(state);
 
     std::pair<symbol_type, symbol_type> symbol_pair;
 
@@ -173,19 +213,12 @@ dccl::arith::Model::cumulative_freq_to_symbol(std::pair<freq_type, freq_type> c_
     // symbol: 2   freq: 10   c_freq: 35 [25 ... 35)
     // searching for c_freq of 30 should return symbol 2
     // searching for c_freq of 10 should return symbol 1
-    auto search = c_freq_pair.first;
-    for (const auto& p : c_freqs)
-    {
-        if (search < p.second)
-        {
-            symbol_pair.first = p.first;
-            break;
-        }
-    }
+    std::size_t i = std::min(f.find(c_freq_pair.first), f.size() - 1);
+    symbol_pair.first = static_cast<symbol_type>(i) + MIN_SYMBOL;
 
-    if (symbol_pair.first == c_freqs.rbegin()->first)
+    if (i == f.size() - 1)
         symbol_pair.second = symbol_pair.first; // last symbol can't be ambiguous on the low end
-    else if (c_freqs.find(symbol_pair.first)->second > c_freq_pair.second)
+    else if (f.cumulative(i) > c_freq_pair.second)
         symbol_pair.second = symbol_pair.first; // unambiguously this symbol
     else
         symbol_pair.second = symbol_pair.first + 1;
@@ -198,40 +231,121 @@ void dccl::arith::Model::update_model(symbol_type symbol, ModelState state)
     if (!user_model_.is_adaptive())
         return;
 
-    auto& c_freqs = (state == ENCODER) ? encoder_cumulative_freqs_ : decoder_cumulative_freqs_;
+    Frequencies& f = freqs(state);
 
     if (dlog.check(DEBUG3))
     {
         dlog.is(DEBUG3) && dlog << "Model was: " << std::endl;
         for (symbol_type i = MIN_SYMBOL, n = max_symbol(); i <= n; ++i)
+            dlog.is(DEBUG3) && dlog << "Symbol: " << i << ", c_freq: " << f.cumulative(index(i))
+                                    << std::endl;
+    }
+
+    f.increment(index(symbol));
+
+    if (dlog.check(DEBUG3))
+    {
+        dlog.is(DEBUG3) && dlog << "Model is now: " << std::endl;
+        for (symbol_type i = MIN_SYMBOL, n = max_symbol(); i <= n; ++i)
+            dlog.is(DEBUG3) && dlog << "Symbol: " << i << ", c_freq: " << f.cumulative(index(i))
+                                    << std::endl;
+    }
+
+    dlog.is(DEBUG3) && dlog << "total freq: " << total_freq(state) << std::endl;
+}
+
+void dccl::arith::Model::Frequencies::assign(const std::vector<freq_type>& freqs, bool adaptive)
+{
+    adaptive_ = adaptive;
+    freqs_ = freqs;
+    total_ = 0;
+    cumulative_.clear();
+    tree_.clear();
+    tree_mask_ = 0;
+    lookup_.clear();
+
+    if (!adaptive_)
+    {
+        cumulative_.reserve(freqs_.size());
+        for (freq_type freq : freqs_)
+        {
+            total_ += freq;
+            cumulative_.push_back(total_);
+        }
+
+        // about 2^LOOKUP_BITS table entries, so each covers a small fraction of the total
+        const unsigned LOOKUP_BITS = 10;
+        lookup_shift_ = 0;
+        while ((total_ >> lookup_shift_) > (1u << LOOKUP_BITS)) ++lookup_shift_;
+
+        std::size_t buckets = (total_ >> lookup_shift_) + 1;
+        lookup_.resize(buckets + 1);
+        std::size_t index = 0;
+        for (std::size_t b = 0; b <= buckets; ++b)
+        {
+            uint64 c_freq = static_cast<uint64>(b) << lookup_shift_;
+            while (index < cumulative_.size() && cumulative_[index] <= c_freq) ++index;
+            lookup_[b] = index;
+        }
+    }
+    else
+    {
+        // O(n) construction: each node passes its sum on to its parent
+        tree_.assign(freqs_.size() + 1, 0);
+        for (std::size_t i = 1, n = freqs_.size(); i <= n; ++i)
         {
-            auto it = c_freqs.find(i);
-            if (it != c_freqs.end())
-                dlog.is(DEBUG3) && dlog << "Symbol: " << it->first << ", c_freq: " << it->second
-                                        << std::endl;
+            tree_[i] += freqs_[i - 1];
+            total_ += freqs_[i - 1];
+            std::size_t parent = i + (i & -i);
+            if (parent <= n)
+                tree_[parent] += tree_[i];
         }
+
+        tree_mask_ = 1;
+        while ((tree_mask_ << 1) <= freqs_.size()) tree_mask_ <<= 1;
     }
+}
+
+dccl::arith::Model::freq_type dccl::arith::Model::Frequencies::cumulative(std::size_t index) const
+{
+    if (!adaptive_)
+        return cumulative_[index];
+
+    freq_type sum = 0;
+    for (std::size_t i = index + 1; i > 0; i -= (i & -i)) sum += tree_[i];
+    return sum;
+}
 
-    for (symbol_type i = max_symbol(), n = symbol; i >= n; --i)
+std::size_t dccl::arith::Model::Frequencies::find(freq_type c_freq) const
+{
+    if (!adaptive_)
     {
-        auto it = c_freqs.find(i);
-        if (it != c_freqs.end())
-            ++it->second;
+        // the symbol is between the first symbols of this and the next table entry
+        std::size_t b = std::min<std::size_t>(c_freq >> lookup_shift_, lookup_.size() - 2);
+        auto first = cumulative_.begin() + lookup_[b];
+        auto last =
+            cumulative_.begin() + std::min<std::size_t>(lookup_[b + 1] + 1, cumulative_.size());
+        return std::upper_bound(first, last, c_freq) - cumulative_.begin();
     }
 
-    if (dlog.check(DEBUG3))
+    // descend the tree, keeping the largest position whose prefix sum is <= c_freq
+    std::size_t pos = 0;
+    for (std::size_t step = tree_mask_; step > 0; step >>= 1)
     {
-        dlog.is(DEBUG3) && dlog << "Model is now: " << std::endl;
-        for (symbol_type i = MIN_SYMBOL, n = max_symbol(); i <= n; ++i)
+        if (pos + step < tree_.size() && tree_[pos + step] <= c_freq)
         {
-            auto it = c_freqs.find(i);
-            if (it != c_freqs.end())
-                dlog.is(DEBUG3) && dlog << "Symbol: " << it->first << ", c_freq: " << it->second
-                                        << std::endl;
+            pos += step;
+            c_freq -= tree_[pos];
         }
     }
+    return pos;
+}
 
-    dlog.is(DEBUG3) && dlog << "total freq: " << total_freq(state) << std::endl;
+void dccl::arith::Model::Frequencies::increment(std::size_t index)
+{
+    ++freqs_[index];
+    ++total_;
+    for (std::size_t i = index + 1; i < tree_.size(); i += (i & -i)) ++tree_[i];
 }
 
 void dccl::arith::ModelManager::set_model(dccl::Codec& codec,
@@ -73,16 +73,6 @@ class Model
 
     static constexpr freq_type MAX_FREQUENCY = (1 << FREQUENCY_BITS) - 1;
 
-#if DCCL_THREAD_SUPPORT
-    static std::recursive_mutex last_bits_map_mutex;
-#define LOCK_LAST_BITS_MAP_MUTEX \
-    std::lock_guard<std::recursive_mutex> l(dccl::arith::Model::last_bits_map_mutex);
-#else
-#define LOCK_LAST_BITS_MAP_MUTEX
-#endif
-    // maps message name -> map of field name -> last size (bits)
-    static std::map<std::string, std::map<std::string, Bitset>> last_bits_map;
-
     Model(protobuf::ArithmeticModel user) : user_model_(std::move(user)) {}
 
     enum ModelState
@@ -95,20 +85,14 @@ class Model
     value_type symbol_to_value(symbol_type symbol) const;
     symbol_type total_symbols() // EOF and OUT_OF_RANGE plus all user defined
     {
-        return encoder_cumulative_freqs_.size();
+        return encoder_freqs_.size();
     }
 
     const protobuf::ArithmeticModel& user_model() const { return user_model_; }
 
     symbol_type max_symbol() const { return user_model_.frequency_size() - 1; }
 
-    freq_type total_freq(ModelState state) const
-    {
-        const auto& c_freqs =
-            (state == ENCODER) ? encoder_cumulative_freqs_ : decoder_cumulative_freqs_;
-
-        return c_freqs.at(max_symbol());
-    }
+    freq_type total_freq(ModelState state) const { return freqs(state).total(); }
 
     void update_model(symbol_type symbol, ModelState state);
 
@@ -120,14 +104,74 @@ class Model
     friend class ModelManager;
 
   private:
+    /// \brief Frequencies of the symbols [MIN_SYMBOL, max_symbol()], stored contiguously by (symbol - MIN_SYMBOL)
+    ///
+    /// Static models keep a plain cumulative frequency array, plus a lookup table from the (scaled) cumulative frequency to the first symbol it could belong to, so finding a symbol is a table index followed by a search of (typically) one or two entries. Adaptive models keep a Fenwick (binary indexed) tree instead so that updating the frequency of a symbol is also O(log n).
+    class Frequencies
+    {
+      public:
+        void assign(const std::vector<freq_type>& freqs, bool adaptive);
+
+        std::size_t size() const { return freqs_.size(); }
+        freq_type total() const { return total_; }
+        freq_type freq(std::size_t index) const { return freqs_[index]; }
+
+        /// \brief Sum of the frequencies of [0, index]
+        freq_type cumulative(std::size_t index) const;
+        /// \brief Smallest index whose cumulative() frequency is greater than c_freq
+        std::size_t find(freq_type c_freq) const;
+        /// \brief Add one to the frequency of index (adaptive only)
+        void increment(std::size_t index);
+
+      private:
+        bool adaptive_{false};
+        freq_type total_{0};
+        std::vector<freq_type> freqs_;
+        // static: cumulative_[i] = sum of freqs_[0, i]
+        std::vector<freq_type> cumulative_;
+        // static: lookup_[b] = find(b << lookup_shift_)
+        std::vector<std::uint32_t> lookup_;
+        unsigned lookup_shift_{0};
+        // adaptive: one-based Fenwick tree of freqs_
+        std::vector<freq_type> tree_;
+        // largest power of two <= size() (for searching tree_)
+        std::size_t tree_mask_{0};
+    };
+
+    const Frequencies& freqs(ModelState state) const
+    {
+        return (state == ENCODER) ? encoder_freqs_ : decoder_freqs_;
+    }
+    Frequencies& freqs(ModelState state)
+    {
+        return (state == ENCODER) ? encoder_freqs_ : decoder_freqs_;
+    }
+
+    static std::size_t index(symbol_type symbol) { return symbol - MIN_SYMBOL; }
+
+    // precompute the lookups for the (validated) user model
+    void compile();
+
     protobuf::ArithmeticModel user_model_;
-    std::map<symbol_type, freq_type> encoder_cumulative_freqs_;
-    std::map<symbol_type, freq_type> decoder_cumulative_freqs_;
+    // `value_bound` is (close to) evenly spaced by bound_step_, so value_to_symbol() can compute the symbol rather than search for it
+    bool uniform_bounds_{false};
+    value_type bound_step_{0};
+    Frequencies encoder_freqs_;
+    Frequencies decoder_freqs_;
 };
 
 class ModelManager
 {
   public:
+    /// \brief Bits last encoded for each field with (dccl.field).arithmetic.debug_assert set, checked against the bits consumed when decoding
+    struct DebugBits
+    {
+#if DCCL_THREAD_SUPPORT
+        std::mutex mutex;
+#endif
+        std::map<const google::protobuf::FieldDescriptor*, Bitset> last_bits;
+    };
+
     static void set_model(dccl::Codec& codec, const protobuf::ArithmeticModel& model);
 
     Model& find(const std::string& name)
@@ -139,6 +183,20 @@ class ModelManager
             return it->second;
     }
 
+    /// \brief Allocate the DebugBits (called when loading a field that uses debug_assert, so that fields without it never need them)
+    void enable_debug_bits()
+    {
+        if (!debug_bits_)
+            debug_bits_ = std::make_shared<DebugBits>();
+    }
+
+    DebugBits& debug_bits()
+    {
+        if (!debug_bits_)
+            throw(Exception("debug_assert used by a field that has not been loaded"));
+        return *debug_bits_;
+    }
+
   private:
     void _set_model(const protobuf::ArithmeticModel& model)
     {
@@ -157,7 +215,7 @@ class ModelManager
                             "Missing fields: " + model->user_model_.InitializationErrorString()));
         }
 
-        Model::freq_type cumulative_freq = 0;
+        std::vector<Model::freq_type> freqs;
         for (Model::symbol_type symbol = Model::MIN_SYMBOL, n = model->user_model_.frequency_size();
              symbol < n; ++symbol)
         {
@@ -174,12 +232,12 @@ class ModelManager
                 throw(Exception("Invalid model: " + model->user_model_.DebugString() +
                                 "All frequencies must be nonzero."));
             }
-            cumulative_freq += freq;
-            model->encoder_cumulative_freqs_.insert(std::make_pair(symbol, cumulative_freq));
+            freqs.push_back(freq);
         }
 
+        model->encoder_freqs_.assign(freqs, model->user_model_.is_adaptive());
         // must have separate models for adaptive encoding.
-        model->decoder_cumulative_freqs_ = model->encoder_cumulative_freqs_;
+        model->decoder_freqs_ = model->encoder_freqs_;
 
         if (model->total_freq(Model::ENCODER) > Model::MAX_FREQUENCY)
         {
@@ -204,10 +262,13 @@ class ModelManager
             throw(Exception("Invalid model: " + model->user_model_.DebugString() +
                             "`value_bound` must be monotonically increasing."));
         }
+
+        model->compile();
     }
 
   private:
     std::map<std::string, Model> arithmetic_models_;
+    std::shared_ptr<DebugBits> debug_bits_;
 };
 
 template <typename FieldType = Model::value_type>
@@ -236,6 +297,7 @@ class ArithmeticFieldCodecBase : public RepeatedTypedFieldCodec<Model::value_typ
         uint64 high = TOP_VALUE; // highest code value (1.0 in decimal version)
         int bits_to_follow = 0;  // bits to follow with after expanding around half
         Bitset bits;
+        BufferedBitWriter writer(&bits);
 
         for (unsigned value_index = 0, n = max_repeat(); value_index < n; ++value_index)
         {
@@ -312,14 +374,14 @@ class ArithmeticFieldCodecBase : public RepeatedTypedFieldCodec<Model::value_typ
             {
                 if (high < HALF)
                 {
-                    bit_plus_follow(&bits, &bits_to_follow, 0);
+                    bit_plus_follow(&writer, &bits_to_follow, 0);
                     dlog.is(DEBUG3) &&
                         dlog << "(ArithmeticFieldCodec): completely in [0, 0.5): EXPAND"
                              << std::endl;
                 }
                 else if (low >= HALF)
                 {
-                    bit_plus_follow(&bits, &bits_to_follow, 1);
+                    bit_plus_follow(&writer, &bits_to_follow, 1);
                     low -= HALF;
                     high -= HALF;
                     dlog.is(DEBUG3) &&
@@ -368,13 +430,13 @@ class ArithmeticFieldCodecBase : public RepeatedTypedFieldCodec<Model::value_typ
         if (low == 0) // high must be greater than half
         {
             if (high != TOP_VALUE || bits_to_follow > 0)
-                bit_plus_follow(&bits, &bits_to_follow, 0);
+                bit_plus_follow(&writer, &bits_to_follow, 0);
         }
         // 0    .     .     .     1
         //       |                | -- output a single 1
         else if (high == TOP_VALUE) // 0 < low < half
         {
-            bit_plus_follow(&bits, &bits_to_follow, 1);
+            bit_plus_follow(&writer, &bits_to_follow, 1);
         }
         // 0    .     .     .     1
         //     |           |        -- output 01
@@ -382,34 +444,75 @@ class ArithmeticFieldCodecBase : public RepeatedTypedFieldCodec<Model::value_typ
         else
         {
             bits_to_follow += 1;
-            bit_plus_follow(&bits, &bits_to_follow, (low < FIRST_QTR) ? 0 : 1);
+            bit_plus_follow(&writer, &bits_to_follow, (low < FIRST_QTR) ? 0 : 1);
         }
+        writer.flush();
 
         if (FieldCodecBase::dccl_field_options().GetExtension(arithmetic).debug_assert())
         {
-            LOCK_LAST_BITS_MAP_MUTEX
+            ModelManager::DebugBits& debug_bits = model_manager().debug_bits();
+#if DCCL_THREAD_SUPPORT
+            std::lock_guard<std::mutex> l(debug_bits.mutex);
+#endif
             // bit of a hack so I can get at the exact bit field sizes
-            Model::last_bits_map[FieldCodecBase::this_descriptor()->full_name()]
-                                [FieldCodecBase::this_field()->name()] = bits;
+            debug_bits.last_bits[FieldCodecBase::this_field()] = bits;
         }
 
         return bits;
     }
 
-    void bit_plus_follow(Bitset* bits, int* bits_to_follow, bool bit)
+    /// \brief Collects the output bits of the encoder in a word, which is written to the Bitset once full (or on flush())
+    class BufferedBitWriter
+    {
+      public:
+        explicit BufferedBitWriter(Bitset* bits) : writer_(bits) {}
+
+        /// \brief Write `count` copies of `bit`
+        void write(bool bit, int count)
+        {
+            while (count > 0)
+            {
+                int n = std::min(count, WORD_BITS - buffered_);
+                if (bit)
+                    buffer_ |= ((n == WORD_BITS) ? ~uint64(0) : ((uint64(1) << n) - 1))
+                               << buffered_;
+                buffered_ += n;
+                count -= n;
+                if (buffered_ == WORD_BITS)
+                    flush();
+            }
+        }
+
+        /// \brief Write any buffered bits to the Bitset
+        void flush()
+        {
+            writer_.write(buffer_, buffered_);
+            buffer_ = 0;
+            buffered_ = 0;
+        }
+
+      private:
+        static constexpr int WORD_BITS = std::numeric_limits<uint64>::digits;
+        BitWriter writer_;
+        uint64 buffer_{0};
+        int buffered_{0};
+    };
+
+    void bit_plus_follow(BufferedBitWriter* writer, int* bits_to_follow, bool bit)
     {
-        bits->push_back(bit);
+        writer->write(bit, 1);
         dccl::dlog.is(dccl::logger::DEBUG3) &&
             dccl::dlog << "(ArithmeticFieldCodec): emitted bit: " << bit << std::endl;
 
-        while (*bits_to_follow)
+        if (*bits_to_follow)
         {
             dccl::dlog.is(dccl::logger::DEBUG3) &&
-                dccl::dlog << "(ArithmeticFieldCodec): emitted bit (from follow): " << !bit
-                           << std::endl;
+                dccl::dlog << "(ArithmeticFieldCodec): emitted " << *bits_to_follow
+                           << " bits (from follow): " << !bit << std::endl;
 
-            bits->push_back(!bit);
-            (*bits_to_follow) -= 1;
+            // all the pending follow bits are the same, so write them in one go
+            writer->write(!bit, *bits_to_follow);
+            *bits_to_follow = 0;
         }
     }
 
@@ -429,12 +532,12 @@ class ArithmeticFieldCodecBase : public RepeatedTypedFieldCodec<Model::value_typ
         // there are `bit_stream_offset` zeros in the lower bits of `value`
         int bit_stream_offset = Model::CODE_VALUE_BITS - bits->size();
 
-        for (int i = 0, n = Model::CODE_VALUE_BITS; i < n; ++i)
-        {
-            if (i >= bit_stream_offset)
-                value |=
-                    (static_cast<uint64>((*bits)[bits->size() - (i - bit_stream_offset) - 1]) << i);
-        }
+        // fill the code register with (up to) the first CODE_VALUE_BITS bits in one read:
+        // the first bit of the stream is the most significant bit of `value`
+        Bitset::size_type initial_bits =
+            std::min<Bitset::size_type>(bits->size(), Model::CODE_VALUE_BITS);
+        if (initial_bits)
+            value = reverse_code_bits(bits->read_bits(0, initial_bits));
 
         dlog.is(DEBUG3) && dlog << "(ArithmeticFieldCodec): starting value: "
                                 << Bitset(Model::CODE_VALUE_BITS, value).to_string() << std::endl;
@@ -499,10 +602,12 @@ class ArithmeticFieldCodecBase : public RepeatedTypedFieldCodec<Model::value_typ
         // for debugging / testing
         if (FieldCodecBase::dccl_field_options().GetExtension(arithmetic).debug_assert())
         {
-            LOCK_LAST_BITS_MAP_MUTEX
+            ModelManager::DebugBits& debug_bits = model_manager().debug_bits();
+#if DCCL_THREAD_SUPPORT
+            std::lock_guard<std::mutex> l(debug_bits.mutex);
+#endif
             // must consume same bits as encoded makes
-            Bitset in = Model::last_bits_map[FieldCodecBase::this_descriptor()->full_name()]
-                                            [FieldCodecBase::this_field()->name()];
+            Bitset in = debug_bits.last_bits[FieldCodecBase::this_field()];
 
             dlog.is(DEBUG3) && dlog << "(ArithmeticFieldCodec) bits used is (" << bits->size()
                                     << "):     " << *bits << std::endl;
@@ -610,6 +715,8 @@ class ArithmeticFieldCodecBase : public RepeatedTypedFieldCodec<Model::value_typ
         try
         {
             model_manager().find(model_name);
+            if (FieldCodecBase::dccl_field_options().GetExtension(arithmetic).debug_assert())
+                model_manager().enable_debug_bits();
         }
         catch (Exception& e)
         {
@@ -673,6 +780,18 @@ class ArithmeticFieldCodecBase : public RepeatedTypedFieldCodec<Model::value_typ
         return 0;
     }
 
+    // reverse the order of the lower CODE_VALUE_BITS (32) bits
+    static uint64 reverse_code_bits(uint64 v)
+    {
+        static_assert(Model::CODE_VALUE_BITS == 32, "reverse_code_bits assumes 32 bit code values");
+        v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+        v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+        v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
+        v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+        v = ((v >> 16) & 0x0000FFFF) | ((v & 0x0000FFFF) << 16);
+        return v;
+    }
+
     dccl::int32 max_repeat()
     {
         return FieldCodecBase::this_field()->is_repeated()
@@ -695,8 +814,9 @@ template <typename FieldType> const uint64 ArithmeticFieldCodecBase<FieldType>::
 template <typename FieldType> const uint64 ArithmeticFieldCodecBase<FieldType>::HALF;
 template <typename FieldType> const uint64 ArithmeticFieldCodecBase<FieldType>::THIRD_QTR;
 
-template <typename FieldType>
-class ArithmeticFieldCodec : public ArithmeticFieldCodecBase<FieldType>
+/// \brief Arithmetic coded field of type FieldType (CodecBase selects the entropy coder, see also RangeFieldCodecBase)
+template <typename FieldType, template <typename> class CodecBase = ArithmeticFieldCodecBase>
+class ArithmeticFieldCodec : public CodecBase<FieldType>
 {
     Model::value_type pre_encode(const FieldType& field_value) override
     {
@@ -709,9 +829,9 @@ class ArithmeticFieldCodec : public ArithmeticFieldCodecBase<FieldType>
     }
 };
 
-template <>
-class ArithmeticFieldCodec<const google::protobuf::EnumValueDescriptor*>
-    : public ArithmeticFieldCodecBase<const google::protobuf::EnumValueDescriptor*>
+template <template <typename> class CodecBase>
+class ArithmeticFieldCodec<const google::protobuf::EnumValueDescriptor*, CodecBase>
+    : public CodecBase<const google::protobuf::EnumValueDescriptor*>
 {
   public:
     Model::value_type
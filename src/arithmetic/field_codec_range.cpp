@@ -0,0 +1,114 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include "field_codec_range.h"
+
+namespace
+{
+// the range is renormalized (shifted by a byte) whenever it falls below this
+constexpr dccl::uint32 RANGE_BOTTOM = 1u << 24;
+} // namespace
+
+void dccl::arith::RangeEncoder::encode(Model::freq_type start, Model::freq_type size,
+                                       Model::freq_type total)
+{
+    uint32 scale = range_ / total;
+    low_ += static_cast<uint64>(scale) * start;
+    range_ = scale * size;
+
+    while (range_ < RANGE_BOTTOM)
+    {
+        range_ <<= 8;
+        shift_low();
+    }
+}
+
+std::string dccl::arith::RangeEncoder::finish()
+{
+    // pick the value in [low, low + range) that has the most trailing zero bytes
+    for (int kept_bytes = 0; kept_bytes <= 4; ++kept_bytes)
+    {
+        uint64 mask =
+            (kept_bytes == 4) ? 0 : ((static_cast<uint64>(1) << (32 - 8 * kept_bytes)) - 1);
+        uint64 value = (low_ + mask) & ~mask;
+        if (value < low_ + range_)
+        {
+            low_ = value;
+            break;
+        }
+    }
+
+    for (int i = 0; i < 5; ++i) shift_low();
+
+    // the decoder reads zeros past the end of the data
+    while (!bytes_.empty() && bytes_.back() == 0) bytes_.pop_back();
+    return bytes_;
+}
+
+void dccl::arith::RangeEncoder::shift_low()
+{
+    // the top byte can only be output once we know it cannot be changed by a carry
+    if (static_cast<uint32>(low_) < 0xFF000000u || (low_ >> 32) != 0)
+    {
+        auto carry = static_cast<unsigned char>(low_ >> 32);
+        unsigned char byte = cache_;
+        do
+        {
+            emit(byte + carry);
+            byte = 0xFF;
+        } while (--cache_size_ != 0);
+        cache_ = static_cast<unsigned char>(low_ >> 24);
+    }
+    ++cache_size_;
+    low_ = (low_ & 0x00FFFFFF) << 8;
+}
+
+void dccl::arith::RangeEncoder::emit(unsigned char byte)
+{
+    if (first_byte_)
+        first_byte_ = false;
+    else
+        bytes_.push_back(static_cast<char>(byte));
+}
+
+dccl::arith::RangeDecoder::RangeDecoder(const std::string& bytes) : bytes_(bytes)
+{
+    for (int i = 0; i < 4; ++i) code_ = (code_ << 8) | next_byte();
+}
+
+dccl::arith::Model::freq_type dccl::arith::RangeDecoder::get_freq(Model::freq_type total)
+{
+    scale_ = range_ / total;
+    return std::min<uint32>(code_ / scale_, total - 1);
+}
+
+void dccl::arith::RangeDecoder::decode(Model::freq_type start, Model::freq_type size)
+{
+    code_ -= scale_ * start;
+    range_ = scale_ * size;
+
+    while (range_ < RANGE_BOTTOM)
+    {
+        code_ = (code_ << 8) | next_byte();
+        range_ <<= 8;
+    }
+}
@@ -0,0 +1,290 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// The range coder follows the carry-propagating byte-oriented design of G. N. N. Martin, "Range encoding: an algorithm for removing redundancy from a digitised message," 1979 (as used by LZMA)
+
+#ifndef DCCLFIELDCODECRANGE20231017H
+#define DCCLFIELDCODECRANGE20231017H
+
+#include <string>
+
+#include "field_codec_arithmetic.h"
+
+namespace dccl
+{
+namespace arith
+{
+/// \brief Byte-oriented range encoder (32-bit range, 64-bit low with carry propagation)
+class RangeEncoder
+{
+  public:
+    /// \brief Narrow the range to [start, start + size) out of total (total must be <= 2^16)
+    void encode(Model::freq_type start, Model::freq_type size, Model::freq_type total);
+
+    /// \brief Flush the encoder and return the encoded bytes
+    ///
+    /// The final value is chosen to end in as many zero bytes as possible, and trailing zero bytes are not returned (RangeDecoder reads zeros past the end of its input).
+    std::string finish();
+
+  private:
+    void shift_low();
+    void emit(unsigned char byte);
+
+  private:
+    uint64 low_{0};
+    uint32 range_{0xFFFFFFFF};
+    unsigned char cache_{0};
+    uint64 cache_size_{1};
+    // the first byte emitted is always zero (the code value is always < 1) so it is not stored
+    bool first_byte_{true};
+    std::string bytes_;
+};
+
+/// \brief Decoder for the bytes produced by RangeEncoder
+class RangeDecoder
+{
+  public:
+    RangeDecoder(const std::string& bytes);
+
+    /// \brief Cumulative frequency (out of total) of the current code value. Must be followed by a call to decode()
+    Model::freq_type get_freq(Model::freq_type total);
+
+    /// \brief Remove the symbol [start, start + size) found using get_freq()
+    void decode(Model::freq_type start, Model::freq_type size);
+
+  private:
+    unsigned char next_byte() { return pos_ < bytes_.size() ? bytes_[pos_++] : 0; }
+
+  private:
+    const std::string& bytes_;
+    std::string::size_type pos_{0};
+    uint32 code_{0};
+    uint32 range_{0xFFFFFFFF};
+    // range_ / total from the last get_freq()
+    uint32 scale_{1};
+};
+
+/// \brief Range coded alternative to ArithmeticFieldCodecBase using the same models (see ModelManager::set_model)
+///
+/// Encodes the symbols with a byte-oriented range coder, which is considerably faster than the bitwise arithmetic coder for large repeated fields at almost the same compression ratio. The encoded field is the number of bytes of range coded data (using enough bits for the largest possible number of bytes) followed by those bytes. The total frequency of the model must not exceed MAX_FREQUENCY (adaptive models stop adapting once they reach it).
+template <typename FieldType = Model::value_type>
+class RangeFieldCodecBase : public ArithmeticFieldCodecBase<FieldType>
+{
+  public:
+    /// \brief Largest total frequency supported, keeping the precision lost to the integer range division below 0.01 bits per symbol
+    static constexpr Model::freq_type MAX_FREQUENCY = 1 << 16;
+
+    using ArithmeticFieldCodecBase<FieldType>::current_model;
+    using ArithmeticFieldCodecBase<FieldType>::max_repeat;
+    using ArithmeticFieldCodecBase<FieldType>::model_manager;
+
+    Bitset encode_repeated(const std::vector<Model::value_type>& wire_value) override
+    {
+        return encode_range(wire_value, true);
+    }
+
+    Bitset encode_range(const std::vector<Model::value_type>& wire_value, bool update_model)
+    {
+        using dccl::dlog;
+        using namespace dccl::logger;
+        Model& model = current_model();
+
+        RangeEncoder encoder;
+        for (unsigned value_index = 0, n = max_repeat(); value_index < n; ++value_index)
+        {
+            Model::symbol_type symbol = Model::EOF_SYMBOL;
+            if (wire_value.size() > value_index)
+                symbol = model.value_to_symbol(wire_value[value_index]);
+
+            // if out-of-range is given no frequency, end encoding
+            if (symbol == Model::OUT_OF_RANGE_SYMBOL &&
+                model.user_model().out_of_range_frequency() == 0)
+                symbol = Model::EOF_SYMBOL;
+
+            // if EOF_SYMBOL is given no frequency, fill with the most probable symbol
+            if (symbol == Model::EOF_SYMBOL && model.user_model().eof_frequency() == 0)
+                symbol = most_probable_symbol(model);
+
+            std::pair<Model::freq_type, Model::freq_type> c_freq_range =
+                model.symbol_to_cumulative_freq(symbol, Model::ENCODER);
+
+            dlog.is(DEBUG3) && dlog << "(RangeFieldCodec) symbol (" << symbol
+                                    << ") cumulative freq: [" << c_freq_range.first << ","
+                                    << c_freq_range.second << ")" << std::endl;
+
+            encoder.encode(c_freq_range.first, c_freq_range.second - c_freq_range.first,
+                           model.total_freq(Model::ENCODER));
+
+            if (update_model && model.total_freq(Model::ENCODER) < MAX_FREQUENCY)
+                model.update_model(symbol, Model::ENCODER);
+
+            if (symbol == Model::EOF_SYMBOL)
+                break;
+        }
+
+        std::string bytes = encoder.finish();
+        if (bytes.size() > max_bytes())
+            throw(Exception("Range coded field is larger than its maximum size (" +
+                            std::to_string(bytes.size()) + " > " + std::to_string(max_bytes()) +
+                            " bytes)"));
+
+        Bitset bits;
+        BitWriter writer(&bits);
+        writer.write(bytes.size(), count_size());
+        writer.write_bytes(bytes);
+
+        dlog.is(DEBUG3) && dlog << "(RangeFieldCodec) encoded " << bytes.size()
+                                << " bytes: " << hex_encode(bytes) << std::endl;
+
+        if (FieldCodecBase::dccl_field_options().GetExtension(arithmetic).debug_assert())
+        {
+            ModelManager::DebugBits& debug_bits = model_manager().debug_bits();
+#if DCCL_THREAD_SUPPORT
+            std::lock_guard<std::mutex> l(debug_bits.mutex);
+#endif
+            debug_bits.last_bits[FieldCodecBase::this_field()] = bits;
+        }
+
+        return bits;
+    }
+
+    std::vector<Model::value_type> decode_repeated(Bitset* bits) override
+    {
+        using dccl::dlog;
+        using namespace dccl::logger;
+        Model& model = current_model();
+
+        // `bits` starts with min_size_repeated() == count_size() bits
+        unsigned count_bits = count_size();
+        auto num_bytes = static_cast<unsigned>(bits->read_bits(0, count_bits));
+        if (num_bytes > max_bytes())
+            throw(Exception("Range coded field has more bytes than its maximum size"));
+        bits->get_more_bits(num_bytes * BITS_IN_BYTE);
+
+        std::string bytes(num_bytes, 0);
+        for (unsigned i = 0; i < num_bytes; ++i)
+            bytes[i] = static_cast<char>(bits->read_bits(count_bits + i * BITS_IN_BYTE, 8));
+
+        std::vector<Model::value_type> values;
+        RangeDecoder decoder(bytes);
+        for (unsigned value_index = 0, n = max_repeat(); value_index < n; ++value_index)
+        {
+            Model::freq_type c_freq = decoder.get_freq(model.total_freq(Model::DECODER));
+            Model::symbol_type symbol =
+                model.cumulative_freq_to_symbol(std::make_pair(c_freq, c_freq), Model::DECODER)
+                    .first;
+
+            std::pair<Model::freq_type, Model::freq_type> c_freq_range =
+                model.symbol_to_cumulative_freq(symbol, Model::DECODER);
+            decoder.decode(c_freq_range.first, c_freq_range.second - c_freq_range.first);
+
+            dlog.is(DEBUG3) && dlog << "(RangeFieldCodec) symbol is: " << symbol << std::endl;
+
+            if (model.total_freq(Model::DECODER) < MAX_FREQUENCY)
+                model.update_model(symbol, Model::DECODER);
+
+            if (symbol == Model::EOF_SYMBOL)
+                break;
+
+            values.push_back(model.symbol_to_value(symbol));
+        }
+
+        if (FieldCodecBase::dccl_field_options().GetExtension(arithmetic).debug_assert())
+        {
+            ModelManager::DebugBits& debug_bits = model_manager().debug_bits();
+#if DCCL_THREAD_SUPPORT
+            std::lock_guard<std::mutex> l(debug_bits.mutex);
+#endif
+            // must consume same bits as encoded makes
+            assert(debug_bits.last_bits[FieldCodecBase::this_field()] == *bits);
+        }
+
+        return values;
+    }
+
+    unsigned size_repeated(const std::vector<Model::value_type>& wire_values) override
+    {
+        return encode_range(wire_values, false).size();
+    }
+
+    unsigned max_size_repeated() override { return count_size() + max_bytes() * BITS_IN_BYTE; }
+
+    unsigned min_size_repeated() override { return count_size(); }
+
+    void validate() override
+    {
+        ArithmeticFieldCodecBase<FieldType>::validate();
+
+        FieldCodecBase::require(current_model().total_freq(Model::ENCODER) <= MAX_FREQUENCY,
+                                "sum of all frequencies in (dccl.field).arithmetic.model must "
+                                "not exceed " +
+                                    std::to_string(MAX_FREQUENCY) + " for the range coder");
+    }
+
+  private:
+    // upper bound on the number of bytes produced by RangeEncoder::finish()
+    unsigned max_bytes()
+    {
+        using dccl::log2;
+        Model& model = current_model();
+        const protobuf::ArithmeticModel& user_model = model.user_model();
+
+        // least probable symbol that can be encoded
+        Model::freq_type lowest_freq =
+            *std::min_element(user_model.frequency().begin(), user_model.frequency().end());
+        if (user_model.eof_frequency() != 0)
+            lowest_freq = std::min(lowest_freq, user_model.eof_frequency());
+        if (user_model.out_of_range_frequency() != 0)
+            lowest_freq = std::min(lowest_freq, user_model.out_of_range_frequency());
+
+        // adaptive models can grow up to MAX_FREQUENCY (and never reduce any symbol's frequency)
+        Model::freq_type total =
+            user_model.is_adaptive() ? MAX_FREQUENCY : model.total_freq(Model::ENCODER);
+
+        // information content of each symbol plus the precision lost to the range division
+        double symbol_bits = log2(total) - log2(lowest_freq) + 0.01;
+
+        // one byte for normalizing the final range and four for flushing
+        return static_cast<unsigned>(std::ceil((max_repeat() + 1) * symbol_bits / BITS_IN_BYTE)) +
+               5;
+    }
+
+    // number of bits used to encode the number of bytes of range coded data
+    unsigned count_size() { return dccl::ceil_log2(static_cast<dccl::uint64>(max_bytes()) + 1); }
+
+    static Model::symbol_type most_probable_symbol(const Model& model)
+    {
+        const auto& freqs = model.user_model().frequency();
+        return std::max_element(freqs.begin(), freqs.end()) - freqs.begin();
+    }
+};
+
+template <typename FieldType> constexpr Model::freq_type RangeFieldCodecBase<FieldType>::MAX_FREQUENCY;
+
+/// \brief Range coded field of type FieldType
+template <typename FieldType>
+using RangeFieldCodec = ArithmeticFieldCodec<FieldType, RangeFieldCodecBase>;
+
+} // namespace arith
+} // namespace dccl
+
+#endif
@@ -26,6 +26,9 @@
 
 using namespace dccl::logger;
 
+constexpr dccl::Bitset::size_type dccl::Bitset::BITS_IN_WORD;
+constexpr dccl::Bitset::size_type dccl::Bitset::INLINE_WORDS;
+
 dccl::Bitset dccl::Bitset::relinquish_bits(size_type num_bits, bool final_child)
 {
     if (final_child || this->size() < num_bits)
@@ -41,16 +44,14 @@ dccl::Bitset dccl::Bitset::relinquish_bits(size_type num_bits, bool final_child)
     Bitset out;
     if (!final_child)
     {
-        for (size_type i = 0; i < num_bits; ++i)
-        {
-            if (this->empty())
-                throw(dccl::Exception("Cannot relinquish_bits - no more bits to give up! Check "
-                                      "that all field codecs are always producing (encode) and "
-                                      "consuming (decode) the exact same number of bits."));
+        if (num_bits > this->size())
+            throw(dccl::Exception("Cannot relinquish_bits - no more bits to give up! Check "
+                                  "that all field codecs are always producing (encode) and "
+                                  "consuming (decode) the exact same number of bits."));
 
-            out.push_back(this->front());
-            this->pop_front();
-        }
+        out.resize(num_bits);
+        out.copy_bits(*this, 0, 0, num_bits);
+        this->erase_front(num_bits);
     }
     return out;
 }
@@ -27,21 +27,141 @@
 #define DCCLBITSET20120424H
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
-#include <deque>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
 #include <string>
 
 #include "exception.h"
 
 namespace dccl
 {
-/// \brief A variable size container of bits (subclassed from std::deque<bool>) with an optional hierarchy. Similar to set::bitset but can be resized at runtime and has the ability to have parent Bitsets that can give bits to their children.
+/// \brief A variable size container of bits with an optional hierarchy. Similar to set::bitset but can be resized at runtime and has the ability to have parent Bitsets that can give bits to their children.
 ///
-/// This is the class used within DCCL hold the encoded message as it is created. The front() of the deque represents the least significant bit (lsb) and the back() is the most significant bit (msb). DCCL messages are encoded and decoded starting with the  lsb and ending at the msb. The hierarchy is used to represent parent bit pools from which the child can pull more bits from to decode. The top level Bitset represents the entire encoded message, whereas the children are the message fields.
-class Bitset : public std::deque<bool>
+/// This is the class used within DCCL hold the encoded message as it is created. The front() of the Bitset represents the least significant bit (lsb) and the back() is the most significant bit (msb). DCCL messages are encoded and decoded starting with the  lsb and ending at the msb. The hierarchy is used to represent parent bit pools from which the child can pull more bits from to decode. The top level Bitset represents the entire encoded message, whereas the children are the message fields.
+///
+/// The bits are packed into 64-bit words (stored inline for Bitsets of up to 256 bits, on the heap beyond that), so that integer conversions, shifts, append/prepend and byte string conversions operate a word at a time rather than a bit at a time.
+class Bitset
 {
   public:
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using value_type = bool;
+    using word_type = std::uint64_t;
+    using const_reference = bool;
+
+    /// \brief Proxy reference to a single bit (similar to std::vector<bool>::reference)
+    class reference
+    {
+      public:
+        reference(Bitset* bits, size_type n) : bits_(bits), n_(n) {}
+        reference(const reference&) = default;
+
+        operator bool() const { return bits_->get_bit(n_); }
+        reference& operator=(bool val)
+        {
+            bits_->set_bit(n_, val);
+            return *this;
+        }
+        reference& operator=(const reference& rhs) { return *this = static_cast<bool>(rhs); }
+        reference& operator&=(bool val) { return *this = (*this && val); }
+        reference& operator|=(bool val) { return *this = (*this || val); }
+        reference& operator^=(bool val) { return *this = (static_cast<bool>(*this) != val); }
+        bool operator~() const { return !static_cast<bool>(*this); }
+
+      private:
+        Bitset* bits_;
+        size_type n_;
+    };
+
+    /// \brief Random access iterator over the bits (lsb first)
+    template <typename BitsetType, typename Reference> class basic_iterator
+    {
+      public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = bool;
+        using difference_type = Bitset::difference_type;
+        using pointer = void;
+        using reference = Reference;
+
+        basic_iterator() = default;
+        basic_iterator(BitsetType* bits, size_type n) : bits_(bits), n_(n) {}
+        // allow iterator -> const_iterator conversion
+        template <typename OtherBitset, typename OtherReference>
+        basic_iterator(const basic_iterator<OtherBitset, OtherReference>& other)
+            : bits_(other.bits_), n_(other.n_)
+        {
+        }
+
+        reference operator*() const { return (*bits_)[n_]; }
+        reference operator[](difference_type d) const { return (*bits_)[n_ + d]; }
+
+        basic_iterator& operator++()
+        {
+            ++n_;
+            return *this;
+        }
+        basic_iterator operator++(int)
+        {
+            basic_iterator tmp(*this);
+            ++n_;
+            return tmp;
+        }
+        basic_iterator& operator--()
+        {
+            --n_;
+            return *this;
+        }
+        basic_iterator operator--(int)
+        {
+            basic_iterator tmp(*this);
+            --n_;
+            return tmp;
+        }
+        basic_iterator& operator+=(difference_type d)
+        {
+            n_ += d;
+            return *this;
+        }
+        basic_iterator& operator-=(difference_type d)
+        {
+            n_ -= d;
+            return *this;
+        }
+        basic_iterator operator+(difference_type d) const { return basic_iterator(bits_, n_ + d); }
+        basic_iterator operator-(difference_type d) const { return basic_iterator(bits_, n_ - d); }
+        difference_type operator-(const basic_iterator& rhs) const
+        {
+            return static_cast<difference_type>(n_) - static_cast<difference_type>(rhs.n_);
+        }
+
+        bool operator==(const basic_iterator& rhs) const { return n_ == rhs.n_; }
+        bool operator!=(const basic_iterator& rhs) const { return n_ != rhs.n_; }
+        bool operator<(const basic_iterator& rhs) const { return n_ < rhs.n_; }
+        bool operator>(const basic_iterator& rhs) const { return n_ > rhs.n_; }
+        bool operator<=(const basic_iterator& rhs) const { return n_ <= rhs.n_; }
+        bool operator>=(const basic_iterator& rhs) const { return n_ >= rhs.n_; }
+
+      private:
+        template <typename, typename> friend class basic_iterator;
+        BitsetType* bits_{nullptr};
+        size_type n_{0};
+    };
+
+    using iterator = basic_iterator<Bitset, reference>;
+    using const_iterator = basic_iterator<const Bitset, const_reference>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /// \brief Number of bits in each storage word
+    static constexpr size_type BITS_IN_WORD = std::numeric_limits<word_type>::digits;
+    /// \brief Number of words stored inline (without heap allocation); 4 words = 256 bits
+    static constexpr size_type INLINE_WORDS = 4;
+
     /// \brief Construct an empty Bitset.
     ///
     /// \param parent Pointer to a bitset that should be consider this Bitset's parent for calls to get_more_bits()
@@ -53,11 +173,35 @@ class Bitset : public std::deque<bool>
     /// \param value Initial value of the bits in this Bitset
     /// \param parent Pointer to a bitset that should be consider this Bitset's parent for calls to get_more_bits()
     explicit Bitset(size_type num_bits, unsigned long value = 0, Bitset* parent = nullptr)
-        : std::deque<bool>(num_bits, false), parent_(parent)
+        : parent_(parent)
     {
         from(value, num_bits);
     }
 
+    Bitset(const Bitset& rhs) : parent_(rhs.parent_) { assign_bits(rhs); }
+
+    Bitset(Bitset&& rhs) noexcept : parent_(rhs.parent_) { steal(std::move(rhs)); }
+
+    Bitset& operator=(const Bitset& rhs)
+    {
+        if (this != &rhs)
+        {
+            parent_ = rhs.parent_;
+            assign_bits(rhs);
+        }
+        return *this;
+    }
+
+    Bitset& operator=(Bitset&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            parent_ = rhs.parent_;
+            steal(std::move(rhs));
+        }
+        return *this;
+    }
+
     ~Bitset() = default;
 
     /// \brief Retrieve more bits from the parent Bitset
@@ -68,6 +212,107 @@ class Bitset : public std::deque<bool>
     /// \throw Exception The parent (and up the hierarchy, if applicable) do not have num_bits to give up.
     void get_more_bits(size_type num_bits);
 
+    /// \brief The parent Bitset used by get_more_bits() (or nullptr if none)
+    Bitset* parent() const { return parent_; }
+
+    /// \name Container methods
+    //@{
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_type max_size() const { return std::numeric_limits<size_type>::max(); }
+
+    /// \brief Store the bits directly in `buf` (not owned), laid out as by to_byte_string(), rather than in this Bitset's own storage
+    ///
+    /// Used to encode straight into a caller's buffer. This is only possible if `buf` is aligned for word_type and the host is little-endian; otherwise nothing changes and false is returned. The Bitset is cleared. Only the first ceil(size() / 8) bytes of `buf` are changed. If the Bitset outgrows the whole words of `buf`, its bits are moved into its own storage (see stored_in()). `buf` must outlive this Bitset (or the next call to store_in()).
+    /// \return true if the bits are now stored in buf
+    bool store_in(char* buf, size_t max_len)
+    {
+        const word_type one = 1;
+        bool little_endian = *reinterpret_cast<const unsigned char*>(&one) == 1;
+        if (!little_endian || max_len < sizeof(word_type) ||
+            reinterpret_cast<std::uintptr_t>(buf) % alignof(word_type) != 0)
+            return false;
+
+        clear();
+        external_ = reinterpret_cast<word_type*>(buf);
+        external_capacity_ = max_len / sizeof(word_type);
+        return true;
+    }
+
+    /// \brief Whether the bits are (still) stored directly in `buf` (see store_in())
+    bool stored_in(const char* buf) const
+    {
+        return external_ && external_ == reinterpret_cast<const word_type*>(buf) && offset_ == 0;
+    }
+
+    /// \brief Remove all bits (the storage is kept for reuse)
+    void clear()
+    {
+        size_ = 0;
+        offset_ = 0;
+    }
+
+    /// \brief Resize the Bitset, setting any new (most significant) bits to value
+    void resize(size_type num_bits, bool value = false)
+    {
+        if (num_bits > size_)
+        {
+            size_type old_size = size_;
+            reserve_back(num_bits - size_);
+            size_ = num_bits;
+            fill_bits(old_size, num_bits - old_size, value);
+        }
+        else
+        {
+            size_ = num_bits;
+            if (size_ == 0)
+                offset_ = 0;
+        }
+    }
+
+    reference operator[](size_type n) { return reference(this, n); }
+    const_reference operator[](size_type n) const { return get_bit(n); }
+
+    reference front() { return (*this)[0]; }
+    const_reference front() const { return (*this)[0]; }
+    reference back() { return (*this)[size_ - 1]; }
+    const_reference back() const { return (*this)[size_ - 1]; }
+
+    /// \brief Add a bit to the big (most significant) end
+    void push_back(bool bit)
+    {
+        reserve_back(1);
+        ++size_;
+        set_bit(size_ - 1, bit);
+    }
+
+    /// \brief Add a bit to the little (least significant) end
+    void push_front(bool bit)
+    {
+        reserve_front(1);
+        --offset_;
+        ++size_;
+        set_bit(0, bit);
+    }
+
+    /// \brief Remove the most significant bit
+    void pop_back() { resize(size_ - 1); }
+
+    /// \brief Remove the least significant bit
+    void pop_front() { erase_front(1); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    //@}
+
     /// \brief Logical AND in place
     ///
     /// Apply the result of a logical AND of this Bitset and another to this Bitset.
@@ -79,7 +324,11 @@ class Bitset : public std::deque<bool>
         if (rhs.size() != size())
             throw(dccl::Exception("Bitset operator&= requires this->size() == rhs.size()"));
 
-        for (size_type i = 0; i != this->size(); ++i) (*this)[i] &= rhs[i];
+        for (size_type i = 0; i < size_; i += BITS_IN_WORD)
+        {
+            size_type n = std::min(BITS_IN_WORD, size_ - i);
+            write_bits(i, read_bits(i, n) & rhs.read_bits(i, n), n);
+        }
         return *this;
     }
 
@@ -94,7 +343,11 @@ class Bitset : public std::deque<bool>
         if (rhs.size() != size())
             throw(dccl::Exception("Bitset operator|= requires this->size() == rhs.size()"));
 
-        for (size_type i = 0; i != this->size(); ++i) (*this)[i] |= rhs[i];
+        for (size_type i = 0; i < size_; i += BITS_IN_WORD)
+        {
+            size_type n = std::min(BITS_IN_WORD, size_ - i);
+            write_bits(i, read_bits(i, n) | rhs.read_bits(i, n), n);
+        }
         return *this;
     }
 
@@ -109,7 +362,11 @@ class Bitset : public std::deque<bool>
         if (rhs.size() != size())
             throw(dccl::Exception("Bitset operator^= requires this->size() == rhs.size()"));
 
-        for (size_type i = 0; i != this->size(); ++i) (*this)[i] ^= rhs[i];
+        for (size_type i = 0; i < size_; i += BITS_IN_WORD)
+        {
+            size_type n = std::min(BITS_IN_WORD, size_ - i);
+            write_bits(i, read_bits(i, n) ^ rhs.read_bits(i, n), n);
+        }
         return *this;
     }
 
@@ -123,11 +380,17 @@ class Bitset : public std::deque<bool>
     /// \return  A reference to the resulting Bitset
     Bitset& operator<<=(size_type n)
     {
-        for (size_type i = 0; i < n; ++i)
+        if (n >= size_)
+            return reset();
+
+        // move from the most significant end down so we never overwrite unread source bits
+        for (size_type i = size_; i > n;)
         {
-            push_front(false);
-            pop_back();
+            size_type chunk = std::min(BITS_IN_WORD, i - n);
+            i -= chunk;
+            write_bits(i, read_bits(i - n, chunk), chunk);
         }
+        fill_bits(0, n, false);
         return *this;
     }
 
@@ -139,11 +402,9 @@ class Bitset : public std::deque<bool>
     /// \return  A reference to the resulting Bitset
     Bitset& operator>>=(size_type n)
     {
-        for (size_type i = 0; i < n; ++i)
-        {
-            push_back(false);
-            pop_front();
-        }
+        size_type old_size = size_;
+        erase_front(std::min(n, size_));
+        resize(old_size);
         return *this;
     }
 
@@ -174,7 +435,7 @@ class Bitset : public std::deque<bool>
     /// \return A reference to the resulting Bitset
     Bitset& set(size_type n, bool val = true)
     {
-        (*this)[n] = val;
+        set_bit(n, val);
         return *this;
     }
 
@@ -183,7 +444,7 @@ class Bitset : public std::deque<bool>
     /// \return A reference to the resulting Bitset
     Bitset& set()
     {
-        for (bool& it : *this) it = true;
+        fill_bits(0, size_, true);
         return *this;
     }
 
@@ -198,7 +459,7 @@ class Bitset : public std::deque<bool>
     /// \return A reference to the resulting Bitset
     Bitset& reset()
     {
-        for (bool& it : *this) it = false;
+        fill_bits(0, size_, false);
         return *this;
     }
 
@@ -213,7 +474,11 @@ class Bitset : public std::deque<bool>
     /// \return A reference to the resulting Bitset
     Bitset& flip()
     {
-        for (size_type i = 0, n = size(); i < n; ++i) flip(i);
+        for (size_type i = 0; i < size_; i += BITS_IN_WORD)
+        {
+            size_type n = std::min(BITS_IN_WORD, size_ - i);
+            write_bits(i, ~read_bits(i, n), n);
+        }
         return *this;
     }
 
@@ -235,13 +500,16 @@ class Bitset : public std::deque<bool>
     template <typename IntType>
     void from(IntType value, size_type num_bits = std::numeric_limits<IntType>::digits)
     {
-        this->resize(num_bits);
-        for (int i = 0, n = std::min<size_type>(std::numeric_limits<IntType>::digits, size());
-             i < n; ++i)
-        {
-            if (value & (static_cast<IntType>(1) << i))
-                (*this)[i] = true;
-        }
+        static_assert(std::numeric_limits<IntType>::digits <=
+                          std::numeric_limits<word_type>::digits,
+                      "IntType must fit in a 64-bit word");
+
+        clear();
+        resize(num_bits);
+
+        size_type n = std::min<size_type>(std::numeric_limits<IntType>::digits, size_);
+        if (n)
+            write_bits(0, static_cast<word_type>(value), n);
     }
 
     /// \brief Sets value of the Bitset to the contents of an unsigned long integer. Equivalent to from<unsigned long>()
@@ -261,14 +529,7 @@ class Bitset : public std::deque<bool>
             throw(Exception("Type IntType cannot represent current bitset (this->size() > "
                             "std::numeric_limits<IntType>::digits)"));
 
-        IntType out = 0;
-        for (int i = 0, n = size(); i < n; ++i)
-        {
-            if ((*this)[i])
-                out |= (static_cast<IntType>(1) << i);
-        }
-
-        return out;
+        return size_ ? static_cast<IntType>(read_bits(0, size_)) : IntType(0);
     }
 
     /// \brief Returns the value of the Bitset as an unsigned long integer. Equivalent to to<unsigned long>().
@@ -278,12 +539,7 @@ class Bitset : public std::deque<bool>
     std::string to_string() const
     {
         std::string s(size(), 0);
-        int i = 0;
-        for (auto it = rbegin(), n = rend(); it != n; ++it)
-        {
-            s[i] = (*it) ? '1' : '0';
-            ++i;
-        }
+        for (size_type i = 0; i < size_; ++i) s[size_ - i - 1] = get_bit(i) ? '1' : '0';
         return s;
     }
 
@@ -294,14 +550,11 @@ class Bitset : public std::deque<bool>
     /// \brief Returns the value of the Bitset to a byte string, where each character represents 8 bits of the Bitset. The string is used as a byte container, and is not intended to be printed.
     ///
     /// \return A string containing the value of the Bitset, with the least signficant byte in string[0] and the most significant byte in string[size()-1]
-    std::string to_byte_string()
+    std::string to_byte_string() const
     {
         // number of bytes needed is ceil(size() / 8)
         std::string s(this->size() / 8 + (this->size() % 8 ? 1 : 0), 0);
-
-        for (size_type i = 0, n = this->size(); i < n; ++i)
-            s[i / 8] |= static_cast<char>((*this)[i] << (i % 8));
-
+        write_bytes(&s[0], size_);
         return s;
     }
 
@@ -310,7 +563,7 @@ class Bitset : public std::deque<bool>
     /// \param max_len Maximum length of buf
     /// \return number of bytes written to buf
     /// \throw std::length_error if max_len < encoded length.
-    size_t to_byte_string(char* buf, size_t max_len)
+    size_t to_byte_string(char* buf, size_t max_len) const
     {
         // number of bytes needed is ceil(size() / 8)
         size_t len = this->size() / 8 + (this->size() % 8 ? 1 : 0);
@@ -320,12 +573,17 @@ class Bitset : public std::deque<bool>
             throw std::length_error("max_len must be >= len");
         }
 
-        // initialize buffer to all zeroes
-        std::fill_n(buf, len, 0);
-
-        for (size_type i = 0, n = this->size(); i < n; ++i)
-            buf[i / 8] |= static_cast<char>((*this)[i] << (i % 8));
-
+        if (stored_in(buf))
+        {
+            // already in place: only the unused bits of the last byte may be stale
+            if (size_ % 8)
+                buf[len - 1] = static_cast<char>(static_cast<unsigned char>(buf[len - 1]) &
+                                                 ((1u << (size_ % 8)) - 1));
+        }
+        else
+        {
+            write_bytes(buf, size_);
+        }
         return len;
     }
 
@@ -340,54 +598,467 @@ class Bitset : public std::deque<bool>
     /// \param end Iterator pointing to the end of the input bufer
     template <typename CharIterator> void from_byte_stream(CharIterator begin, CharIterator end)
     {
-        this->resize(std::distance(begin, end) * 8);
-        int i = 0;
+        clear();
+        reserve_back(std::distance(begin, end) * 8);
+
+        // pack up to eight bytes into each word
+        word_type word = 0;
+        size_type word_bits = 0;
         for (CharIterator it = begin; it != end; ++it)
         {
-            for (size_type j = 0; j < 8; ++j) (*this)[i * 8 + j] = (*it) & (1 << j);
-            ++i;
+            word |= static_cast<word_type>(static_cast<unsigned char>(*it)) << word_bits;
+            word_bits += 8;
+            if (word_bits == BITS_IN_WORD)
+            {
+                size_ += word_bits;
+                write_bits(size_ - word_bits, word, word_bits);
+                word = 0;
+                word_bits = 0;
+            }
+        }
+        if (word_bits)
+        {
+            size_ += word_bits;
+            write_bits(size_ - word_bits, word, word_bits);
         }
     }
 
     /// \brief Adds the bitset to the little end
     Bitset& prepend(const Bitset& bits)
     {
-        for (auto it = bits.rbegin(), n = bits.rend(); it != n; ++it) push_front(*it);
+        if (&bits == this)
+        {
+            Bitset copy(bits);
+            return prepend(copy);
+        }
 
+        size_type n = bits.size();
+        reserve_front(n);
+        offset_ -= n;
+        size_ += n;
+        copy_bits(bits, 0, 0, n);
         return *this;
     }
 
     /// \brief Adds the bitset to the big end
     Bitset& append(const Bitset& bits)
     {
-        for (bool bit : bits) push_back(bit);
+        if (&bits == this)
+        {
+            Bitset copy(bits);
+            return append(copy);
+        }
 
+        size_type n = bits.size();
+        reserve_back(n);
+        size_type old_size = size_;
+        size_ += n;
+        copy_bits(bits, 0, old_size, n);
         return *this;
     }
 
+    /// \brief Reads up to 64 bits starting at bit index `pos` (lsb first) and returns them in the least significant end of a word.
+    ///
+    /// \param pos Index of the first bit to read
+    /// \param n Number of bits to read (1-64)
+    word_type read_bits(size_type pos, size_type n) const { return read_abs(offset_ + pos, n); }
+
+    /// \brief Writes the `n` least significant bits of `value` to the Bitset starting at bit index `pos`. The Bitset must already be large enough.
+    ///
+    /// \param pos Index of the first bit to write
+    /// \param value Bits to write (lsb first)
+    /// \param n Number of bits to write (1-64)
+    void write_bits(size_type pos, word_type value, size_type n)
+    {
+        write_abs(offset_ + pos, value, n);
+    }
+
+    /// \brief Remove (discard) `n` bits from the little (least significant) end
+    void erase_front(size_type n)
+    {
+        if (n > size_)
+            throw(dccl::Exception("Bitset erase_front requires n <= this->size()"));
+        offset_ += n;
+        size_ -= n;
+        if (size_ == 0)
+            offset_ = 0;
+    }
+
   private:
+    friend class BitWriter;
+    friend class BitReader;
+
     Bitset relinquish_bits(size_type num_bits, bool final_child);
 
+    static word_type low_mask(size_type n)
+    {
+        return n >= BITS_IN_WORD ? ~word_type(0) : ((word_type(1) << n) - 1);
+    }
+
+    static size_type words_for(size_type num_bits)
+    {
+        return (num_bits + BITS_IN_WORD - 1) / BITS_IN_WORD;
+    }
+
+    // read/write relative to the start of the storage words (ignoring offset_)
+    word_type read_abs(size_type abs, size_type n) const
+    {
+        size_type w = abs / BITS_IN_WORD;
+        size_type b = abs % BITS_IN_WORD;
+        const word_type* d = data();
+
+        word_type out = d[w] >> b;
+        if (b + n > BITS_IN_WORD)
+            out |= d[w + 1] << (BITS_IN_WORD - b);
+        return out & low_mask(n);
+    }
+
+    void write_abs(size_type abs, word_type value, size_type n)
+    {
+        size_type w = abs / BITS_IN_WORD;
+        size_type b = abs % BITS_IN_WORD;
+        word_type* d = data();
+        word_type mask = low_mask(n);
+        value &= mask;
+
+        d[w] = (d[w] & ~(mask << b)) | (value << b);
+        if (b + n > BITS_IN_WORD)
+        {
+            size_type spill = BITS_IN_WORD - b;
+            d[w + 1] = (d[w + 1] & ~(mask >> spill)) | (value >> spill);
+        }
+    }
+
+    word_type* data() { return external_ ? external_ : heap_ ? heap_.get() : inline_; }
+    const word_type* data() const { return external_ ? external_ : heap_ ? heap_.get() : inline_; }
+    size_type capacity_words() const
+    {
+        return external_ ? external_capacity_ : heap_ ? heap_capacity_ : INLINE_WORDS;
+    }
+    size_type capacity_bits() const { return capacity_words() * BITS_IN_WORD; }
+
+    bool get_bit(size_type n) const
+    {
+        size_type abs = offset_ + n;
+        return (data()[abs / BITS_IN_WORD] >> (abs % BITS_IN_WORD)) & 1;
+    }
+
+    void set_bit(size_type n, bool val)
+    {
+        size_type abs = offset_ + n;
+        word_type bit = word_type(1) << (abs % BITS_IN_WORD);
+        word_type& w = data()[abs / BITS_IN_WORD];
+        w = val ? (w | bit) : (w & ~bit);
+    }
+
+    void fill_bits(size_type pos, size_type n, bool value)
+    {
+        word_type fill = value ? ~word_type(0) : word_type(0);
+        for (size_type i = 0; i < n; i += BITS_IN_WORD)
+            write_bits(pos + i, fill, std::min(BITS_IN_WORD, n - i));
+    }
+
+    // copy n bits from src (starting at src_pos) into this (starting at dest_pos)
+    void copy_bits(const Bitset& src, size_type src_pos, size_type dest_pos, size_type n)
+    {
+        for (size_type i = 0; i < n; i += BITS_IN_WORD)
+        {
+            size_type chunk = std::min(BITS_IN_WORD, n - i);
+            write_bits(dest_pos + i, src.read_bits(src_pos + i, chunk), chunk);
+        }
+    }
+
+    // write the first num_bits bits to buf (as bytes)
+    void write_bytes(char* buf, size_type num_bits) const
+    {
+        size_type len = num_bits / 8 + (num_bits % 8 ? 1 : 0);
+        for (size_type i = 0; i < num_bits; i += BITS_IN_WORD)
+        {
+            size_type chunk = std::min(BITS_IN_WORD, num_bits - i);
+            word_type word = read_bits(i, chunk);
+            for (size_type byte = i / 8, end = std::min(len, (i + chunk + 7) / 8); byte < end;
+                 ++byte, word >>= 8)
+                buf[byte] = static_cast<char>(word & 0xFF);
+        }
+    }
+
+    // ensure there is room for n more bits at the most significant end
+    void reserve_back(size_type n)
+    {
+        if (offset_ + size_ + n > capacity_bits())
+            relocate(0, size_ + n);
+    }
+
+    // ensure there is room for n more bits at the least significant end
+    void reserve_front(size_type n)
+    {
+        if (offset_ < n)
+        {
+            // leave a word of headroom so repeated push_front() calls are amortized
+            size_type new_offset = (words_for(n) + 1) * BITS_IN_WORD;
+            relocate(new_offset, size_);
+        }
+    }
+
+    // move the bits so that they begin at new_offset, with room for at least num_bits after that
+    void relocate(size_type new_offset, size_type num_bits)
+    {
+        size_type needed_bits = new_offset + std::max(num_bits, size_);
+
+        if (needed_bits <= capacity_bits())
+        {
+            // move within the existing storage
+            if (new_offset < offset_)
+            {
+                for (size_type i = 0; i < size_; i += BITS_IN_WORD)
+                {
+                    size_type chunk = std::min(BITS_IN_WORD, size_ - i);
+                    write_abs(new_offset + i, read_abs(offset_ + i, chunk), chunk);
+                }
+            }
+            else if (new_offset > offset_)
+            {
+                for (size_type i = size_; i > 0;)
+                {
+                    size_type chunk = std::min(BITS_IN_WORD, i);
+                    i -= chunk;
+                    write_abs(new_offset + i, read_abs(offset_ + i, chunk), chunk);
+                }
+            }
+            offset_ = new_offset;
+            return;
+        }
+
+        size_type new_capacity = std::max(words_for(needed_bits), 2 * capacity_words());
+        std::unique_ptr<word_type[]> new_words(new word_type[new_capacity]());
+
+        Bitset old;
+        old.steal(std::move(*this));
+
+        heap_ = std::move(new_words);
+        heap_capacity_ = new_capacity;
+        offset_ = new_offset;
+        size_ = old.size_;
+        copy_bits(old, 0, 0, size_);
+    }
+
+    // copies the bits (not the parent) of rhs into this
+    void assign_bits(const Bitset& rhs)
+    {
+        clear();
+        reserve_back(rhs.size_);
+        size_ = rhs.size_;
+        copy_bits(rhs, 0, 0, size_);
+    }
+
+    // takes the bits (not the parent) of rhs, leaving it empty
+    void steal(Bitset&& rhs)
+    {
+        if (rhs.heap_)
+        {
+            heap_ = std::move(rhs.heap_);
+            heap_capacity_ = rhs.heap_capacity_;
+        }
+        else
+        {
+            heap_.reset();
+            heap_capacity_ = 0;
+            std::copy(rhs.inline_, rhs.inline_ + INLINE_WORDS, inline_);
+        }
+        external_ = rhs.external_;
+        external_capacity_ = rhs.external_capacity_;
+        offset_ = rhs.offset_;
+        size_ = rhs.size_;
+
+        rhs.heap_capacity_ = 0;
+        rhs.external_ = nullptr;
+        rhs.external_capacity_ = 0;
+        rhs.clear();
+    }
+
   private:
     Bitset* parent_;
+
+    // bit index within the storage words of the least significant bit
+    size_type offset_{0};
+    size_type size_{0};
+
+    word_type inline_[INLINE_WORDS]{};
+    std::unique_ptr<word_type[]> heap_;
+    size_type heap_capacity_{0};
+    // caller's buffer set by store_in() (not owned), used in preference to inline_ / heap_
+    word_type* external_{nullptr};
+    size_type external_capacity_{0};
+};
+
+/// \brief Cursor for writing to the big (most significant) end of a Bitset.
+///
+/// Used by streaming field codecs (see FieldCodecBase::streaming()) to write their bits directly into the message's Bitset, rather than returning a new Bitset for each field which is then appended to the message.
+class BitWriter
+{
+  public:
+    /// \brief Create a writer that appends to `bits`
+    explicit BitWriter(Bitset* bits) : bits_(bits), start_(bits->size()) {}
+
+    /// \brief Write the `num_bits` (0-64) least significant bits of `value`
+    void write(Bitset::word_type value, Bitset::size_type num_bits)
+    {
+        if (!num_bits)
+            return;
+        bits_->reserve_back(num_bits);
+        bits_->size_ += num_bits;
+        bits_->write_bits(bits_->size_ - num_bits, value, num_bits);
+    }
+
+    /// \brief Write a single bit
+    void write_bit(bool bit) { write(bit ? 1 : 0, 1); }
+
+    /// \brief Write `num_bits` false (0) bits
+    void write_zeros(Bitset::size_type num_bits) { bits_->resize(bits_->size() + num_bits); }
+
+    /// \brief Write the contents of another Bitset
+    void write(const Bitset& bits) { bits_->append(bits); }
+
+    /// \brief Write each character of `bytes` as 8 bits (first character in the least significant byte), as with Bitset::from_byte_string()
+    void write_bytes(const std::string& bytes)
+    {
+        bits_->reserve_back(bytes.size() * 8);
+
+        Bitset::word_type word = 0;
+        Bitset::size_type word_bits = 0;
+        for (char c : bytes)
+        {
+            word |= static_cast<Bitset::word_type>(static_cast<unsigned char>(c)) << word_bits;
+            word_bits += 8;
+            if (word_bits == Bitset::BITS_IN_WORD)
+            {
+                write(word, word_bits);
+                word = 0;
+                word_bits = 0;
+            }
+        }
+        write(word, word_bits);
+    }
+
+    /// \brief Number of bits written using this writer
+    Bitset::size_type size() const { return bits_->size() - start_; }
+
+    /// \brief Copy of the bits written using this writer (intended for debugging output)
+    Bitset written() const
+    {
+        Bitset out(*bits_);
+        out.erase_front(start_);
+        return out;
+    }
+
+    /// \brief The underlying Bitset
+    Bitset* bits() { return bits_; }
+
+  private:
+    Bitset* bits_;
+    Bitset::size_type start_;
+};
+
+/// \brief Cursor for reading (and consuming) bits from the little (least significant) end of a Bitset.
+///
+/// When the Bitset runs out of bits, more are requested from its parent (see Bitset::get_more_bits()). Used by streaming field codecs (see FieldCodecBase::streaming()) to decode directly from the message's Bitset without first creating a new Bitset for each field.
+class BitReader
+{
+  public:
+    /// \brief Create a reader that consumes from `bits`
+    explicit BitReader(Bitset* bits) : bits_(bits) {}
+
+    /// \brief Read (and consume) `num_bits` (0-64) bits.
+    ///
+    /// \return The bits read, in the least significant end of the word
+    /// \throw Exception Not enough bits are available in the Bitset (or its parents)
+    Bitset::word_type read(Bitset::size_type num_bits)
+    {
+        if (!num_bits)
+            return 0;
+        require(num_bits);
+        Bitset::word_type value = bits_->read_bits(0, num_bits);
+        bits_->erase_front(num_bits);
+        consumed_ += num_bits;
+        return value;
+    }
+
+    /// \brief Read (and consume) a single bit
+    bool read_bit() { return read(1); }
+
+    /// \brief Read (and consume) `num_bytes` bytes, as with Bitset::to_byte_string()
+    std::string read_bytes(Bitset::size_type num_bytes)
+    {
+        std::string out(num_bytes, 0);
+        if (!num_bytes)
+            return out;
+
+        require(num_bytes * 8);
+        bits_->write_bytes(&out[0], num_bytes * 8);
+        bits_->erase_front(num_bytes * 8);
+        consumed_ += num_bytes * 8;
+        return out;
+    }
+
+    /// \brief Number of bits read using this reader
+    Bitset::size_type consumed() const { return consumed_; }
+
+    /// \brief The underlying Bitset
+    Bitset* bits() { return bits_; }
+
+  private:
+    void require(Bitset::size_type num_bits)
+    {
+        if (bits_->size() < num_bits)
+            bits_->get_more_bits(num_bits - bits_->size());
+
+        if (bits_->size() < num_bits)
+            throw(dccl::Exception("Cannot read bits - no more bits to give up! Check "
+                                  "that all field codecs are always producing (encode) and "
+                                  "consuming (decode) the exact same number of bits."));
+    }
+
+  private:
+    Bitset* bits_;
+    Bitset::size_type consumed_{0};
 };
 
 inline bool operator==(const Bitset& a, const Bitset& b)
 {
-    return (a.size() == b.size()) && std::equal(a.begin(), a.end(), b.begin());
+    if (a.size() != b.size())
+        return false;
+
+    for (Bitset::size_type i = 0, n = a.size(); i < n; i += Bitset::BITS_IN_WORD)
+    {
+        Bitset::size_type chunk = std::min(Bitset::BITS_IN_WORD, n - i);
+        if (a.read_bits(i, chunk) != b.read_bits(i, chunk))
+            return false;
+    }
+    return true;
 }
 
 inline bool operator<(const Bitset& a, const Bitset& b)
 {
-    for (int i = (std::max(a.size(), b.size()) - 1); i >= 0; --i)
+    // compare word by word starting from the most significant end, treating missing bits as 0
+    Bitset::size_type n = std::max(a.size(), b.size());
+    Bitset::size_type top = n % Bitset::BITS_IN_WORD;
+    for (Bitset::size_type end = n; end > 0;)
     {
-        bool a_bit = (i < static_cast<int>(a.size())) ? a[i] : 0;
-        bool b_bit = (i < static_cast<int>(b.size())) ? b[i] : 0;
+        Bitset::size_type chunk = (end == n && top) ? top : Bitset::BITS_IN_WORD;
+        Bitset::size_type begin = end - chunk;
 
-        if (a_bit > b_bit)
-            return false;
-        else if (a_bit < b_bit)
-            return true;
+        auto read_padded = [&](const Bitset& bits) -> Bitset::word_type {
+            if (begin >= bits.size())
+                return 0;
+            return bits.read_bits(begin, std::min(chunk, bits.size() - begin));
+        };
+
+        Bitset::word_type a_word = read_padded(a);
+        Bitset::word_type b_word = read_padded(b);
+        if (a_word != b_word)
+            return a_word < b_word;
+
+        end = begin;
     }
     return false;
 }
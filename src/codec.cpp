@@ -31,6 +31,8 @@
 #include <dlfcn.h> // for shared library loading
 
 #include "codec.h"
+#include "internal/thread_pool.h"
+#include "thread_safety.h"
 
 #if DCCL_HAS_CRYPTOPP
 #if CRYPTOPP_PATH_USES_PLUS_SIGN
@@ -66,6 +68,44 @@ using google::protobuf::Descriptor;
 using google::protobuf::FieldDescriptor;
 using google::protobuf::Reflection;
 
+#if DCCL_HAS_CRYPTOPP
+namespace dccl
+{
+namespace internal
+{
+// keyed AES block cipher for a given passphrase, shared by all threads and clones. It is never
+// used directly (without AES-NI Rijndael keeps mutable scratch space): each message, or batch
+// chunk, works on its own copy, which is still much cheaper than redoing the key schedule
+struct CipherContext
+{
+    explicit CipherContext(const std::string& key)
+        : aes(reinterpret_cast<const unsigned char*>(key.data()), key.size())
+    {
+    }
+    const CryptoPP::AES::Encryption aes;
+};
+} // namespace internal
+} // namespace dccl
+
+namespace
+{
+// encrypts (or decrypts) s[0, len) in place with AES-CTR, using the SHA256 hash of the nonce as the IV
+void ctr_crypt(CryptoPP::AES::Encryption& aes, char* s, std::size_t len, const char* nonce,
+               std::size_t nonce_len)
+{
+    using namespace CryptoPP;
+
+    byte iv[SHA256::DIGESTSIZE];
+    SHA256 hash;
+    hash.CalculateDigest(iv, reinterpret_cast<const byte*>(nonce), nonce_len);
+
+    // only the IV (counter) is set up per message
+    CTR_Mode_ExternalCipher::Encryption encryptor(aes, iv);
+    encryptor.ProcessData(reinterpret_cast<byte*>(s), reinterpret_cast<const byte*>(s), len);
+}
+} // namespace
+#endif
+
 //
 // Codec
 //
@@ -74,7 +114,7 @@ dccl::Codec::Codec(std::string dccl_id_codec_name, const std::string& library_pa
     : id_codec_(std::move(dccl_id_codec_name))
 {
     set_default_codecs();
-    manager_.add<DefaultIdentifierCodec>(default_id_codec_name());
+    manager_->add<DefaultIdentifierCodec>(default_id_codec_name());
 
     if (!library_path.empty())
         load_library(library_path);
@@ -84,10 +124,14 @@ dccl::Codec::Codec(std::string dccl_id_codec_name, const std::string& library_pa
 
 dccl::Codec::~Codec()
 {
-    for (auto& dl_handle : dl_handles_)
+    // only the last Codec using these libraries (and the registry they added codecs to) unloads them
+    if (dl_handles_.use_count() == 1)
     {
-        unload_library(dl_handle);
-        dlclose(dl_handle);
+        for (auto& dl_handle : *dl_handles_)
+        {
+            unload_library(dl_handle);
+            dlclose(dl_handle);
+        }
     }
 }
 
@@ -98,37 +142,72 @@ void dccl::Codec::set_default_codecs()
     //
     // version 2
     //
-    internal::DefaultFieldCodecLoader<2>::add(manager_);
-    internal::TimeCodecLoader<2>::add(manager_);
-    internal::StaticCodecLoader<2>::add(manager_);
+    internal::DefaultFieldCodecLoader<2>::add(*manager_);
+    internal::TimeCodecLoader<2>::add(*manager_);
+    internal::StaticCodecLoader<2>::add(*manager_);
 
     // backwards compatibility names (deprecated)
-    internal::TimeCodecLoader<2>::add(manager_, "_time");
-    internal::StaticCodecLoader<2>::add(manager_, "_static");
+    internal::TimeCodecLoader<2>::add(*manager_, "_time");
+    internal::StaticCodecLoader<2>::add(*manager_, "_static");
 
     //
     // version 3
     //
-    internal::DefaultFieldCodecLoader<3>::add(manager_);
-    internal::TimeCodecLoader<3>::add(manager_);
-    internal::StaticCodecLoader<3>::add(manager_);
-    internal::PresenceCodecLoader<3>::add(manager_);
-    internal::VarBytesCodecLoader<3>::add(manager_);
+    internal::DefaultFieldCodecLoader<3>::add(*manager_);
+    internal::TimeCodecLoader<3>::add(*manager_);
+    internal::StaticCodecLoader<3>::add(*manager_);
+    internal::PresenceCodecLoader<3>::add(*manager_);
+    internal::VarBytesCodecLoader<3>::add(*manager_);
 
     //
     // version 4
     //
-    internal::DefaultFieldCodecLoader<4>::add(manager_);
-    internal::TimeCodecLoader<4>::add(manager_);
-    internal::StaticCodecLoader<4>::add(manager_);
-    internal::PresenceCodecLoader<4>::add(manager_);
-    internal::VarBytesCodecLoader<4>::add(manager_);
-    internal::HashCodecLoader<4>::add(manager_, {2, 3, 4}); // backport for older versions 2 and 3
+    internal::DefaultFieldCodecLoader<4>::add(*manager_);
+    internal::TimeCodecLoader<4>::add(*manager_);
+    internal::StaticCodecLoader<4>::add(*manager_);
+    internal::PresenceCodecLoader<4>::add(*manager_);
+    internal::VarBytesCodecLoader<4>::add(*manager_);
+    internal::HashCodecLoader<4>::add(*manager_, {2, 3, 4}); // backport for older versions 2 and 3
+}
+
+void dccl::Codec::encode_type_info(const google::protobuf::Descriptor* desc, int user_id,
+                                   EncodeTypeInfo* type_info) const
+{
+    if (type_info->desc == desc && type_info->user_id == user_id)
+        return;
+
+    // reset so a failure below doesn't leave a partially filled type_info that matches desc
+    *type_info = EncodeTypeInfo();
+
+    int32 dccl_id = id_internal_const(desc, user_id);
+
+    if (!id2desc_.count(dccl_id))
+        throw(Exception("Message id " + std::to_string(dccl_id) +
+                        " has not been loaded. Call load() before encoding this type.",
+                    desc));
+
+    FieldCodecBase* codec = manager_->find_root_codec(desc);
+    if (!codec)
+        throw(Exception("Failed to find (dccl.msg).codec `" +
+                        desc->options().GetExtension(dccl::msg).codec() + "`",
+                    desc));
+
+    //fixed header
+    if (!desc->options().GetExtension(dccl::msg).omit_id())
+        id_codec()->field_encode(&type_info->id_bits, static_cast<uint32>(dccl_id), nullptr);
+
+    type_info->dccl_id = dccl_id;
+    type_info->codec = codec;
+    type_info->user_id = user_id;
+    type_info->desc = desc;
 }
 
 void dccl::Codec::encode_internal(const google::protobuf::Message& msg, bool header_only,
-                                  Bitset& head_bits, Bitset& body_bits, int user_id)
+                                  Bitset& bits, std::size_t* head_byte_size, int user_id,
+                                  EncodeTypeInfo* type_info) const
 {
+    bits.clear();
+
     const Descriptor* desc = msg.GetDescriptor();
 
     dlog.is(DEBUG1, ENCODE) && dlog << "Began encoding message of type: " << desc->full_name()
@@ -136,9 +215,6 @@ void dccl::Codec::encode_internal(const google::protobuf::Message& msg, bool hea
 
     try
     {
-        int32 dccl_id = id_internal(desc, user_id);
-        size_t head_byte_size = 0;
-
         if (!msg.IsInitialized() && !header_only)
         {
             std::stringstream ss;
@@ -150,44 +226,30 @@ void dccl::Codec::encode_internal(const google::protobuf::Message& msg, bool hea
             throw(Exception(ss.str(), desc));
         }
 
-        if (!id2desc_.count(dccl_id))
-            throw(Exception("Message id " + std::to_string(dccl_id) +
-                            " has not been loaded. Call load() before encoding this type."),
-                  desc);
-
-        std::shared_ptr<FieldCodecBase> codec = manager_.find(desc);
-        std::shared_ptr<internal::FromProtoCppTypeBase> helper = manager_.type_helper().find(desc);
+        encode_type_info(desc, user_id, type_info);
+        FieldCodecBase* codec = type_info->codec;
 
-        if (codec)
-        {
-            //fixed header
-            if (!desc->options().GetExtension(dccl::msg).omit_id())
-                id_codec()->field_encode(&head_bits, static_cast<uint32>(dccl_id), nullptr);
+        bits.append(type_info->id_bits);
 
-            internal::MessageStack msg_stack(manager_.codec_data().root_message_,
-                                             manager_.codec_data().message_data_);
-            msg_stack.push(msg.GetDescriptor());
-            codec->base_encode(&head_bits, msg, HEAD, strict_);
+        internal::CodecData& codec_data = *internal::CodecDataScope::active(*manager_);
+        codec_data.trace_ = trace_.get();
+        internal::MessageStack msg_stack(codec_data.root_message_, codec_data.message_data_);
+        msg_stack.push(msg.GetDescriptor());
+        codec->base_encode(&bits, msg, HEAD, strict_);
 
-            // given header of not even byte size (e.g. 01011), make even byte size (e.g. 00001011)
-            head_byte_size = ceil_bits2bytes(head_bits.size());
-            head_bits.resize(head_byte_size * BITS_IN_BYTE);
+        // given header of not even byte size (e.g. 01011), make even byte size (e.g. 00001011)
+        *head_byte_size = ceil_bits2bytes(bits.size());
+        bits.resize(*head_byte_size * BITS_IN_BYTE);
 
-            if (header_only)
-            {
-                dlog.is(DEBUG2, ENCODE) &&
-                    dlog << "as requested, skipping encoding and encrypting body." << std::endl;
-            }
-            else
-            {
-                codec->base_encode(&body_bits, msg, BODY, strict_);
-            }
+        if (header_only)
+        {
+            dlog.is(DEBUG2, ENCODE) &&
+                dlog << "as requested, skipping encoding and encrypting body." << std::endl;
         }
         else
         {
-            throw(Exception("Failed to find (dccl.msg).codec `" +
-                            desc->options().GetExtension(dccl::msg).codec() + "`"),
-                  desc);
+            // body is written immediately following the (byte aligned) header
+            codec->base_encode(&bits, msg, BODY, strict_);
         }
     }
     catch (dccl::OutOfRangeException& e)
@@ -198,6 +260,10 @@ void dccl::Codec::encode_internal(const google::protobuf::Message& msg, bool hea
                  << e.what() << std::endl;
         throw;
     }
+    catch (dccl::EncodeSizeExceededException&)
+    {
+        throw;
+    }
     catch (std::exception& e)
     {
         std::stringstream ss;
@@ -210,103 +276,139 @@ void dccl::Codec::encode_internal(const google::protobuf::Message& msg, bool hea
 }
 
 size_t dccl::Codec::encode(char* bytes, size_t max_len, const google::protobuf::Message& msg,
-                           bool header_only /* = false */, int user_id /* = -1 */)
+                           bool header_only /* = false */, int user_id /* = -1 */) const
 {
+    internal::CodecDataScope scope(*manager_);
+    // encode straight into the caller's buffer if possible (so encode_finalize() has nothing to
+    // copy), otherwise into the retained Bitset
+    Bitset direct_bits;
+    Bitset& bits = direct_bits.store_in(bytes, max_len) ? direct_bits : scope.data().encode_bits_;
+
     const Descriptor* desc = msg.GetDescriptor();
-    Bitset head_bits;
-    Bitset body_bits;
-    encode_internal(msg, header_only, head_bits, body_bits, user_id);
+    std::size_t head_byte_size = 0;
+    EncodeTypeInfo type_info;
+    encode_internal(msg, header_only, bits, &head_byte_size, user_id, &type_info);
 
-    size_t head_byte_size = ceil_bits2bytes(head_bits.size());
     if (max_len < head_byte_size)
     {
         throw std::length_error("max_len must be >= head_byte_size");
     }
-    head_bits.to_byte_string(bytes, head_byte_size);
-
-    dlog.is(DEBUG2, ENCODE) && dlog << "Head bytes (bits): " << head_byte_size << "("
-                                    << head_bits.size() << ")" << std::endl;
-    dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (bin): " << head_bits << std::endl;
-    dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (hex): "
-                                    << hex_encode(bytes, bytes + head_byte_size) << std::endl;
 
-    size_t body_byte_size = 0;
-    if (!header_only)
+    size_t byte_size = ceil_bits2bytes(bits.size());
+    if (max_len < byte_size)
     {
-        body_byte_size = ceil_bits2bytes(body_bits.size());
-        if (max_len < (head_byte_size + body_byte_size))
-        {
-            throw std::length_error("max_len must be >= (head_byte_size + body_byte_size)");
-        }
-        body_bits.to_byte_string(bytes + head_byte_size, max_len - head_byte_size);
-
-        dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (bin): " << body_bits << std::endl;
-        dlog.is(DEBUG3, ENCODE) &&
-            dlog << "Unencrypted Body (hex): "
-                 << hex_encode(bytes + head_byte_size, bytes + head_byte_size + body_byte_size)
-                 << std::endl;
-        dlog.is(DEBUG2, ENCODE) && dlog << "Body bytes (bits): " << body_byte_size << "("
-                                        << body_bits.size() << ")" << std::endl;
-
-        int32 dccl_id = id_internal(desc, user_id);
-        if (!crypto_key_.empty() && !skip_crypto_ids_.count(dccl_id))
-        {
-            std::string head_bytes(bytes, bytes + head_byte_size);
-            std::string body_bytes(bytes + head_byte_size, bytes + head_byte_size + body_byte_size);
-            encrypt(&body_bytes, head_bytes);
-            std::memcpy(bytes + head_byte_size, body_bytes.data(), body_bytes.size());
-        }
-
-        dlog.is(logger::DEBUG3, logger::ENCODE) &&
-            dlog << "Encrypted Body (hex): "
-                 << hex_encode(bytes + head_byte_size, bytes + head_byte_size + body_byte_size)
-                 << std::endl;
+        throw std::length_error("max_len must be >= (head_byte_size + body_byte_size)");
     }
 
+    encode_finalize(bytes, bits, head_byte_size, header_only, type_info.dccl_id);
+
     dlog.is(DEBUG1, ENCODE) && dlog << "Successfully encoded message of type: " << desc->full_name()
                                     << std::endl;
 
-    return head_byte_size + body_byte_size;
+    return byte_size;
 }
 
 void dccl::Codec::encode(std::string* bytes, const google::protobuf::Message& msg,
-                         bool header_only /* = false */, int user_id /* = -1 */)
+                         bool header_only /* = false */, int user_id /* = -1 */) const
 {
-    const Descriptor* desc = msg.GetDescriptor();
-    Bitset head_bits;
-    Bitset body_bits;
-    encode_internal(msg, header_only, head_bits, body_bits, user_id);
+    EncodeTypeInfo type_info;
+    encode_append(bytes, msg, header_only, user_id, &type_info);
+}
 
-    std::string head_bytes = head_bits.to_byte_string();
+std::size_t dccl::Codec::encode_if_fits(std::string* bytes, const google::protobuf::Message& msg,
+                                        std::size_t max_bytes,
+                                        bool header_only /* = false */,
+                                        int user_id /* = -1 */) const
+{
+    internal::CodecDataScope scope(*manager_);
+    Bitset& bits = scope.data().encode_bits_;
 
-    dlog.is(DEBUG2, ENCODE) && dlog << "Head bytes (bits): " << head_bytes.size() << "("
-                                    << head_bits.size() << ")" << std::endl;
-    dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (bin): " << head_bits << std::endl;
-    dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (hex): " << hex_encode(head_bytes)
-                                    << std::endl;
+    // stop encoding as soon as the running bit count passes the budget
+    scope.data().encode_bit_limit_ = max_bytes * BITS_IN_BYTE;
+
+    std::size_t head_byte_size = 0;
+    EncodeTypeInfo type_info;
+    try
+    {
+        encode_internal(msg, header_only, bits, &head_byte_size, user_id, &type_info);
+    }
+    catch (dccl::EncodeSizeExceededException&)
+    {
+        dlog.is(DEBUG1, ENCODE) && dlog << "Message " << msg.GetDescriptor()->full_name()
+                                        << " does not fit in " << max_bytes << " bytes"
+                                        << std::endl;
+        return 0;
+    }
+
+    std::size_t byte_size = ceil_bits2bytes(bits.size());
+    if (byte_size > max_bytes)
+        return 0;
+
+    std::size_t begin = bytes->size();
+    bytes->resize(begin + byte_size);
+    encode_finalize(&(*bytes)[begin], bits, head_byte_size, header_only, type_info.dccl_id);
+
+    dlog.is(DEBUG1, ENCODE) && dlog << "Successfully encoded message of type: "
+                                    << msg.GetDescriptor()->full_name() << std::endl;
+    return byte_size;
+}
+
+void dccl::Codec::encode_append(std::string* bytes, const google::protobuf::Message& msg,
+                                bool header_only, int user_id, EncodeTypeInfo* type_info,
+                                std::vector<CryptJob>* crypt_jobs /* = nullptr */) const
+{
+    internal::CodecDataScope scope(*manager_);
+    Bitset& bits = scope.data().encode_bits_;
+
+    std::size_t head_byte_size = 0;
+    encode_internal(msg, header_only, bits, &head_byte_size, user_id, type_info);
+
+    // append to any existing contents of bytes
+    std::size_t begin = bytes->size();
+    bytes->resize(begin + ceil_bits2bytes(bits.size()));
+
+    bool defer_crypt = crypt_jobs && !header_only && body_encrypted(type_info->dccl_id);
+    encode_finalize(&(*bytes)[begin], bits, head_byte_size, header_only, type_info->dccl_id,
+                    !defer_crypt);
+    if (defer_crypt)
+        crypt_jobs->push_back({begin, head_byte_size, bytes->size() - begin - head_byte_size});
+
+    dlog.is(DEBUG1, ENCODE) && dlog << "Successfully encoded message of type: "
+                                    << msg.GetDescriptor()->full_name() << std::endl;
+}
+
+void dccl::Codec::encode_finalize(char* bytes, const Bitset& bits, std::size_t head_byte_size,
+                                  bool header_only, int32 dccl_id,
+                                  bool encrypt_body /* = true */) const
+{
+    std::size_t byte_size = ceil_bits2bytes(bits.size());
+    bits.to_byte_string(bytes, byte_size);
+
+    dlog.is(DEBUG2, ENCODE) && dlog << "Head bytes (bits): " << head_byte_size << "("
+                                    << head_byte_size * BITS_IN_BYTE << ")" << std::endl;
+    dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Head (hex): "
+                                    << hex_encode(bytes, bytes + head_byte_size) << std::endl;
 
-    std::string body_bytes;
     if (!header_only)
     {
-        body_bytes = body_bits.to_byte_string();
+        std::size_t body_byte_size = byte_size - head_byte_size;
+        char* body = bytes + head_byte_size;
 
-        dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (bin): " << body_bits << std::endl;
-        dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (hex): " << hex_encode(body_bytes)
+        dlog.is(DEBUG3, ENCODE) && dlog << "Unencrypted Body (hex): "
+                                        << hex_encode(body, body + body_byte_size) << std::endl;
+        dlog.is(DEBUG2, ENCODE) && dlog << "Body bytes (bits): " << body_byte_size << "("
+                                        << bits.size() - head_byte_size * BITS_IN_BYTE << ")"
                                         << std::endl;
-        dlog.is(DEBUG2, ENCODE) && dlog << "Body bytes (bits): " << body_bytes.size() << "("
-                                        << body_bits.size() << ")" << std::endl;
 
-        int32 dccl_id = id_internal(desc, user_id);
-        if (!crypto_key_.empty() && !skip_crypto_ids_.count(dccl_id))
-            encrypt(&body_bytes, head_bytes);
+        if (encrypt_body && body_encrypted(dccl_id))
+        {
+            crypt_in_place(body, body_byte_size, bytes, head_byte_size);
 
-        dlog.is(logger::DEBUG3, logger::ENCODE) &&
-            dlog << "Encrypted Body (hex): " << hex_encode(body_bytes) << std::endl;
+            dlog.is(logger::DEBUG3, logger::ENCODE) &&
+                dlog << "Encrypted Body (hex): " << hex_encode(body, body + body_byte_size)
+                     << std::endl;
+        }
     }
-
-    dlog.is(DEBUG1, ENCODE) && dlog << "Successfully encoded message of type: " << desc->full_name()
-                                    << std::endl;
-    *bytes += head_bytes + body_bytes;
 }
 
 int32 dccl::Codec::id(const std::string& bytes) const { return id(bytes.begin(), bytes.end()); }
@@ -315,6 +417,7 @@ int32 dccl::Codec::id(const std::string& bytes) const { return id(bytes.begin(),
 // checks all bounds on the message
 std::size_t dccl::Codec::load(const google::protobuf::Descriptor* desc, int user_id /* = -1 */)
 {
+    internal::CodecDataScope scope(*manager_);
     try
     {
         const auto& msg_opt = desc->options().GetExtension(dccl::msg);
@@ -337,7 +440,7 @@ std::size_t dccl::Codec::load(const google::protobuf::Descriptor* desc, int user
                     desc->full_name() + " to use the default DCCL4 codecs.",
                 desc));
 
-        std::shared_ptr<FieldCodecBase> codec = manager_.find(desc);
+        std::shared_ptr<FieldCodecBase> codec = manager_->find(desc);
 
         int32 dccl_id = id_internal(desc, user_id);
 
@@ -386,7 +489,7 @@ std::size_t dccl::Codec::load(const google::protobuf::Descriptor* desc, int user
         std::size_t hash_value = 0;
         codec->base_hash(&hash_value, desc, HEAD);
         codec->base_hash(&hash_value, desc, BODY);
-        manager_.set_hash(desc, hash_value);
+        manager_->set_hash(desc, hash_value);
         return hash_value;
     }
     catch (Exception& e)
@@ -428,6 +531,11 @@ void dccl::Codec::unload(const google::protobuf::Descriptor* desc)
         dlog.is(DEBUG1) && dlog << "Message " << desc->full_name()
                                 << ": is not loaded. Ignoring unload request." << std::endl;
     }
+    else
+    {
+        // descriptor may be destroyed after unloading, so drop anything cached against it
+        manager_->invalidate();
+    }
 }
 
 void dccl::Codec::unload(size_t dccl_id)
@@ -435,6 +543,7 @@ void dccl::Codec::unload(size_t dccl_id)
     if (id2desc_.count(dccl_id))
     {
         id2desc_.erase(dccl_id);
+        manager_->invalidate();
     }
     else
     {
@@ -444,13 +553,14 @@ void dccl::Codec::unload(size_t dccl_id)
     }
 }
 
-unsigned dccl::Codec::size(const google::protobuf::Message& msg, int user_id /* = -1 */)
+unsigned dccl::Codec::size(const google::protobuf::Message& msg, int user_id /* = -1 */) const
 {
+    internal::CodecDataScope scope(*manager_);
     const Descriptor* desc = msg.GetDescriptor();
 
-    std::shared_ptr<FieldCodecBase> codec = manager_.find(desc);
+    FieldCodecBase* codec = manager_->find_root_codec(desc);
 
-    int32 dccl_id = id_internal(desc, user_id);
+    int32 dccl_id = id_internal_const(desc, user_id);
     unsigned head_size_bits;
     codec->base_size(&head_size_bits, msg, HEAD);
 
@@ -469,7 +579,8 @@ unsigned dccl::Codec::size(const google::protobuf::Message& msg, int user_id /*
 
 unsigned dccl::Codec::max_size(const google::protobuf::Descriptor* desc) const
 {
-    std::shared_ptr<FieldCodecBase> codec = manager_.find(desc);
+    internal::CodecDataScope scope(*manager_);
+    std::shared_ptr<FieldCodecBase> codec = manager_->find(desc);
 
     unsigned head_size_bits;
     codec->base_max_size(&head_size_bits, desc, HEAD);
@@ -489,7 +600,8 @@ unsigned dccl::Codec::max_size(const google::protobuf::Descriptor* desc) const
 
 unsigned dccl::Codec::min_size(const google::protobuf::Descriptor* desc) const
 {
-    std::shared_ptr<FieldCodecBase> codec = manager_.find(desc);
+    internal::CodecDataScope scope(*manager_);
+    std::shared_ptr<FieldCodecBase> codec = manager_->find(desc);
 
     unsigned head_size_bits;
     codec->base_min_size(&head_size_bits, desc, HEAD);
@@ -522,7 +634,7 @@ void dccl::Codec::info(const google::protobuf::Descriptor* desc, std::ostream* p
         {
             bool omit_id = desc->options().GetExtension(dccl::msg).omit_id();
 
-            std::shared_ptr<FieldCodecBase> codec = manager_.find(desc);
+            std::shared_ptr<FieldCodecBase> codec = manager_->find(desc);
 
             unsigned config_head_bit_size, body_bit_size;
             codec->base_max_size(&config_head_bit_size, desc, HEAD);
@@ -542,8 +654,8 @@ void dccl::Codec::info(const google::protobuf::Descriptor* desc, std::ostream* p
             const unsigned allowed_bit_size = allowed_byte_size * BITS_IN_BYTE;
 
             std::string hash;
-            if (manager_.has_hash(desc))
-                hash = hash_as_string(manager_.hash(desc));
+            if (manager_->has_hash(desc))
+                hash = hash_as_string(manager_->hash(desc));
 
             std::string message_name;
             if (!omit_id)
@@ -607,44 +719,91 @@ void dccl::Codec::info(const google::protobuf::Descriptor* desc, std::ostream* p
     }
 }
 
-void dccl::Codec::encrypt(std::string* s, const std::string& nonce /* message head */)
+void dccl::Codec::encrypt(std::string* s, const std::string& nonce /* message head */) const
 {
-#if DCCL_HAS_CRYPTOPP
-    using namespace CryptoPP;
-
-    std::string iv;
-    SHA256 hash;
-    StringSource unused(nonce, true, new HashFilter(hash, new StringSink(iv)));
+    if (!s->empty())
+        crypt_in_place(&(*s)[0], s->size(), nonce.data(), nonce.size());
+}
 
-    CTR_Mode<AES>::Encryption encryptor;
-    encryptor.SetKeyWithIV((byte*)crypto_key_.c_str(), crypto_key_.size(), (byte*)iv.c_str());
+void dccl::Codec::decrypt(std::string* s, const std::string& nonce) const
+{
+    // CTR mode: decryption is the same operation as encryption
+    if (!s->empty())
+        crypt_in_place(&(*s)[0], s->size(), nonce.data(), nonce.size());
+}
 
-    std::string cipher;
-    StreamTransformationFilter in(encryptor, new StringSink(cipher));
-    in.Put((byte*)s->c_str(), s->size());
-    in.MessageEnd();
-    *s = cipher;
+void dccl::Codec::crypt_in_place(char* s, std::size_t len, const char* nonce,
+                                 std::size_t nonce_len) const
+{
+#if DCCL_HAS_CRYPTOPP
+    CryptoPP::AES::Encryption aes(cipher_->aes);
+    ctr_crypt(aes, s, len, nonce, nonce_len);
+#else
+    (void)s;
+    (void)len;
+    (void)nonce;
+    (void)nonce_len;
 #endif
 }
 
-void dccl::Codec::decrypt(std::string* s, const std::string& nonce)
+void dccl::Codec::crypt_batch(std::string* bytes, const std::vector<CryptJob>& crypt_jobs) const
 {
 #if DCCL_HAS_CRYPTOPP
-    using namespace CryptoPP;
-
-    std::string iv;
-    SHA256 hash;
-    StringSource unused(nonce, true, new HashFilter(hash, new StringSink(iv)));
+    if (crypt_jobs.empty())
+        return;
 
-    CTR_Mode<AES>::Decryption decryptor;
-    decryptor.SetKeyWithIV((byte*)crypto_key_.c_str(), crypto_key_.size(), (byte*)iv.c_str());
+    char* base = &(*bytes)[0];
+    const internal::CipherContext& cipher = *cipher_;
+    // each chunk of messages (and so each thread) uses its own copy of the keyed cipher
+    auto crypt_range = [base, &cipher, &crypt_jobs](std::size_t first, std::size_t last) {
+        CryptoPP::AES::Encryption aes(cipher.aes);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const CryptJob& job = crypt_jobs[i];
+            char* head = base + job.begin;
+            ctr_crypt(aes, head + job.head_byte_size, job.body_byte_size, head,
+                      job.head_byte_size);
+        }
+    };
+
+#if DCCL_THREAD_SUPPORT
+    // not worth handing fewer messages than this to another thread
+    const std::size_t min_jobs_per_chunk = 16;
+    std::size_t num_chunks =
+        crypto_pool_ ? std::min<std::size_t>(crypto_pool_->workers() + 1,
+                                             crypt_jobs.size() / min_jobs_per_chunk)
+                     : 1;
+    if (num_chunks > 1)
+    {
+        std::size_t chunk = (crypt_jobs.size() + num_chunks - 1) / num_chunks;
+        crypto_pool_->run(num_chunks, [&](std::size_t i) {
+            crypt_range(std::min(i * chunk, crypt_jobs.size()),
+                        std::min((i + 1) * chunk, crypt_jobs.size()));
+        });
+
+        dlog.is(DEBUG2, ENCODE) && dlog << "Encrypted " << crypt_jobs.size()
+                                        << " message bodies in " << num_chunks
+                                        << " chunks on the crypto thread pool" << std::endl;
+        return;
+    }
+#endif
 
-    std::string recovered;
+    crypt_range(0, crypt_jobs.size());
+#else
+    (void)bytes;
+    (void)crypt_jobs;
+#endif
+}
 
-    StreamTransformationFilter out(decryptor, new StringSink(recovered));
-    out.Put((byte*)s->c_str(), s->size());
-    out.MessageEnd();
-    *s = recovered;
+void dccl::Codec::set_crypto_threads(unsigned threads)
+{
+#if DCCL_THREAD_SUPPORT && DCCL_HAS_CRYPTOPP
+    crypto_pool_.reset();
+    // the calling thread is one of the threads
+    if (threads > 1)
+        crypto_pool_ = std::make_shared<internal::ThreadPool>(threads - 1);
+#else
+    (void)threads;
 #endif
 }
 
@@ -652,7 +811,7 @@ void dccl::Codec::load_library(const std::string& library_path)
 {
     void* handle = dlopen(library_path.c_str(), RTLD_LAZY);
     if (handle)
-        dl_handles_.push_back(handle);
+        dl_handles_->push_back(handle);
     load_library(handle);
 }
 
@@ -686,6 +845,7 @@ void dccl::Codec::set_crypto_passphrase(
 {
     if (!crypto_key_.empty())
         crypto_key_.clear();
+    cipher_.reset();
     skip_crypto_ids_.clear();
 
 #if DCCL_HAS_CRYPTOPP
@@ -693,6 +853,7 @@ void dccl::Codec::set_crypto_passphrase(
 
     SHA256 hash;
     StringSource unused(passphrase, true, new HashFilter(hash, new StringSink(crypto_key_)));
+    cipher_ = std::make_shared<internal::CipherContext>(crypto_key_);
 
     dlog.is(DEBUG1) && dlog << "Cryptography enabled with given passphrase" << std::endl;
 #else
@@ -748,7 +909,7 @@ std::string dccl::Codec::build_guard_for_console_output(std::string& base, char
 }
 
 std::string dccl::Codec::get_all_error_fields_in_message(const google::protobuf::Message& message,
-                                                         uint8_t depth /*= 1 */)
+                                                         uint8_t depth /*= 1 */) const
 {
     // This is largely taken from google::protobuf::ReflectionOps::FindInitializationErrors(), which is called by
     // google::protobuf::Message::FindInitializationErrors(). The Message implementation is not used as they force a
@@ -27,6 +27,8 @@
 #ifndef DCCL20091211H
 #define DCCL20091211H
 
+#include <algorithm>
+#include <iterator>
 #include <map>
 #include <ostream>
 #include <set>
@@ -45,6 +47,7 @@
 #include "field_codec.h"
 #include "field_codec_fixed.h"
 #include "logger.h"
+#include "trace.h"
 
 #include "codecs2/field_codec_default_message.h"
 #include "codecs3/field_codec_default_message.h"
@@ -57,7 +60,15 @@ namespace dccl
 {
 class FieldCodec;
 
+namespace internal
+{
+struct CipherContext;
+class ThreadPool;
+} // namespace internal
+
 /// \brief The Dynamic CCL enCODer/DECoder. This is the main class you will use to load, encode and decode DCCL messages. Many users will not need any other DCCL classes than this one.
+///
+/// Once all messages are loaded, the const methods (encode, decode, size, etc.) may be called concurrently from multiple threads on the same Codec (each call uses its own internal::CodecData). Loading, unloading and changing codecs or settings must not happen concurrently with other calls. Codecs that keep state between messages (e.g. adaptive arithmetic models) are not made thread-safe by this.
 /// \ingroup dccl_api
 class Codec
 {
@@ -83,15 +94,20 @@ class Codec
         : id_codec_(dccl_id_codec_name)
     {
         set_default_codecs();
-        manager_.add<IDFieldCodec>(dccl_id_codec_name);
+        manager_->add<IDFieldCodec>(dccl_id_codec_name);
     }
 
     /// \brief Destructor
     virtual ~Codec();
 
-    Codec(const Codec&) = delete;
     Codec& operator=(const Codec&) = delete;
 
+    /// \brief Create a copy of this Codec that is ready to use without repeating the codec setup or load() calls.
+    ///
+    /// The clone shares this Codec's field codec registry (manager()), including any codecs added by load_library(). This avoids the cost of registering the default codecs and re-validating messages, so clones are cheap enough to create one per thread. The set of loaded messages, the ID codec name, and the crypto and strict settings are copied, so later settings changes, load() and unload() only change which messages (and how) the Codec they are called on encodes and decodes. However, what load() computes (message hashes, codec lookups, message plans and compiled dynamic conditions) is cached in the shared registry: unload() discards these caches for every Codec sharing it (they are rebuilt on next use). unload() may be called on one Codec while others sharing the registry are encoding or decoding (as long as they do not use the unloaded Descriptor if it is then destroyed). load() validates messages using the shared field codecs, so it must not be called while any Codec sharing the registry is in use. Changes to the shared registry (manager().add(), load_library(), etc.) are seen by every Codec sharing it, and must not be made while any of them is in use.
+    /// \return The new Codec
+    std::unique_ptr<Codec> clone() const { return std::unique_ptr<Codec>(new Codec(*this)); }
+
     /// \brief Add codecs and/or load messages present in the given shared library handle
     ///
     /// Codecs and messages must be loaded within the shared library using a C function
@@ -170,6 +186,12 @@ class Codec
         set_crypto_passphrase(passphrase, s_ids);
     }
 
+    /// \brief Set the number of threads used to encrypt the messages of a batch (see encode_batch())
+    ///
+    /// Each message is encrypted with its own header-derived IV, so the messages of a batch can be encrypted independently. Large batches are split into chunks of messages that are encrypted concurrently (the calling thread takes one of the chunks). The extra `threads - 1` threads are started here and then reused by every batch (including those of clones of this Codec). Ignored if DCCL was compiled without thread support or Crypto++.
+    /// \param threads Maximum number of threads to use (1, the default, encrypts on the calling thread only)
+    void set_crypto_threads(unsigned threads);
+
     /// \brief Set "strict" mode where a dccl::OutOfRangeException will be thrown for encode if the value(s) provided are out of range
     ///
     /// \param mode "true" sets strict mode, "false" disables strict mode
@@ -180,6 +202,11 @@ class Codec
     /// \param num_chars Character limit for line widths on console outputs
     void set_console_width(unsigned num_chars) { console_width_ = num_chars; }
 
+    /// \brief Record the offset, length and codec of every field encoded or decoded by this Codec
+    ///
+    /// \param trace Buffer to record into (may be shared by several Codecs), or nullptr (the default) to disable tracing. See TraceBuffer.
+    void set_trace(std::shared_ptr<TraceBuffer> trace) { trace_ = std::move(trace); }
+
     //@}
 
     /// \name Informational Methods.
@@ -278,10 +305,11 @@ class Codec
     /// dccl id with the message descriptor corresponding to that of msg will be used
     /// \throw Exception if message cannot be encoded.
     void encode(std::string* bytes, const google::protobuf::Message& msg, bool header_only = false,
-                int user_id = -1);
+                int user_id = -1) const;
 
     /// \brief Encodes a DCCL message
     ///
+    /// If `bytes` is aligned for 64-bit words (and the host is little-endian), the head and body are encoded directly into `bytes`. Otherwise they are encoded into a Bitset that is retained (per thread) between calls, and then copied once into `bytes`. The body is then encrypted (if applicable) in place in `bytes`, without an intermediate ciphertext string. If encoding fails, the contents of `bytes` are unspecified.
     /// \param bytes Output buffer to store encoded msg
     /// \param max_len Maximum size of output buffer
     /// \param msg Message to encode (must already have been validated)
@@ -291,7 +319,72 @@ class Codec
     /// \throw Exception if message cannot be encoded.
     /// \return size of encoded message
     size_t encode(char* bytes, size_t max_len, const google::protobuf::Message& msg,
-                  bool header_only = false, int user_id = -1);
+                  bool header_only = false, int user_id = -1) const;
+
+    /// \brief Encodes a DCCL message only if it fits within a byte budget
+    ///
+    /// The size is checked while encoding: as soon as the encoded bits exceed `max_bytes` encoding stops, so an oversized message is rejected without being fully encoded (or sized separately beforehand). The size of a message that fits is returned, so it can be used in place of a separate call to size() (e.g. to reduce the budget left for the next message in a frame).
+    /// \param bytes Pointer to byte string to append the encoded msg to (unchanged if the message does not fit)
+    /// \param msg Message to encode (must already have been validated)
+    /// \param max_bytes Maximum size of the encoded message in bytes
+    /// \param header_only If true, only encode the header
+    /// \param user_id Custom user specified dccl id (see encode())
+    /// \throw Exception if message cannot be encoded for any reason other than its size.
+    /// \return number of bytes appended to `bytes` (the encoded size of `msg`), or 0 if the message does not fit
+    std::size_t encode_if_fits(std::string* bytes, const google::protobuf::Message& msg,
+                               std::size_t max_bytes, bool header_only = false,
+                               int user_id = -1) const;
+
+    /// \brief Encodes a batch of DCCL messages into one contiguous byte string
+    ///
+    /// Per-type setup (codec lookup, load check, DCCL ID header) is done once for each run of messages of the same type rather than once per message, so this is considerably cheaper than calling encode() in a loop when encoding many messages of the same type (e.g. building a modem queue). If encryption is enabled, the bodies are encrypted together in a single pass after all the messages are encoded (optionally using several threads, see set_crypto_threads()).
+    /// \tparam MessagePtrIterator Iterator whose value type is (convertible to) `const google::protobuf::Message*`
+    /// \param first Iterator to the first message pointer to encode
+    /// \param last Iterator past the last message pointer to encode
+    /// \param bytes Byte string to which the encoded messages are appended, one after another
+    /// \param offsets Cleared and then filled with the offset into `bytes` of the start of each encoded message, followed by the final size of `bytes` (so message i is `bytes->substr((*offsets)[i], (*offsets)[i+1] - (*offsets)[i])`)
+    /// \param header_only If true, only encode the header of each message
+    /// \param user_id Custom user specified dccl id to use for every message (see encode())
+    /// \throw Exception if any message cannot be encoded. The messages encoded prior to the failure remain in `bytes` and `offsets`.
+    template <typename MessagePtrIterator>
+    void encode_batch(MessagePtrIterator first, MessagePtrIterator last, std::string* bytes,
+                      std::vector<std::size_t>* offsets, bool header_only = false,
+                      int user_id = -1) const
+    {
+        EncodeTypeInfo type_info;
+        std::vector<CryptJob> crypt_jobs;
+        offsets->clear();
+        offsets->push_back(bytes->size());
+        try
+        {
+            for (; first != last; ++first)
+            {
+                const google::protobuf::Message* msg = *first;
+                encode_append(bytes, *msg, header_only, user_id, &type_info, &crypt_jobs);
+                offsets->push_back(bytes->size());
+            }
+        }
+        catch (...)
+        {
+            crypt_batch(bytes, crypt_jobs);
+            throw;
+        }
+        crypt_batch(bytes, crypt_jobs);
+    }
+
+    /// \brief Encodes a batch of DCCL messages into one contiguous byte string (std::vector overload)
+    ///
+    /// \param msgs Messages to encode
+    /// \param bytes Byte string to which the encoded messages are appended
+    /// \param offsets Offsets of each encoded message within `bytes`, plus the end offset (see the iterator overload)
+    /// \param header_only If true, only encode the header of each message
+    /// \param user_id Custom user specified dccl id to use for every message (see encode())
+    void encode_batch(const std::vector<const google::protobuf::Message*>& msgs,
+                      std::string* bytes, std::vector<std::size_t>* offsets,
+                      bool header_only = false, int user_id = -1) const
+    {
+        encode_batch(msgs.begin(), msgs.end(), bytes, offsets, header_only, user_id);
+    }
 
     /// \brief Decode a DCCL message when the type is known at compile time.
     ///
@@ -303,7 +396,7 @@ class Codec
     /// \return Actual end of decoding, allowing the next message to be decoded starting at this location
     template <typename CharIterator, typename ProtobufMessage>
     CharIterator decode(CharIterator begin, CharIterator end, ProtobufMessage* msg,
-                        bool header_only = false);
+                        bool header_only = false) const;
 
     /// \brief Decode a DCCL message when the type is known at compile time.
     ///
@@ -312,7 +405,7 @@ class Codec
     /// \param header_only If true, only decode the header (do not try to decrypt (if applicable) and decode the message body)
     /// \throw Exception if message cannot be decoded.
     template <typename ProtobufMessage>
-    void decode(const std::string& bytes, ProtobufMessage* msg, bool header_only = false)
+    void decode(const std::string& bytes, ProtobufMessage* msg, bool header_only = false) const
     {
         decode(bytes.begin(), bytes.end(), msg, header_only);
     }
@@ -322,7 +415,7 @@ class Codec
     /// \param bytes encoded message to decode (must already have been validated) which will have the used bytes stripped from the front of the encoded message
     /// \param msg Pointer to any Google Protobuf Message generated by protoc (i.e. subclass of google::protobuf::Message). The decoded message will be written here.
     /// \throw Exception if message cannot be decoded.
-    template <typename ProtobufMessage> void decode(std::string* bytes, ProtobufMessage* msg)
+    template <typename ProtobufMessage> void decode(std::string* bytes, ProtobufMessage* msg) const
     {
         decode(*bytes, msg);
         unsigned last_size = size(*msg);
@@ -337,7 +430,7 @@ class Codec
     /// \throw Exception if message cannot be decoded
     /// \return pointer to decoded message (a google::protobuf::Message). You are responsible for deleting the memory used by this pointer, so we recommend using a smart pointer here (e.g. std::shared_ptr or the C++11 equivalent). This message can be examined using the Google Reflection/Descriptor API.
     template <typename GoogleProtobufMessagePointer>
-    GoogleProtobufMessagePointer decode(const std::string& bytes, bool header_only = false);
+    GoogleProtobufMessagePointer decode(const std::string& bytes, bool header_only = false) const;
 
     /// \brief An alterative form for decoding messages for message types <i>not</i> known at compile-time ("dynamic"), where the bytes used are stripped from the front of the encoded message.
     ///
@@ -346,7 +439,30 @@ class Codec
     /// \throw Exception if message cannot be decoded
     /// \return pointer to decoded message (a google::protobuf::Message). You are responsible for deleting the memory used by this pointer, so we recommend using a smart pointer here (e.g. std::shared_ptr or the C++11 equivalent). This message can be examined using the Google Reflection/Descriptor API.
     template <typename GoogleProtobufMessagePointer>
-    GoogleProtobufMessagePointer decode(std::string* bytes);
+    GoogleProtobufMessagePointer decode(std::string* bytes) const;
+
+    /// \brief Decode all the DCCL messages in a buffer of back-to-back encoded messages (e.g. a modem packet built with encode_batch() or successive calls to encode()), with types <i>not</i> known at compile-time.
+    ///
+    /// The buffer is walked once from front to back, and each message only reads (and, if encrypted, decrypts) at most its type's maximum encoded size, so this is linear in the size of the buffer (unlike repeatedly calling decode(std::string*), which erases the front of the string after each message). All message types must have been loaded and must not use `omit_id`, as the DCCL ID is used to determine the type of each message.
+    /// \param begin Iterator to the first byte of the first encoded message
+    /// \param end Iterator pointing to the past-the-end byte of the last encoded message
+    /// \param arena Google Protobuf Arena on which to allocate the decoded messages, which are then owned by (and freed along with) the arena. If nullptr, the messages are allocated on the heap and deleting them is up to the caller.
+    /// \throw Exception if any message cannot be decoded (any messages already allocated on the heap are deleted first).
+    /// \return Vector of (decoded message, offset of the start of this message's bytes from begin) pairs, in the order they occur in the buffer
+    template <typename CharIterator>
+    std::vector<std::pair<google::protobuf::Message*, std::size_t>>
+    decode_all(CharIterator begin, CharIterator end, google::protobuf::Arena* arena) const;
+
+    /// \brief Decode all the DCCL messages in a string of back-to-back encoded messages (see the iterator overload).
+    ///
+    /// \param bytes Back-to-back encoded messages
+    /// \param arena Google Protobuf Arena on which to allocate the decoded messages (or nullptr for the heap)
+    /// \return Vector of (decoded message, offset of the start of this message within bytes) pairs
+    std::vector<std::pair<google::protobuf::Message*, std::size_t>>
+    decode_all(const std::string& bytes, google::protobuf::Arena* arena) const
+    {
+        return decode_all(bytes.begin(), bytes.end(), arena);
+    }
 
     /// \brief Provides the encoded size (in bytes) of msg. This is useful if you need to know the size of a message before encoding it (encoding it is generally much more expensive than calling this method)
     ///
@@ -354,7 +470,7 @@ class Codec
     /// \param user_id Custom user-specified dccl id to identify a message, if user_id is not specified or <0, then first found
     /// dccl id with the message descriptor corresponding to that of msg will be used
     /// \return Encoded (using DCCL) size in bytes
-    unsigned size(const google::protobuf::Message& msg, int user_id = -1);
+    unsigned size(const google::protobuf::Message& msg, int user_id = -1) const;
 
     /// \brief Provides the encoded maximum size (in bytes) of msg.
     ///
@@ -389,22 +505,63 @@ class Codec
         return "dccl.default" + std::to_string(version);
     }
 
-    FieldCodecManagerLocal& manager() { return manager_; }
+    /// \brief The field codec registry used by this Codec (shared with any clones, see clone())
+    FieldCodecManagerLocal& manager() { return *manager_; }
 
   private:
-    void encode_internal(const google::protobuf::Message& msg, bool header_only,
-                         Bitset& header_bits, Bitset& body_bits, int user_id);
+    // per-type state for encoding, computed once for a run of messages of the same type
+    struct EncodeTypeInfo
+    {
+        const google::protobuf::Descriptor* desc{nullptr};
+        int user_id{-1};
+        int32 dccl_id{0};
+        // owned by the manager
+        FieldCodecBase* codec{nullptr};
+        // encoded DCCL ID (empty if omit_id)
+        Bitset id_bits;
+    };
+
+    // fills in type_info for desc, unless it already holds it
+    void encode_type_info(const google::protobuf::Descriptor* desc, int user_id,
+                          EncodeTypeInfo* type_info) const;
+    // encodes the header (padded to a whole number of bytes), followed by the body (unless header_only) into bits
+    void encode_internal(const google::protobuf::Message& msg, bool header_only, Bitset& bits,
+                         std::size_t* head_byte_size, int user_id, EncodeTypeInfo* type_info) const;
+    // location within a byte string of an encoded message whose body is still to be encrypted
+    struct CryptJob
+    {
+        std::size_t begin;
+        std::size_t head_byte_size;
+        std::size_t body_byte_size;
+    };
+
+    // appends the encoded msg to bytes. If crypt_jobs is given, the body is left unencrypted and its location is appended to crypt_jobs instead (to be passed to crypt_batch())
+    void encode_append(std::string* bytes, const google::protobuf::Message& msg, bool header_only,
+                       int user_id, EncodeTypeInfo* type_info,
+                       std::vector<CryptJob>* crypt_jobs = nullptr) const;
+    // writes the already encoded bits to bytes (which must be at least ceil(bits.size() / 8) long) and encrypts the body in place (unless encrypt_body is false)
+    void encode_finalize(char* bytes, const Bitset& bits, std::size_t head_byte_size,
+                         bool header_only, int32 dccl_id, bool encrypt_body = true) const;
+    // encrypts the bodies of all the messages in crypt_jobs in place, split across crypto_pool_ (if set) and the calling thread
+    void crypt_batch(std::string* bytes, const std::vector<CryptJob>& crypt_jobs) const;
+    // true if the body of messages with this id is encrypted
+    bool body_encrypted(int32 dccl_id) const
+    {
+        return !crypto_key_.empty() && !skip_crypto_ids_.count(dccl_id);
+    }
     std::string get_all_error_fields_in_message(const google::protobuf::Message& msg,
-                                                uint8_t depth = 1);
+                                                uint8_t depth = 1) const;
 
-    void encrypt(std::string* s, const std::string& nonce);
-    void decrypt(std::string* s, const std::string& nonce);
+    void encrypt(std::string* s, const std::string& nonce) const;
+    void decrypt(std::string* s, const std::string& nonce) const;
+    // encrypts (or decrypts, as AES-CTR is symmetric) s[0, len) in place
+    void crypt_in_place(char* s, std::size_t len, const char* nonce, std::size_t nonce_len) const;
 
     void set_default_codecs();
 
     std::shared_ptr<FieldCodecBase> id_codec() const
     {
-        return manager_.find(google::protobuf::FieldDescriptor::TYPE_UINT32, DCCL_VERSION_MAJOR,
+        return manager_->find(google::protobuf::FieldDescriptor::TYPE_UINT32, DCCL_VERSION_MAJOR,
                              id_codec_);
     }
 
@@ -438,24 +595,38 @@ class Codec
     // SHA256 hash of the crypto passphrase
     std::string crypto_key_;
 
+    // AES key schedule for crypto_key_, set up once by set_crypto_passphrase() and never modified afterwards (so it is shared with clones)
+    std::shared_ptr<const internal::CipherContext> cipher_;
+
     // strict mode setting
     bool strict_{false};
 
     // console outputting format width
     unsigned console_width_{60};
 
+    // records encoded/decoded fields, if set
+    std::shared_ptr<TraceBuffer> trace_;
+
     // set of DCCL IDs *not* to encrypt
     std::set<int32> skip_crypto_ids_;
 
+    // worker threads used by crypt_batch(), if set_crypto_threads() was given more than one thread (shared with clones)
+    std::shared_ptr<internal::ThreadPool> crypto_pool_;
+
     // maps `dccl.id`s onto Message Descriptors
     std::map<int32, const google::protobuf::Descriptor*> id2desc_;
     std::string id_codec_;
 
-    std::vector<void*> dl_handles_;
+    // shared libraries opened by load_library(), closed when the last Codec sharing them is destroyed
+    std::shared_ptr<std::vector<void*>> dl_handles_{std::make_shared<std::vector<void*>>()};
 
     std::string build_guard_for_console_output(std::string& base, char guard_char) const;
 
-    FieldCodecManagerLocal manager_;
+    // used by clone()
+    Codec(const Codec&) = default;
+
+    // field codec registry, shared with clones
+    std::shared_ptr<FieldCodecManagerLocal> manager_{std::make_shared<FieldCodecManagerLocal>()};
 
     // current omit_id placeholder DCCL Id (starts at -1 and decrements)
     int32 omit_id_placeholder_id_{-1};
@@ -472,7 +643,7 @@ inline std::ostream& operator<<(std::ostream& os, const Codec& codec)
 
 template <typename GoogleProtobufMessagePointer>
 GoogleProtobufMessagePointer dccl::Codec::decode(const std::string& bytes,
-                                                 bool header_only /* = false */)
+                                                 bool header_only /* = false */) const
 {
     int32 this_id = id(bytes);
 
@@ -488,7 +659,7 @@ GoogleProtobufMessagePointer dccl::Codec::decode(const std::string& bytes,
 }
 
 template <typename GoogleProtobufMessagePointer>
-GoogleProtobufMessagePointer dccl::Codec::decode(std::string* bytes)
+GoogleProtobufMessagePointer dccl::Codec::decode(std::string* bytes) const
 {
     int32 this_id = id(*bytes);
 
@@ -504,9 +675,48 @@ GoogleProtobufMessagePointer dccl::Codec::decode(std::string* bytes)
     return msg;
 }
 
+template <typename CharIterator>
+std::vector<std::pair<google::protobuf::Message*, std::size_t>>
+dccl::Codec::decode_all(CharIterator begin, CharIterator end,
+                        google::protobuf::Arena* arena) const
+{
+    std::vector<std::pair<google::protobuf::Message*, std::size_t>> msgs;
+    try
+    {
+        for (CharIterator it = begin; it != end;)
+        {
+            int32 this_id = id(it, end);
+
+            auto desc_it = id2desc_.find(this_id);
+            if (desc_it == id2desc_.end())
+                throw(Exception("Message id " + std::to_string(this_id) +
+                                " has not been loaded. Call load() before decoding this type."));
+
+            google::protobuf::Message* msg =
+                dccl::DynamicProtobufManager::new_protobuf_message(desc_it->second, arena);
+            msgs.emplace_back(msg, std::distance(begin, it));
+            CharIterator next = decode(it, end, msg);
+            if (next == it)
+                throw(Exception("Decoding message of id " + std::to_string(this_id) +
+                                " consumed no bytes; cannot continue decoding the buffer."));
+            it = next;
+        }
+    }
+    catch (...)
+    {
+        if (!arena)
+        {
+            for (auto& msg_offset : msgs) delete msg_offset.first;
+        }
+        throw;
+    }
+    return msgs;
+}
+
 template <typename CharIterator>
 dccl::int32 dccl::Codec::id(CharIterator begin, CharIterator end) const
 {
+    internal::CodecDataScope scope(*manager_);
     try
     {
         unsigned id_min_size = 0, id_max_size = 0;
@@ -536,12 +746,14 @@ dccl::int32 dccl::Codec::id(CharIterator begin, CharIterator end) const
 
 template <typename CharIterator, typename ProtobufMessage>
 CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, ProtobufMessage* msg,
-                                 bool header_only /*= false*/)
+                                 bool header_only /*= false*/) const
 {
+    internal::CodecDataScope scope(*manager_);
+    scope.data().trace_ = trace_.get();
     try
     {
         const google::protobuf::Descriptor* desc = msg->GetDescriptor();
-        int32 expected_id = id_internal(desc, -1);
+        int32 expected_id = id_internal_const(desc, -1);
         int32 received_id =
             expected_id; // if omit_id, we have to assume we have the correct type. Otherwise, overwrite if not omit_id and check
         if (!desc->options().GetExtension(dccl::msg).omit_id())
@@ -567,8 +779,8 @@ CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, ProtobufM
         dlog.is(logger::DEBUG1, logger::DECODE) && dlog << "Type name: " << desc->full_name()
                                                         << std::endl;
 
-        std::shared_ptr<FieldCodecBase> codec = manager_.find(desc);
-        std::shared_ptr<internal::FromProtoCppTypeBase> helper = manager_.type_helper().find(desc);
+        FieldCodecBase* codec = manager_->find_root_codec(desc);
+        std::shared_ptr<internal::FromProtoCppTypeBase> helper = manager_->type_helper().find(desc);
 
         CharIterator actual_end = end;
         if (codec)
@@ -591,6 +803,12 @@ CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, ProtobufM
                      << ")" << std::endl;
 
             CharIterator head_bytes_end = begin + head_size_bytes;
+            // the body can be no longer than its maximum size, so any bytes beyond that (e.g. the
+            // following messages in a buffer passed to decode_all()) are never copied or decrypted
+            using difference_type = typename std::iterator_traits<CharIterator>::difference_type;
+            CharIterator body_bytes_end =
+                head_bytes_end + std::min<difference_type>(std::distance(head_bytes_end, end),
+                                                           body_size_bytes);
             dlog.is(logger::DEBUG3, logger::DECODE) &&
                 dlog << "Unencrypted Head (hex): " << hex_encode(begin, head_bytes_end)
                      << std::endl;
@@ -606,8 +824,8 @@ CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, ProtobufM
             dlog.is(logger::DEBUG3, logger::DECODE) &&
                 dlog << "Unencrypted Head after ID bits removal (bin): " << head_bits << std::endl;
 
-            internal::MessageStack msg_stack(manager_.codec_data().root_message_,
-                                             manager_.codec_data().message_data_);
+            internal::MessageStack msg_stack(scope.data().root_message_,
+                                             scope.data().message_data_);
             msg_stack.push(msg->GetDescriptor());
 
             codec->base_decode(&head_bits, msg, HEAD);
@@ -623,14 +841,14 @@ CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, ProtobufM
             else
             {
                 dlog.is(logger::DEBUG3, logger::DECODE) &&
-                    dlog << "Encrypted Body (hex): " << hex_encode(head_bytes_end, end)
+                    dlog << "Encrypted Body (hex): " << hex_encode(head_bytes_end, body_bytes_end)
                          << std::endl;
 
                 Bitset body_bits;
-                if (!crypto_key_.empty() && !skip_crypto_ids_.count(received_id))
+                if (body_encrypted(received_id))
                 {
                     std::string head_bytes(begin, head_bytes_end);
-                    std::string body_bytes(head_bytes_end, end);
+                    std::string body_bytes(head_bytes_end, body_bytes_end);
                     decrypt(&body_bytes, head_bytes);
                     dlog.is(logger::DEBUG3, logger::DECODE) &&
                         dlog << "Unencrypted Body (hex): " << hex_encode(body_bytes) << std::endl;
@@ -639,9 +857,9 @@ CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, ProtobufM
                 else
                 {
                     dlog.is(logger::DEBUG3, logger::DECODE) &&
-                        dlog << "Unencrypted Body (hex): " << hex_encode(head_bytes_end, end)
-                             << std::endl;
-                    body_bits.from_byte_stream(head_bytes_end, end);
+                        dlog << "Unencrypted Body (hex): "
+                             << hex_encode(head_bytes_end, body_bytes_end) << std::endl;
+                    body_bits.from_byte_stream(head_bytes_end, body_bytes_end);
                 }
 
                 dlog.is(logger::DEBUG3, logger::DECODE) &&
@@ -651,7 +869,7 @@ CharIterator dccl::Codec::decode(CharIterator begin, CharIterator end, ProtobufM
                 dlog.is(logger::DEBUG2, logger::DECODE) &&
                     dlog << "after header & body decode, message is: " << *msg << std::endl;
 
-                actual_end = end - body_bits.size() / BITS_IN_BYTE;
+                actual_end = body_bytes_end - body_bits.size() / BITS_IN_BYTE;
             }
         }
         else
@@ -47,9 +47,22 @@ dccl::Bitset dccl::v2::DefaultBoolCodec::encode(const bool& wire_value)
     return Bitset(size(), use_required() ? wire_value : wire_value + 1);
 }
 
-bool dccl::v2::DefaultBoolCodec::decode(Bitset* bits)
+bool dccl::v2::DefaultBoolCodec::decode(Bitset* bits) { return decode_value(bits->to_ulong()); }
+
+void dccl::v2::DefaultBoolCodec::encode(BitWriter* writer) { writer->write_zeros(size()); }
+
+void dccl::v2::DefaultBoolCodec::encode(BitWriter* writer, const bool& wire_value)
+{
+    writer->write(use_required() ? wire_value : wire_value + 1, size());
+}
+
+bool dccl::v2::DefaultBoolCodec::decode(BitReader* reader)
+{
+    return decode_value(reader->read(size()));
+}
+
+bool dccl::v2::DefaultBoolCodec::decode_value(unsigned long t)
 {
-    unsigned long t = bits->to_ulong();
     if (use_required())
     {
         return t;
@@ -147,6 +160,37 @@ std::string dccl::v2::DefaultStringCodec::decode(Bitset* bits)
     }
 }
 
+void dccl::v2::DefaultStringCodec::encode(BitWriter* writer) { writer->write_zeros(min_size()); }
+
+void dccl::v2::DefaultStringCodec::encode(BitWriter* writer, const std::string& wire_value)
+{
+    if (wire_value.size() > dccl_field_options().max_length())
+    {
+        // use the Bitset version to handle truncation (and logging thereof)
+        writer->write(encode(wire_value));
+        return;
+    }
+
+    writer->write(wire_value.length(), min_size());
+    writer->write_bytes(wire_value);
+}
+
+std::string dccl::v2::DefaultStringCodec::decode(BitReader* reader)
+{
+    unsigned value_length = reader->read(min_size());
+
+    if (value_length)
+    {
+        dccl::dlog.is(DEBUG2) && dccl::dlog << "Length of string is = " << value_length
+                                            << std::endl;
+        return reader->read_bytes(value_length);
+    }
+    else
+    {
+        throw NullValueException();
+    }
+}
+
 unsigned dccl::v2::DefaultStringCodec::size() { return min_size(); }
 
 unsigned dccl::v2::DefaultStringCodec::size(const std::string& wire_value)
@@ -197,6 +241,38 @@ dccl::Bitset dccl::v2::DefaultBytesCodec::encode(const std::string& wire_value)
     return bits;
 }
 
+void dccl::v2::DefaultBytesCodec::encode(BitWriter* writer) { writer->write_zeros(min_size()); }
+
+void dccl::v2::DefaultBytesCodec::encode(BitWriter* writer, const std::string& wire_value)
+{
+    const unsigned max_length = dccl_field_options().max_length();
+    if (wire_value.size() > max_length && this->strict())
+        throw(dccl::OutOfRangeException(std::string("Bytes too long for field: ") +
+                                            FieldCodecBase::this_field()->DebugString(),
+                                        this->this_field(), this->this_descriptor()));
+
+    if (!use_required())
+        writer->write_bit(true); // presence bit
+
+    if (wire_value.size() >= max_length)
+    {
+        writer->write_bytes(wire_value.substr(0, max_length));
+    }
+    else
+    {
+        writer->write_bytes(wire_value);
+        writer->write_zeros((max_length - wire_value.size()) * BITS_IN_BYTE);
+    }
+}
+
+std::string dccl::v2::DefaultBytesCodec::decode(BitReader* reader)
+{
+    if (!use_required() && !reader->read_bit())
+        throw NullValueException();
+
+    return reader->read_bytes(dccl_field_options().max_length());
+}
+
 unsigned dccl::v2::DefaultBytesCodec::size() { return min_size(); }
 
 unsigned dccl::v2::DefaultBytesCodec::size(const std::string& /*wire_value*/) { return max_size(); }
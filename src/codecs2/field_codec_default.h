@@ -28,6 +28,8 @@
 #define DCCLFIELDCODECDEFAULT20110322H
 
 #include <chrono>
+#include <typeinfo>
+#include <unordered_map>
 
 #include <google/protobuf/descriptor.h>
 
@@ -53,47 +55,40 @@ class DefaultNumericFieldCodec : public TypedFixedFieldCodec<WireType, FieldType
   public:
     virtual double max()
     {
-        DynamicConditions& dc = this->dynamic_conditions(this->this_field());
-
-        double static_max = this->dccl_field_options().max();
-        if (dc.has_max())
+        const Bounds& b = bounds();
+        if (b.dynamic_max)
         {
+            DynamicConditions& dc = this->dynamic_conditions(this->this_field());
             dc.regenerate(this->this_message(), this->root_message());
             // don't let dynamic conditions breach static bounds
-            return std::max(this->dccl_field_options().min(), std::min(dc.max(), static_max));
+            return std::max(b.static_min, std::min(dc.max(), b.static_max));
         }
         else
         {
-            return static_max;
+            return b.static_max;
         }
     }
 
     virtual double min()
     {
-        DynamicConditions& dc = this->dynamic_conditions(this->this_field());
-        double static_min = this->dccl_field_options().min();
-        if (dc.has_min())
+        const Bounds& b = bounds();
+        if (b.dynamic_min)
         {
+            DynamicConditions& dc = this->dynamic_conditions(this->this_field());
             dc.regenerate(this->this_message(), this->root_message());
 
             // don't let dynamic conditions breach static bounds
-            return std::min(this->dccl_field_options().max(), std::max(dc.min(), static_min));
+            return std::min(b.static_max, std::max(dc.min(), b.static_min));
         }
         else
         {
-            return static_min;
+            return b.static_min;
         }
     }
 
     virtual double precision() { return FieldCodecBase::dccl_field_options().precision(); }
 
-    virtual double resolution()
-    {
-        if (FieldCodecBase::dccl_field_options().has_precision())
-            return std::pow(10.0, -precision());
-        // If none is set returns the default resolution (=1)
-        return FieldCodecBase::dccl_field_options().resolution();
-    }
+    virtual double resolution() { return bounds().resolution; }
 
     void validate() override
     {
@@ -114,6 +109,9 @@ class DefaultNumericFieldCodec : public TypedFixedFieldCodec<WireType, FieldType
 
     void validate_numeric_bounds()
     {
+        // refresh the cached bounds in case this descriptor address has been reused
+        update_bounds();
+
         // ensure given max and min fit within WireType ranges
         FieldCodecBase::require(static_cast<WireType>(min()) >=
                                     std::numeric_limits<WireType>::lowest(),
@@ -164,55 +162,244 @@ class DefaultNumericFieldCodec : public TypedFixedFieldCodec<WireType, FieldType
 
     Bitset encode(const WireType& value) override
     {
-        dccl::dlog.is(dccl::logger::DEBUG2, dccl::logger::ENCODE) &&
-            dlog << "Encode " << value << " with bounds: [" << min() << "," << max() << "]"
-                 << std::endl;
+        Bitset encoded;
+        encoded.from(encode_value(value), size());
+        return encoded;
+    }
+
+    WireType decode(Bitset* bits) override
+    {
+        // The line below SHOULD BE:
+        // dccl::uint64 t = bits->to<dccl::uint64>();
+        // But GCC3.3 requires an explicit template modifier on the method.
+        // See, e.g., http://gcc.gnu.org/bugzilla/show_bug.cgi?id=10959
+        return decode_value((bits->template to<dccl::uint64>)());
+    }
+
+    bool streaming() override { return typeid(*this) == typeid(DefaultNumericFieldCodec); }
+
+    void encode(BitWriter* writer) override { writer->write_zeros(size()); }
+
+    void encode(BitWriter* writer, const WireType& value) override
+    {
+        writer->write(encode_value(value), size());
+    }
+
+    WireType decode(BitReader* reader) override { return decode_value(reader->read(size())); }
+
+    // bring size(const WireType&) into scope so callers can access it
+    using TypedFixedFieldCodec<WireType, FieldType>::size;
+
+    unsigned size() override
+    {
+        const Bounds& b = bounds();
+        if (b.fixed)
+            return FieldCodecBase::use_required() ? b.size_required : b.size_optional;
+
+        // if not required field, leave one value for unspecified (always encoded as 0)
+        unsigned NULL_VALUE = FieldCodecBase::use_required() ? 0 : 1;
+
+        return dccl::ceil_log2((max() - min()) / resolution() + 1 + NULL_VALUE);
+    }
 
-        // round first, before checking bounds
-        double res = resolution();
-        WireType wire_value = dccl::quantize(value, res);
+  private:
+    /// \brief Values derived from the (dccl.field) options of a single field, computed once per field
+    struct Bounds
+    {
+        double static_min{0};
+        double static_max{0};
+        double resolution{1};
+        bool dynamic_min{false};
+        bool dynamic_max{false};
+
+        // true if min(), max() and resolution() are constant for this field, in which case the members below are valid
+        bool fixed{false};
+        WireType quantized_min{};
+        unsigned size_required{0};
+        unsigned size_optional{0};
+        // resolution if resolution >= 1, otherwise 1 / resolution
+        double scale{1};
+
+        // true for an integral WireType with an integral resolution, which is encoded without any floating point
+        bool integer{false};
+        WireType integer_min{};
+        WireType integer_max{};
+        dccl::uint64 step{1};
+        // log2(step) if step is a power of two, otherwise -1
+        int step_shift{-1};
+    };
+
+    using IsIntegral = typename std::is_integral<WireType>::type;
+
+    // bounds_ is only modified by validate() (i.e. Codec::load(), which must not be called while the Codec is in use), so it is read without locking
+    const Bounds& bounds()
+    {
+        auto it = bounds_.find(this->this_field());
+        if (it != bounds_.end())
+            return it->second;
+
+        // field that has not been validated: compute the bounds without caching them
+        thread_local Bounds unvalidated_bounds;
+        unvalidated_bounds = compute_bounds();
+        return unvalidated_bounds;
+    }
 
-        // check bounds
-        if (wire_value < min() || wire_value > max())
+    void update_bounds() { bounds_[this->this_field()] = compute_bounds(); }
+
+    Bounds compute_bounds()
+    {
+        Bounds b;
+        dccl::DCCLFieldOptions options = FieldCodecBase::dccl_field_options();
+        b.static_min = options.min();
+        b.static_max = options.max();
+        b.dynamic_min = options.dynamic_conditions().has_min();
+        b.dynamic_max = options.dynamic_conditions().has_max();
+
+        // If none is set uses the default resolution (=1)
+        b.resolution =
+            options.has_precision() ? std::pow(10.0, -precision()) : options.resolution();
+
+        // subclasses may override min(), max() or resolution(), so only the exact type can use the cached values directly
+        b.fixed = typeid(*this) == typeid(DefaultNumericFieldCodec) && !b.dynamic_min &&
+                  !b.dynamic_max;
+        if (b.fixed)
         {
-            // strict mode
-            if (this->strict())
-                throw(dccl::OutOfRangeException(
-                    std::string("Value exceeds min/max bounds for field: ") +
-                        FieldCodecBase::this_field()->DebugString(),
-                    this->this_field(), this->this_descriptor()));
-            // non-strict (default): if out-of-bounds, send as zeros
-            else
-                return Bitset(size());
+            b.quantized_min = dccl::quantize(static_cast<WireType>(b.static_min), b.resolution);
+            double range = (b.static_max - b.static_min) / b.resolution;
+            b.size_required = dccl::ceil_log2(range + 1);
+            b.size_optional = dccl::ceil_log2(range + 2);
+            b.scale = b.resolution >= 1 ? b.resolution : 1.0 / b.resolution;
+            set_integer_bounds(&b, IsIntegral());
         }
+        return b;
+    }
 
-        // calculate the encoded value: remove the minimum, scale for the resolution, cast to int.
-        wire_value -= dccl::quantize(static_cast<WireType>(min()), res);
-        if (res >= 1)
-            wire_value /= res;
+    static void set_integer_bounds(Bounds* /*b*/, std::false_type) {}
+
+    static void set_integer_bounds(Bounds* b, std::true_type)
+    {
+        // 2^digits == numeric_limits<WireType>::max() + 1
+        const double limit = std::ldexp(1.0, std::numeric_limits<WireType>::digits);
+        if (b->resolution < 1 || b->resolution != std::floor(b->resolution) ||
+            b->resolution >= limit || b->static_min < std::numeric_limits<WireType>::lowest() ||
+            b->static_max >= limit)
+            return;
+
+        b->integer = true;
+        // values are integers, so these compare identically to the (double) min and max
+        b->integer_min = static_cast<WireType>(std::ceil(b->static_min));
+        b->integer_max = static_cast<WireType>(std::floor(b->static_max));
+        b->step = static_cast<dccl::uint64>(b->resolution);
+        b->step_shift = ((b->step & (b->step - 1)) == 0) ? dccl::ceil_log2(b->step) : -1;
+    }
+
+    // integer equivalent of the floating point encode in encode_value(); returns false if out of range
+    static bool encode_integer(WireType value, const Bounds& b, dccl::uint64* uint_value,
+                               std::true_type)
+    {
+        // round first, before checking bounds (same as dccl::quantize for integers)
+        const auto step = static_cast<WireType>(b.step);
+        WireType remainder = value % step;
+        value -= remainder;
+        if (remainder >= step - remainder)
+        {
+            if (value > std::numeric_limits<WireType>::max() - step)
+                return false;
+            value += step;
+        }
+
+        if (value < b.integer_min || value > b.integer_max)
+            return false;
+
+        // unsigned subtraction is exact even when the signed difference would overflow
+        dccl::uint64 offset =
+            static_cast<dccl::uint64>(value) - static_cast<dccl::uint64>(b.quantized_min);
+        *uint_value = (b.step_shift >= 0) ? (offset >> b.step_shift) : (offset / b.step);
+        return true;
+    }
+
+    static bool encode_integer(WireType, const Bounds&, dccl::uint64*, std::false_type)
+    {
+        return false;
+    }
+
+    static WireType decode_integer(dccl::uint64 uint_value, const Bounds& b, std::true_type)
+    {
+        dccl::uint64 offset =
+            (b.step_shift >= 0) ? (uint_value << b.step_shift) : (uint_value * b.step);
+        return static_cast<WireType>(offset + static_cast<dccl::uint64>(b.quantized_min));
+    }
+
+    static WireType decode_integer(dccl::uint64, const Bounds&, std::false_type)
+    {
+        return WireType();
+    }
+
+    dccl::uint64 out_of_range()
+    {
+        // strict mode
+        if (this->strict())
+            throw(dccl::OutOfRangeException(std::string("Value exceeds min/max bounds for field: ") +
+                                                FieldCodecBase::this_field()->DebugString(),
+                                            this->this_field(), this->this_descriptor()));
+        // non-strict (default): if out-of-bounds, send as zeros
         else
-            wire_value *= (1.0 / res);
-        auto uint_value = static_cast<dccl::uint64>(dccl::round(wire_value, 0));
+            return 0;
+    }
+
+    // returns the unsigned integer to put on the wire for `value`
+    dccl::uint64 encode_value(const WireType& value)
+    {
+        const Bounds& b = bounds();
+        const double min_value = b.fixed ? b.static_min : min();
+        const double max_value = b.fixed ? b.static_max : max();
+
+        dccl::dlog.is(dccl::logger::DEBUG2, dccl::logger::ENCODE) &&
+            dlog << "Encode " << value << " with bounds: [" << min_value << "," << max_value
+                 << "]" << std::endl;
+
+        dccl::uint64 uint_value = 0;
+        if (b.integer)
+        {
+            if (!encode_integer(value, b, &uint_value, IsIntegral()))
+                return out_of_range();
+        }
+        else
+        {
+            // round first, before checking bounds
+            double res = b.fixed ? b.resolution : resolution();
+            WireType wire_value = dccl::quantize(value, res);
+
+            // check bounds
+            if (wire_value < min_value || wire_value > max_value)
+                return out_of_range();
+
+            // calculate the encoded value: remove the minimum, scale for the resolution, cast to int.
+            wire_value -=
+                b.fixed ? b.quantized_min : dccl::quantize(static_cast<WireType>(min_value), res);
+            double scale = b.fixed ? b.scale : ((res >= 1) ? res : 1.0 / res);
+            if (res >= 1)
+                wire_value /= scale;
+            else
+                wire_value *= scale;
+            uint_value = static_cast<dccl::uint64>(dccl::round(wire_value, 0));
+        }
 
         // "presence" value (0)
         if (!FieldCodecBase::use_required())
             uint_value += 1;
 
-        Bitset encoded;
-        encoded.from(uint_value, size());
-        return encoded;
+        return uint_value;
     }
 
-    WireType decode(Bitset* bits) override
+    // returns the value given the unsigned integer read from the wire
+    WireType decode_value(dccl::uint64 uint_value)
     {
-        dccl::dlog.is(dccl::logger::DEBUG2, dccl::logger::DECODE) &&
-            dlog << "Decode with bounds: [" << min() << "," << max() << "]" << std::endl;
+        const Bounds& b = bounds();
 
-        // The line below SHOULD BE:
-        // dccl::uint64 t = bits->to<dccl::uint64>();
-        // But GCC3.3 requires an explicit template modifier on the method.
-        // See, e.g., http://gcc.gnu.org/bugzilla/show_bug.cgi?id=10959
-        dccl::uint64 uint_value = (bits->template to<dccl::uint64>)();
+        dccl::dlog.is(dccl::logger::DEBUG2, dccl::logger::DECODE) &&
+            dlog << "Decode with bounds: [" << (b.fixed ? b.static_min : min()) << ","
+                 << (b.fixed ? b.static_max : max()) << "]" << std::endl;
 
         if (!FieldCodecBase::use_required())
         {
@@ -221,30 +408,26 @@ class DefaultNumericFieldCodec : public TypedFixedFieldCodec<WireType, FieldType
             --uint_value;
         }
 
+        if (b.integer)
+            return decode_integer(uint_value, b, IsIntegral());
+
         auto wire_value = (WireType)uint_value;
-        double res = resolution();
+        double res = b.fixed ? b.resolution : resolution();
+        double scale = b.fixed ? b.scale : ((res >= 1) ? res : 1.0 / res);
         if (res >= 1)
-            wire_value *= res;
+            wire_value *= scale;
         else
-            wire_value /= (1.0 / res);
+            wire_value /= scale;
 
         // round values again to properly handle cases where double precision
         // leads to slightly off values (e.g. 2.099999999 instead of 2.1)
-        wire_value =
-            dccl::quantize(wire_value + dccl::quantize(static_cast<WireType>(min()), res), res);
+        WireType quantized_min =
+            b.fixed ? b.quantized_min : dccl::quantize(static_cast<WireType>(min()), res);
+        wire_value = dccl::quantize(wire_value + quantized_min, res);
         return wire_value;
     }
 
-    // bring size(const WireType&) into scope so callers can access it
-    using TypedFixedFieldCodec<WireType, FieldType>::size;
-
-    unsigned size() override
-    {
-        // if not required field, leave one value for unspecified (always encoded as 0)
-        unsigned NULL_VALUE = FieldCodecBase::use_required() ? 0 : 1;
-
-        return dccl::ceil_log2((max() - min()) / resolution() + 1 + NULL_VALUE);
-    }
+    std::unordered_map<const google::protobuf::FieldDescriptor*, Bounds> bounds_;
 };
 
 /// \brief Provides a bool encoder. Uses 1 bit if field is `required`, 2 bits if `optional`
@@ -256,9 +439,16 @@ class DefaultBoolCodec : public TypedFixedFieldCodec<bool>
     Bitset encode(const bool& wire_value) override;
     Bitset encode() override;
     bool decode(Bitset* bits) override;
+    bool streaming() override { return typeid(*this) == typeid(DefaultBoolCodec); }
+    void encode(BitWriter* writer, const bool& wire_value) override;
+    void encode(BitWriter* writer) override;
+    bool decode(BitReader* reader) override;
     unsigned size() override;
     unsigned size(const bool& wire_value) override { return size(); }
     void validate() override;
+
+  private:
+    bool decode_value(unsigned long t);
 };
 
 /// \brief Provides an variable length ASCII string encoder. Can encode strings up to 255 bytes by using a length byte preceeding the string.
@@ -270,6 +460,10 @@ class DefaultStringCodec : public TypedFieldCodec<std::string>
     Bitset encode() override;
     Bitset encode(const std::string& wire_value) override;
     std::string decode(Bitset* bits) override;
+    bool streaming() override { return typeid(*this) == typeid(DefaultStringCodec); }
+    void encode(BitWriter* writer) override;
+    void encode(BitWriter* writer, const std::string& wire_value) override;
+    std::string decode(BitReader* reader) override;
     unsigned size() override;
     unsigned size(const std::string& wire_value) override;
     unsigned max_size() override;
@@ -290,6 +484,10 @@ class DefaultBytesCodec : public TypedFieldCodec<std::string>
     Bitset encode() override;
     Bitset encode(const std::string& wire_value) override;
     std::string decode(Bitset* bits) override;
+    bool streaming() override { return typeid(*this) == typeid(DefaultBytesCodec); }
+    void encode(BitWriter* writer) override;
+    void encode(BitWriter* writer, const std::string& wire_value) override;
+    std::string decode(BitReader* reader) override;
     unsigned size() override;
     unsigned size(const std::string& wire_value) override;
     unsigned max_size() override;
@@ -304,6 +502,7 @@ class DefaultEnumCodec
   public:
     int32 pre_encode(const google::protobuf::EnumValueDescriptor* const& field_value) override;
     const google::protobuf::EnumValueDescriptor* post_decode(const int32& wire_value) override;
+    bool streaming() override { return typeid(*this) == typeid(DefaultEnumCodec); }
 
   private:
     void validate() override {}
@@ -368,6 +567,8 @@ class TimeCodecClock
     static std::function<int64()> epoch_sec_func_;
 };
 
+template <typename TimeType> class TimeCodec;
+
 typedef double time_wire_type;
 /// \brief Encodes time of day (default: second precision, but can be set with (dccl.field).precision extension)
 ///
@@ -402,6 +603,8 @@ class TimeCodecBase : public DefaultNumericFieldCodec<time_wire_type, TimeType>,
                            precision() - std::log10((double)conversion_factor));
     }
 
+    bool streaming() override { return typeid(*this) == typeid(TimeCodec<TimeType>); }
+
   private:
     void validate() override
     {
@@ -454,7 +657,17 @@ template <typename T> class StaticCodec : public TypedFixedFieldCodec<T>
 
     Bitset encode() override { return Bitset(size()); }
 
-    T decode(Bitset* /*bits*/) override
+    T decode(Bitset* /*bits*/) override { return static_value(); }
+
+    bool streaming() override { return typeid(*this) == typeid(StaticCodec); }
+
+    void encode(BitWriter* /*writer*/, const T&) override {}
+
+    void encode(BitWriter* /*writer*/) override {}
+
+    T decode(BitReader* /*reader*/) override { return static_value(); }
+
+    T static_value()
     {
         std::istringstream iss(FieldCodecBase::dccl_field_options().static_value());
         T value;
@@ -29,11 +29,19 @@
 //
 
 void dccl::v2::DefaultMessageCodec::any_encode(Bitset* bits, const dccl::any& wire_value)
+{
+    bits->clear();
+    BitWriter writer(bits);
+    any_encode_stream(&writer, wire_value);
+}
+
+void dccl::v2::DefaultMessageCodec::any_encode_stream(BitWriter* writer,
+                                                      const dccl::any& wire_value)
 {
     if (is_empty(wire_value))
-        *bits = Bitset(min_size());
+        writer->write_zeros(min_size());
     else
-        *bits = traverse_const_message<Encoder, Bitset>(wire_value);
+        traverse_const_message<Encoder>(wire_value, writer->bits());
 }
 
 unsigned dccl::v2::DefaultMessageCodec::any_size(const dccl::any& wire_value)
@@ -45,9 +53,16 @@ unsigned dccl::v2::DefaultMessageCodec::any_size(const dccl::any& wire_value)
 }
 
 void dccl::v2::DefaultMessageCodec::any_decode(Bitset* bits, dccl::any* wire_value)
+{
+    BitReader reader(bits);
+    any_decode_stream(&reader, wire_value);
+}
+
+void dccl::v2::DefaultMessageCodec::any_decode_stream(BitReader* reader, dccl::any* wire_value)
 {
     try
     {
+        Bitset* bits = reader->bits();
         auto* msg = dccl::any_cast<google::protobuf::Message*>(*wire_value);
 
         const google::protobuf::Descriptor* desc = msg->GetDescriptor();
@@ -96,6 +96,37 @@ std::string dccl::v3::DefaultStringCodec::decode(Bitset* bits)
     }
 }
 
+void dccl::v3::DefaultStringCodec::encode(BitWriter* writer) { writer->write_zeros(min_size()); }
+
+void dccl::v3::DefaultStringCodec::encode(BitWriter* writer, const std::string& wire_value)
+{
+    if (wire_value.size() > dccl_field_options().max_length())
+    {
+        // use the Bitset version to handle truncation (and logging thereof)
+        writer->write(encode(wire_value));
+        return;
+    }
+
+    writer->write(wire_value.length(), min_size());
+    writer->write_bytes(wire_value);
+}
+
+std::string dccl::v3::DefaultStringCodec::decode(BitReader* reader)
+{
+    unsigned value_length = reader->read(min_size());
+
+    if (value_length)
+    {
+        dccl::dlog.is(DEBUG2) && dccl::dlog << "Length of string is = " << value_length
+                                            << std::endl;
+        return reader->read_bytes(value_length);
+    }
+    else
+    {
+        throw NullValueException();
+    }
+}
+
 unsigned dccl::v3::DefaultStringCodec::size() { return min_size(); }
 
 unsigned dccl::v3::DefaultStringCodec::size(const std::string& wire_value)
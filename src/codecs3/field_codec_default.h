@@ -58,6 +58,7 @@ class DefaultEnumCodec
   public:
     int32 pre_encode(const google::protobuf::EnumValueDescriptor* const& field_value) override;
     const google::protobuf::EnumValueDescriptor* post_decode(const int32& wire_value) override;
+    bool streaming() override { return typeid(*this) == typeid(DefaultEnumCodec); }
     void validate() override {}
     std::size_t hash() override
     {
@@ -79,6 +80,10 @@ class DefaultStringCodec : public TypedFieldCodec<std::string>
     Bitset encode() override;
     Bitset encode(const std::string& wire_value) override;
     std::string decode(Bitset* bits) override;
+    bool streaming() override { return typeid(*this) == typeid(DefaultStringCodec); }
+    void encode(BitWriter* writer) override;
+    void encode(BitWriter* writer, const std::string& wire_value) override;
+    std::string decode(BitReader* reader) override;
     unsigned size() override;
     unsigned size(const std::string& wire_value) override;
     unsigned max_size() override;
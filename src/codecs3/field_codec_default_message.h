@@ -25,6 +25,8 @@
 #ifndef DCCLFIELDCODECDEFAULTMESSAGEV320140421H
 #define DCCLFIELDCODECDEFAULTMESSAGEV320140421H
 
+#include <typeinfo>
+
 #include "../field_codec.h"
 #include "../field_codec_manager.h"
 
@@ -37,9 +39,14 @@ namespace v3
 /// \brief Provides the default codec for encoding a base Google Protobuf message or an embedded message by calling the appropriate field codecs for every field.
 class DefaultMessageCodec : public FieldCodecBase
 {
+  public:
+    bool streaming() override { return typeid(*this) == typeid(DefaultMessageCodec); }
+
   private:
     void any_encode(Bitset* bits, const dccl::any& wire_value) override;
     void any_decode(Bitset* bits, dccl::any* wire_value) override;
+    void any_encode_stream(BitWriter* writer, const dccl::any& wire_value) override;
+    void any_decode_stream(BitReader* reader, dccl::any* wire_value) override;
     unsigned max_size() override;
     unsigned min_size() override;
     unsigned any_size(const dccl::any& wire_value) override;
@@ -160,10 +167,17 @@ class DefaultMessageCodec : public FieldCodecBase
 
     template <typename Action, typename ReturnType>
     ReturnType traverse_const_message(const dccl::any& wire_value)
+    {
+        ReturnType return_value = ReturnType();
+        traverse_const_message<Action>(wire_value, &return_value);
+        return return_value;
+    }
+
+    template <typename Action, typename ReturnType>
+    void traverse_const_message(const dccl::any& wire_value, ReturnType* return_value)
     {
         try
         {
-            ReturnType return_value = ReturnType();
 
             const auto* msg = dccl::any_cast<const google::protobuf::Message*>(wire_value);
             const google::protobuf::Descriptor* desc = msg->GetDescriptor();
@@ -186,7 +200,7 @@ class DefaultMessageCodec : public FieldCodecBase
                     for (int j = 0, m = refl->FieldSize(*msg, field_desc); j < m; ++j)
                         field_values.push_back(helper->get_repeated_value(field_desc, *msg, j));
 
-                    Action::repeated(codec, &return_value, field_values, field_desc);
+                    Action::repeated(codec, return_value, field_values, field_desc);
                 }
                 else
                 {
@@ -200,11 +214,10 @@ class DefaultMessageCodec : public FieldCodecBase
                             continue;
                     }
 
-                    Action::single(codec, &return_value, helper->get_value(field_desc, *msg),
+                    Action::single(codec, return_value, helper->get_value(field_desc, *msg),
                                    field_desc);
                 }
             }
-            return return_value;
         }
         catch (dccl::bad_any_cast& e)
         {
@@ -24,6 +24,8 @@
 #ifndef FIELD_CODEC_PRESENCE_20190722H
 #define FIELD_CODEC_PRESENCE_20190722H
 
+#include <typeinfo>
+
 #include "../field_codec_typed.h"
 
 namespace dccl
@@ -115,6 +117,46 @@ class PresenceBitCodec
         return _inner_codec.decode(bits);
     }
 
+    bool streaming() override { return typeid(*this) == typeid(PresenceBitCodec); }
+
+    /// Encodes an empty field as a single 0 bit
+    void encode(BitWriter* writer) override
+    {
+        writer->write_bit(false); // presence bit == false
+    }
+
+    /// Encodes a non-empty field, writing a 1 bit first for optional fields
+    void encode(BitWriter* writer, const wire_type& value) override
+    {
+        if (!this->use_required())
+            writer->write_bit(true);
+
+        Base& inner = _inner_codec;
+        if (inner.streaming())
+            inner.encode(writer, value);
+        else
+            writer->write(inner.encode(value));
+    }
+
+    /// Decodes a field, first reading the presence bit if necessary
+    wire_type decode(BitReader* reader) override
+    {
+        if (!this->use_required() && !reader->read_bit())
+            throw NullValueException();
+
+        Base& inner = _inner_codec;
+        if (inner.streaming())
+        {
+            return inner.decode(reader);
+        }
+        else
+        {
+            Bitset bits(reader->bits());
+            bits.get_more_bits(inner.size());
+            return inner.decode(&bits);
+        }
+    }
+
     /// Size of an empty field (1 bit)
     unsigned size() override
     {
@@ -104,6 +104,36 @@ std::string dccl::v3::VarBytesCodec::decode(dccl::Bitset* bits)
     return string_body_bits.to_byte_string();
 }
 
+void dccl::v3::VarBytesCodec::encode(dccl::BitWriter* writer) { writer->write_zeros(min_size()); }
+
+void dccl::v3::VarBytesCodec::encode(dccl::BitWriter* writer, const std::string& wire_value)
+{
+    if (wire_value.size() > dccl_field_options().max_length())
+    {
+        // use the Bitset version to handle truncation (and logging thereof)
+        writer->write(encode(wire_value));
+        return;
+    }
+
+    if (!use_required())
+        writer->write_bit(true); // presence bit
+
+    writer->write(wire_value.length(), prefix_size());
+    writer->write_bytes(wire_value);
+}
+
+std::string dccl::v3::VarBytesCodec::decode(dccl::BitReader* reader)
+{
+    if (!use_required() && !reader->read_bit())
+        throw dccl::NullValueException();
+
+    unsigned value_length = reader->read(prefix_size());
+
+    dccl::dlog.is(DEBUG2) && dccl::dlog << "Length of string is = " << value_length << std::endl;
+
+    return reader->read_bytes(value_length);
+}
+
 unsigned dccl::v3::VarBytesCodec::size() { return min_size(); }
 
 unsigned dccl::v3::VarBytesCodec::size(const std::string& wire_value)
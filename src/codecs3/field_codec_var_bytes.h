@@ -23,6 +23,8 @@
 #ifndef FIELD_CODEC_VAR_BYTES_20181010H
 #define FIELD_CODEC_VAR_BYTES_20181010H
 
+#include <typeinfo>
+
 #include "../field_codec_typed.h"
 
 namespace dccl
@@ -39,6 +41,10 @@ class VarBytesCodec : public dccl::TypedFieldCodec<std::string>
     dccl::Bitset encode() override;
     dccl::Bitset encode(const std::string& wire_value) override;
     std::string decode(dccl::Bitset* bits) override;
+    bool streaming() override { return typeid(*this) == typeid(VarBytesCodec); }
+    void encode(dccl::BitWriter* writer) override;
+    void encode(dccl::BitWriter* writer, const std::string& wire_value) override;
+    std::string decode(dccl::BitReader* reader) override;
     unsigned size() override;
     unsigned size(const std::string& wire_value) override;
     unsigned max_size() override;
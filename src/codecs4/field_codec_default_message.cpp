@@ -25,24 +25,33 @@
 #include "../codec.h"
 #include "../oneof.h"
 
-std::unordered_map<std::string, unsigned> dccl::v4::DefaultMessageCodec::MaxSize::oneofs_max_size;
+thread_local std::unordered_map<std::string, unsigned>
+    dccl::v4::DefaultMessageCodec::MaxSize::oneofs_max_size;
 
 //
 // DefaultMessageCodec
 //
 
 void dccl::v4::DefaultMessageCodec::any_encode(Bitset* bits, const dccl::any& wire_value)
+{
+    bits->clear();
+    BitWriter writer(bits);
+    any_encode_stream(&writer, wire_value);
+}
+
+void dccl::v4::DefaultMessageCodec::any_encode_stream(BitWriter* writer,
+                                                      const dccl::any& wire_value)
 {
     if (is_empty(wire_value))
     {
-        *bits = Bitset(min_size());
+        writer->write_zeros(min_size());
     }
     else
     {
-        *bits = traverse_const_message<Encoder, Bitset>(wire_value);
-
         if (is_optional())
-            bits->push_front(true); // presence bit
+            writer->write_bit(true); // presence bit
+
+        traverse_const_message<Encoder>(wire_value, writer->bits());
     }
 }
 
@@ -66,57 +75,53 @@ unsigned dccl::v4::DefaultMessageCodec::any_size(const dccl::any& wire_value)
 }
 
 void dccl::v4::DefaultMessageCodec::any_decode(Bitset* bits, dccl::any* wire_value)
+{
+    BitReader reader(bits);
+    any_decode_stream(&reader, wire_value);
+}
+
+void dccl::v4::DefaultMessageCodec::any_decode_stream(BitReader* reader, dccl::any* wire_value)
 {
     try
     {
+        Bitset* bits = reader->bits();
         auto* msg = dccl::any_cast<google::protobuf::Message*>(*wire_value);
 
         if (is_optional())
         {
-            if (!bits->to_ulong())
+            if (!reader->read_bit()) // presence bit
             {
                 *wire_value = dccl::any();
                 return;
             }
-            else
-            {
-                bits->pop_front(); // presence bit
-            }
         }
 
         const google::protobuf::Descriptor* desc = msg->GetDescriptor();
         const google::protobuf::Reflection* refl = msg->GetReflection();
+        std::shared_ptr<const Plan> plan_ptr = plan(desc);
+        const Plan& msg_plan = *plan_ptr;
 
         // First, process the oneof definitions, storing the case value...
         std::vector<int> oneof_cases(desc->oneof_decl_count());
-        for (auto i = 0, n = desc->oneof_decl_count(); part() != HEAD && i < n; ++i)
+        for (std::size_t i = 0, n = msg_plan.oneofs.size(); i < n; ++i)
         {
-            Bitset case_bits(bits);
-            case_bits.get_more_bits(oneof_size(desc->oneof_decl(i)));
-
             // Store the index of the field set for the i-th oneof (if unset, it will be -1)
-            oneof_cases[i] = static_cast<int>(case_bits.to_ulong()) - 1;
+            oneof_cases[i] = static_cast<int>(reader->read(msg_plan.oneof_sizes[i])) - 1;
         }
 
         // ... then, process the fields
-        for (int i = 0, n = desc->field_count(); i < n; ++i)
+        for (const FieldStep& step : msg_plan.fields)
         {
-            const google::protobuf::FieldDescriptor* field_desc = desc->field(i);
-
-            if (!check_field(field_desc))
-                continue;
-
-            std::shared_ptr<FieldCodecBase> codec = find(field_desc);
-            std::shared_ptr<internal::FromProtoCppTypeBase> helper =
-                manager().type_helper().find(field_desc);
+            const google::protobuf::FieldDescriptor* field_desc = step.field_desc;
+            FieldCodecBase* codec = step.codec;
 
             if (field_desc->is_repeated())
             {
                 std::vector<dccl::any> field_values;
-                if (field_desc->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE)
+                if (step.is_message)
                 {
-                    unsigned max_repeat =
-                        field_desc->options().GetExtension(dccl::field).max_repeat();
+                    unsigned max_repeat = step.max_repeat;
+                    field_values.reserve(max_repeat);
                     for (unsigned j = 0, m = max_repeat; j < m; ++j)
                         field_values.emplace_back(refl->AddMessage(msg, field_desc));
 
@@ -133,32 +138,31 @@ void dccl::v4::DefaultMessageCodec::any_decode(Bitset* bits, dccl::any* wire_val
                     // for primitive types
                     codec->field_decode_repeated(bits, &field_values, field_desc);
                     for (auto& field_value : field_values)
-                        helper->add_value(field_desc, msg, field_value);
+                        step.helper->add_value(field_desc, msg, field_value);
                 }
             }
             else
             {
-                if (is_part_of_oneof(field_desc))
+                if (step.oneof_index >= 0)
                 {
                     // If the field belongs to a oneof and its index is the one stored for the containing
                     // oneof, decode it; otherwise, skip the field.
-                    if (field_desc->index_in_oneof() !=
-                        oneof_cases[containing_oneof_index(field_desc)])
+                    if (step.index_in_oneof != oneof_cases[step.oneof_index])
                         continue;
                 }
 
                 // singular field dynamic conditions - repeated fields handled in any_decode_repeated
-                DynamicConditions& dc = dynamic_conditions(field_desc);
-                if (dc.has_omit_if())
+                if (step.has_omit_if)
                 {
                     // expensive, so don't do this unless we're going to use it
+                    DynamicConditions& dc = dynamic_conditions(field_desc);
                     dc.regenerate(this_message(), root_message());
                     if (dc.omit())
                         continue;
                 }
 
                 dccl::any field_value;
-                if (field_desc->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE)
+                if (step.is_message)
                 {
                     // allows us to propagate pointers instead of making many copies of entire messages
                     field_value = refl->MutableMessage(msg, field_desc);
@@ -166,17 +170,19 @@ void dccl::v4::DefaultMessageCodec::any_decode(Bitset* bits, dccl::any* wire_val
                     if (is_empty(field_value))
                         refl->ClearField(msg, field_desc);
                 }
+                else if (step.direct)
+                {
+                    codec->field_decode_direct(bits, msg, field_desc);
+                }
                 else
                 {
                     // for primitive types
                     codec->field_decode(bits, &field_value, field_desc);
-                    helper->set_value(field_desc, msg, field_value);
+                    step.helper->set_value(field_desc, msg, field_value);
                 }
             }
         }
 
-        std::vector<const google::protobuf::FieldDescriptor*> set_fields;
-        refl->ListFields(*msg, &set_fields);
         *wire_value = msg;
     }
     catch (dccl::bad_any_cast& e)
@@ -220,6 +226,9 @@ void dccl::v4::DefaultMessageCodec::validate()
 {
     bool b = false;
     traverse_descriptor<Validate>(&b);
+
+    // compile the plan now so the first encode/decode doesn't have to
+    plan(this_descriptor());
 }
 
 std::string dccl::v4::DefaultMessageCodec::info()
@@ -263,3 +272,77 @@ bool dccl::v4::DefaultMessageCodec::check_field(const google::protobuf::FieldDes
             return true;
     }
 }
+
+std::shared_ptr<const dccl::v4::DefaultMessageCodec::Plan>
+dccl::v4::DefaultMessageCodec::plan(const google::protobuf::Descriptor* desc)
+{
+    PlanKey key(root_descriptor(), desc, part(), message_data().current_part());
+    std::size_t generation = manager().generation();
+
+    {
+#if DCCL_THREAD_SUPPORT
+        std::shared_lock<internal::SharedMutex> l(plans_mutex_);
+#endif
+        auto it = plans_.find(key);
+        if (it != plans_.end() && it->second->generation == generation)
+            return it->second;
+    }
+
+    // build outside the lock, as this looks up the codecs of all the fields
+    std::shared_ptr<const Plan> new_plan = build_plan(desc, generation);
+
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<internal::SharedMutex> l(plans_mutex_);
+#endif
+    std::shared_ptr<const Plan>& published = plans_[key];
+    // another thread may have built the same plan in the meantime
+    if (published && published->generation == generation)
+        return published;
+
+    // replace (rather than modify) any stale plan, as other threads may still be using it
+    published = new_plan;
+    return new_plan;
+}
+
+std::shared_ptr<const dccl::v4::DefaultMessageCodec::Plan>
+dccl::v4::DefaultMessageCodec::build_plan(const google::protobuf::Descriptor* desc,
+                                          std::size_t generation)
+{
+    auto new_plan_ptr = std::make_shared<Plan>();
+    Plan& new_plan = *new_plan_ptr;
+    new_plan.generation = generation;
+
+    for (auto i = 0, n = desc->oneof_decl_count(); part() != HEAD && i < n; ++i)
+    {
+        new_plan.oneofs.push_back(desc->oneof_decl(i));
+        new_plan.oneof_sizes.push_back(oneof_size(desc->oneof_decl(i)));
+    }
+
+    for (int i = 0, n = desc->field_count(); i < n; ++i)
+    {
+        const google::protobuf::FieldDescriptor* field_desc = desc->field(i);
+
+        if (!check_field(field_desc))
+            continue;
+
+        FieldStep step;
+        step.field_desc = field_desc;
+        step.codec = find(field_desc).get();
+        step.helper = manager().type_helper().find(field_desc);
+        step.is_message =
+            field_desc->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE;
+        step.has_omit_if =
+            !field_desc->is_repeated() && dynamic_conditions(field_desc).has_omit_if();
+        step.direct = !step.is_message && step.codec->direct_access(field_desc);
+        if (is_part_of_oneof(field_desc))
+        {
+            step.oneof_index = containing_oneof_index(field_desc);
+            step.index_in_oneof = field_desc->index_in_oneof();
+        }
+        if (field_desc->is_repeated())
+            step.max_repeat = field_desc->options().GetExtension(dccl::field).max_repeat();
+
+        new_plan.fields.push_back(std::move(step));
+    }
+    return new_plan_ptr;
+}
@@ -24,11 +24,15 @@
 #ifndef DCCLFIELDCODECDEFAULTMESSAGEV420210701H
 #define DCCLFIELDCODECDEFAULTMESSAGEV420210701H
 
+#include <map>
+#include <tuple>
+#include <typeinfo>
 #include <unordered_map>
 
 #include "../field_codec.h"
 #include "../field_codec_manager.h"
 #include "../oneof.h"
+#include "../thread_safety.h"
 
 #include "dccl/option_extensions.pb.h"
 
@@ -39,9 +43,14 @@ namespace v4
 /// \brief Provides the default codec for encoding a base Google Protobuf message or an embedded message by calling the appropriate field codecs for every field.
 class DefaultMessageCodec : public FieldCodecBase
 {
+  public:
+    bool streaming() override { return typeid(*this) == typeid(DefaultMessageCodec); }
+
   private:
     void any_encode(Bitset* bits, const dccl::any& wire_value) override;
     void any_decode(Bitset* bits, dccl::any* wire_value) override;
+    void any_encode_stream(BitWriter* writer, const dccl::any& wire_value) override;
+    void any_decode_stream(BitReader* reader, dccl::any* wire_value) override;
     unsigned max_size() override;
     unsigned min_size() override;
     unsigned any_size(const dccl::any& wire_value) override;
@@ -58,16 +67,57 @@ class DefaultMessageCodec : public FieldCodecBase
     std::size_t hash() override;
     bool check_field(const google::protobuf::FieldDescriptor* field);
 
+    /// \brief Everything needed to encode, decode or size a single field that depends only on the descriptors and the loaded codecs
+    struct FieldStep
+    {
+        const google::protobuf::FieldDescriptor* field_desc{nullptr};
+        // owned by the manager (not shared, as this codec's own plans can contain it). A plan is
+        // only used while the manager's generation is unchanged, i.e. while the codec is loaded
+        FieldCodecBase* codec{nullptr};
+        std::shared_ptr<internal::FromProtoCppTypeBase> helper;
+        bool is_message{false};
+        bool has_omit_if{false};
+        // singular non-message field whose codec supports direct_access()
+        bool direct{false};
+        int oneof_index{-1};
+        int index_in_oneof{-1};
+        unsigned max_repeat{0};
+    };
+
+    /// \brief Flattened traversal of a (sub)message for a given part, built once (from validate(), i.e. during Codec::load()) and reused by every encode, decode and size call
+    struct Plan
+    {
+        std::size_t generation{0};
+        std::vector<const google::protobuf::OneofDescriptor*> oneofs;
+        std::vector<unsigned> oneof_sizes;
+        std::vector<FieldStep> fields;
+    };
+
+    /// \brief Returns the plan for the given descriptor in the current context (root message, part), building it if necessary
+    ///
+    /// Plans for every (sub)message are built by validate(), so encoding and decoding only take a shared (read) lock. Published plans are never modified (a stale plan is replaced by a new one), so the returned plan remains valid for as long as the caller holds it, even if it is replaced concurrently.
+    std::shared_ptr<const Plan> plan(const google::protobuf::Descriptor* desc);
+    std::shared_ptr<const Plan> build_plan(const google::protobuf::Descriptor* desc,
+                                           std::size_t generation);
+
+    // root descriptor (determines codec version and group), message descriptor, part, current part
+    using PlanKey = std::tuple<const google::protobuf::Descriptor*,
+                               const google::protobuf::Descriptor*, MessagePart, MessagePart>;
+    std::map<PlanKey, std::shared_ptr<const Plan>> plans_;
+#if DCCL_THREAD_SUPPORT
+    internal::SharedMutex plans_mutex_;
+#endif
+
     struct Size
     {
-        static void repeated(std::shared_ptr<FieldCodecBase> codec, unsigned* return_value,
+        static void repeated(FieldCodecBase* codec, unsigned* return_value,
                              const std::vector<dccl::any>& field_values,
                              const google::protobuf::FieldDescriptor* field_desc)
         {
             codec->field_size_repeated(return_value, field_values, field_desc);
         }
 
-        static void single(std::shared_ptr<FieldCodecBase> codec, unsigned* return_value,
+        static void single(FieldCodecBase* codec, unsigned* return_value,
                            const dccl::any& field_value,
                            const google::protobuf::FieldDescriptor* field_desc)
         {
@@ -82,25 +132,32 @@ class DefaultMessageCodec : public FieldCodecBase
             }
         }
 
-        static void oneof(unsigned* return_value,
-                          const google::protobuf::OneofDescriptor* oneof_desc,
-                          const google::protobuf::Message&)
+        static void single_direct(FieldCodecBase* codec, unsigned* return_value,
+                                  const google::protobuf::Message& msg,
+                                  const google::protobuf::FieldDescriptor* field_desc)
+        {
+            if (!is_part_of_oneof(field_desc) || msg.GetReflection()->HasField(msg, field_desc))
+                codec->field_size_direct(return_value, msg, field_desc);
+        }
+
+        static void oneof(unsigned* return_value, const google::protobuf::OneofDescriptor*,
+                          unsigned oneof_bits, const google::protobuf::Message&)
         {
             // Add the bits needed to encode the case enumerator
-            *return_value += oneof_size(oneof_desc);
+            *return_value += oneof_bits;
         }
     };
 
     struct Encoder
     {
-        static void repeated(std::shared_ptr<FieldCodecBase> codec, Bitset* return_value,
+        static void repeated(FieldCodecBase* codec, Bitset* return_value,
                              const std::vector<dccl::any>& field_values,
                              const google::protobuf::FieldDescriptor* field_desc)
         {
             codec->field_encode_repeated(return_value, field_values, field_desc);
         }
 
-        static void single(std::shared_ptr<FieldCodecBase> codec, Bitset* return_value,
+        static void single(FieldCodecBase* codec, Bitset* return_value,
                            const dccl::any& field_value,
                            const google::protobuf::FieldDescriptor* field_desc)
         {
@@ -115,29 +172,30 @@ class DefaultMessageCodec : public FieldCodecBase
             }
         }
 
+        static void single_direct(FieldCodecBase* codec, Bitset* return_value,
+                                  const google::protobuf::Message& msg,
+                                  const google::protobuf::FieldDescriptor* field_desc)
+        {
+            if (!is_part_of_oneof(field_desc) || msg.GetReflection()->HasField(msg, field_desc))
+                codec->field_encode_direct(return_value, msg, field_desc);
+        }
+
         static void oneof(Bitset* return_value, const google::protobuf::OneofDescriptor* oneof_desc,
-                          const google::protobuf::Message& msg)
+                          unsigned oneof_bits, const google::protobuf::Message& msg)
         {
             // Encode 0 if oneof is not set, the index of the field set + 1 otherwise
-            unsigned case_ = 0;
-            auto refl = msg.GetReflection();
-            if (refl->HasOneof(msg, oneof_desc))
-                for (auto i = 0; i < oneof_desc->field_count(); ++i)
-                    if (refl->HasField(msg, oneof_desc->field(i)))
-                    {
-                        case_ = i + 1;
-                        break;
-                    }
+            const google::protobuf::FieldDescriptor* set_field =
+                msg.GetReflection()->GetOneofFieldDescriptor(msg, oneof_desc);
+            unsigned case_ = set_field ? set_field->index_in_oneof() + 1 : 0;
 
-            Bitset case_bits(oneof_size(oneof_desc), case_);
-            return_value->append(case_bits);
+            BitWriter(return_value).write(case_, oneof_bits);
         }
     };
 
     struct MaxSize
     {
-        // Keeps track of the maximum size of each oneof
-        static std::unordered_map<std::string, unsigned> oneofs_max_size;
+        // Keeps track of the maximum size of each oneof (per thread, so that concurrent Codecs don't share it)
+        static thread_local std::unordered_map<std::string, unsigned> oneofs_max_size;
 
         static void field(std::shared_ptr<FieldCodecBase> codec, unsigned* return_value,
                           const google::protobuf::FieldDescriptor* field_desc)
@@ -314,56 +372,61 @@ class DefaultMessageCodec : public FieldCodecBase
 
     template <typename Action, typename ReturnType>
     ReturnType traverse_const_message(const dccl::any& wire_value)
+    {
+        ReturnType return_value = ReturnType();
+        traverse_const_message<Action>(wire_value, &return_value);
+        return return_value;
+    }
+
+    template <typename Action, typename ReturnType>
+    void traverse_const_message(const dccl::any& wire_value, ReturnType* return_value)
     {
         try
         {
-            ReturnType return_value = ReturnType();
 
             const auto* msg = dccl::any_cast<const google::protobuf::Message*>(wire_value);
-            const google::protobuf::Descriptor* desc = msg->GetDescriptor();
             const google::protobuf::Reflection* refl = msg->GetReflection();
+            std::shared_ptr<const Plan> plan_ptr = plan(msg->GetDescriptor());
+            const Plan& msg_plan = *plan_ptr;
 
             // First, process the oneof definitions...
-            for (auto i = 0, n = desc->oneof_decl_count(); part() != HEAD && i < n; ++i)
-                Action::oneof(&return_value, desc->oneof_decl(i), *msg);
+            for (std::size_t i = 0, n = msg_plan.oneofs.size(); i < n; ++i)
+                Action::oneof(return_value, msg_plan.oneofs[i], msg_plan.oneof_sizes[i], *msg);
 
             // ... then, process the fields
-            for (int i = 0, n = desc->field_count(); i < n; ++i)
+            for (const FieldStep& step : msg_plan.fields)
             {
-                const google::protobuf::FieldDescriptor* field_desc = desc->field(i);
-
-                if (!check_field(field_desc))
-                    continue;
-
-                std::shared_ptr<FieldCodecBase> codec = find(field_desc);
-                std::shared_ptr<internal::FromProtoCppTypeBase> helper =
-                    manager().type_helper().find(field_desc);
+                const google::protobuf::FieldDescriptor* field_desc = step.field_desc;
 
                 if (field_desc->is_repeated())
                 {
                     std::vector<dccl::any> field_values;
-                    for (int j = 0, m = refl->FieldSize(*msg, field_desc); j < m; ++j)
-                        field_values.push_back(helper->get_repeated_value(field_desc, *msg, j));
+                    int m = refl->FieldSize(*msg, field_desc);
+                    field_values.reserve(m);
+                    for (int j = 0; j < m; ++j)
+                        field_values.push_back(step.helper->get_repeated_value(field_desc, *msg, j));
 
-                    Action::repeated(codec, &return_value, field_values, field_desc);
+                    Action::repeated(step.codec, return_value, field_values, field_desc);
                 }
                 else
                 {
                     // singular field dynamic conditions - repeated fields handled in any_encode_repeated
-                    DynamicConditions& dc = dynamic_conditions(field_desc);
-                    if (dc.has_omit_if())
+                    if (step.has_omit_if)
                     {
                         // expensive, so don't do this unless we're going to use it
+                        DynamicConditions& dc = dynamic_conditions(field_desc);
                         dc.regenerate(this_message(), root_message());
                         if (dc.omit())
                             continue;
                     }
 
-                    Action::single(codec, &return_value, helper->get_value(field_desc, *msg),
-                                   field_desc);
+                    if (step.direct)
+                        Action::single_direct(step.codec, return_value, *msg, field_desc);
+                    else
+                        Action::single(step.codec, return_value,
+                                       step.helper->get_value(field_desc, *msg), field_desc);
                 }
             }
-            return return_value;
         }
         catch (dccl::bad_any_cast& e)
         {
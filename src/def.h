@@ -33,6 +33,11 @@
 #define DCCL_THREAD_SUPPORT @DCCL_HAS_THREAD_SUPPORT@
 #define DCCL_COMPILED_CXX_STANDARD @CMAKE_CXX_STANDARD@
 
+// most verbose dccl::logger::Verbosity of dlog statements compiled in; statements above this are removed (can be overridden, e.g. -DDCCL_LOG_LEVEL=INFO)
+#ifndef DCCL_LOG_LEVEL
+#define DCCL_LOG_LEVEL @DCCL_LOG_LEVEL@
+#endif
+
 #if DCCL_COMPILED_CXX_STANDARD >= 17
 #define DCCL_HAS_CPP17
 #endif
@@ -21,36 +21,211 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
 #include "dynamic_conditions.h"
+#include "common.h"
 #include "exception.h"
+#include "internal/dynamic_conditions_expression.h"
 
 #if DCCL_HAS_LUA
 #include "thirdparty/sol/sol.hpp"
-// symbol in lua-protobuf/pb.c so we can load this using sol's require call
-LUALIB_API int luaopen_pb(lua_State* L);
 #define SOL_ALL_SAFETIES_ON 1
 #define SOL_PRINT_ERRORS 1
-#endif
 
-void build_file_desc_set(const google::protobuf::FileDescriptor* file_desc,
-                         google::protobuf::FileDescriptorSet& file_desc_set)
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <unordered_map>
+
+namespace
+{
+// Lua view of a message (`this` and `root`), reading each field through Reflection when it is
+// accessed rather than copying the message into a Lua table
+struct MessageProxy
+{
+    const google::protobuf::Message* msg;
+};
+
+// Lua view of a repeated field, indexed from 1
+struct RepeatedProxy
+{
+    const google::protobuf::Message* msg;
+    const google::protobuf::FieldDescriptor* field;
+};
+
+sol::object nil_object(lua_State* L) { return sol::make_object(L, sol::lua_nil); }
+
+// value of a non-repeated field, or element `index` of a repeated field, as seen from Lua:
+// enumerations are their value name, unset scalars are their default and unset messages are nil
+sol::object field_to_lua(lua_State* L, const google::protobuf::Message& msg,
+                         const google::protobuf::FieldDescriptor* field, int index = -1)
+{
+    const google::protobuf::Reflection* refl = msg.GetReflection();
+    bool repeated = field->is_repeated();
+    if (repeated && index < 0)
+        return sol::make_object(L, RepeatedProxy{&msg, field});
+
+    switch (field->cpp_type())
+    {
+        case google::protobuf::FieldDescriptor::CPPTYPE_INT32:
+            return sol::make_object(L, repeated ? refl->GetRepeatedInt32(msg, field, index)
+                                                : refl->GetInt32(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_INT64:
+            return sol::make_object(L, repeated ? refl->GetRepeatedInt64(msg, field, index)
+                                                : refl->GetInt64(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_UINT32:
+            return sol::make_object(L, repeated ? refl->GetRepeatedUInt32(msg, field, index)
+                                                : refl->GetUInt32(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_UINT64:
+        {
+            dccl::uint64 v =
+                repeated ? refl->GetRepeatedUInt64(msg, field, index) : refl->GetUInt64(msg, field);
+            // Lua integers are signed
+            if (v > static_cast<dccl::uint64>(std::numeric_limits<dccl::int64>::max()))
+                return sol::make_object(L, static_cast<double>(v));
+            return sol::make_object(L, static_cast<dccl::int64>(v));
+        }
+        case google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE:
+            return sol::make_object(L, repeated ? refl->GetRepeatedDouble(msg, field, index)
+                                                : refl->GetDouble(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_FLOAT:
+            return sol::make_object(L, repeated ? refl->GetRepeatedFloat(msg, field, index)
+                                                : refl->GetFloat(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_BOOL:
+            return sol::make_object(L, repeated ? refl->GetRepeatedBool(msg, field, index)
+                                                : refl->GetBool(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_STRING:
+            return sol::make_object(L, repeated ? refl->GetRepeatedString(msg, field, index)
+                                                : refl->GetString(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_ENUM:
+            return sol::make_object(L, repeated ? refl->GetRepeatedEnum(msg, field, index)->name()
+                                                : refl->GetEnum(msg, field)->name());
+        case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+            if (repeated)
+                return sol::make_object(L,
+                                        MessageProxy{&refl->GetRepeatedMessage(msg, field, index)});
+            else if (refl->HasField(msg, field))
+                return sol::make_object(L, MessageProxy{&refl->GetMessage(msg, field)});
+            else
+                return nil_object(L);
+    }
+    return nil_object(L);
+}
+
+// message.field or message["field"]
+sol::object message_index(const MessageProxy& proxy, sol::stack_object key, sol::this_state s)
+{
+    if (key.get_type() != sol::type::string)
+        return nil_object(s);
+
+    const google::protobuf::FieldDescriptor* field =
+        proxy.msg->GetDescriptor()->FindFieldByName(key.as<std::string>());
+    return field ? field_to_lua(s, *proxy.msg, field) : nil_object(s);
+}
+
+// repeated[i], nil if out of range
+sol::object repeated_index(const RepeatedProxy& proxy, sol::stack_object key, sol::this_state s)
+{
+    if (key.get_type() != sol::type::number)
+        return nil_object(s);
+
+    double i = key.as<double>();
+    int size = proxy.msg->GetReflection()->FieldSize(*proxy.msg, proxy.field);
+    if (i != std::floor(i) || i < 1 || i > size)
+        return nil_object(s);
+
+    return field_to_lua(s, *proxy.msg, proxy.field, static_cast<int>(i) - 1);
+}
+
+// #repeated
+int repeated_length(const RepeatedProxy& proxy)
+{
+    return proxy.msg->GetReflection()->FieldSize(*proxy.msg, proxy.field);
+}
+
+// next(message, key) for pairs(message): the fields that are set (or non-empty if repeated), in
+// the order they are declared
+std::tuple<sol::object, sol::object> message_next(const MessageProxy& proxy, sol::stack_object key,
+                                                  sol::this_state s)
+{
+    const google::protobuf::Descriptor* desc = proxy.msg->GetDescriptor();
+    const google::protobuf::Reflection* refl = proxy.msg->GetReflection();
+
+    int i = 0;
+    if (key.get_type() == sol::type::string)
+    {
+        const google::protobuf::FieldDescriptor* previous =
+            desc->FindFieldByName(key.as<std::string>());
+        i = previous ? previous->index() + 1 : desc->field_count();
+    }
+
+    for (int n = desc->field_count(); i < n; ++i)
+    {
+        const google::protobuf::FieldDescriptor* field = desc->field(i);
+        bool present = field->is_repeated() ? refl->FieldSize(*proxy.msg, field) > 0
+                                            : refl->HasField(*proxy.msg, field);
+        if (present)
+            return std::make_tuple(sol::make_object(s, field->name()),
+                                   field_to_lua(s, *proxy.msg, field));
+    }
+    return std::make_tuple(nil_object(s), nil_object(s));
+}
+
+// pairs(message), as for the tables previously decoded by lua-protobuf
+std::tuple<decltype(&message_next), MessageProxy, sol::lua_nil_t>
+message_pairs(const MessageProxy& proxy)
+{
+    return std::make_tuple(&message_next, proxy, sol::lua_nil);
+}
+
+// next(repeated, i) for pairs(repeated): each element from 1
+std::tuple<sol::object, sol::object> repeated_next(const RepeatedProxy& proxy, sol::stack_object key,
+                                                   sol::this_state s)
 {
-    for (int i = 0, n = file_desc->dependency_count(); i < n; ++i)
-        build_file_desc_set(file_desc->dependency(i), file_desc_set);
+    int i = (key.get_type() == sol::type::number) ? key.as<int>() : 0;
+    if (i < 0 || i >= repeated_length(proxy))
+        return std::make_tuple(nil_object(s), nil_object(s));
+    return std::make_tuple(sol::make_object(s, i + 1), field_to_lua(s, *proxy.msg, proxy.field, i));
+}
 
-    google::protobuf::FileDescriptorProto* file_desc_proto = file_desc_set.add_file();
-    file_desc->CopyTo(file_desc_proto);
+// pairs(repeated)
+std::tuple<decltype(&repeated_next), RepeatedProxy, sol::lua_nil_t>
+repeated_pairs(const RepeatedProxy& proxy)
+{
+    return std::make_tuple(&repeated_next, proxy, sol::lua_nil);
 }
+} // namespace
+
+struct dccl::DynamicConditions::LuaState
+{
+    // declared first so that it is destroyed after the functions referencing it
+    sol::state lua;
+    // compiled condition scripts, keyed by their source
+    std::unordered_map<std::string, sol::protected_function> conditions;
+    // messages currently referenced by `this` and `root`
+    const google::protobuf::Message* this_msg{nullptr};
+    const google::protobuf::Message* root_msg{nullptr};
+};
+#endif
 
 dccl::DynamicConditions::DynamicConditions() = default;
 
-dccl::DynamicConditions::~DynamicConditions()
+dccl::DynamicConditions::~DynamicConditions() = default;
+
+void dccl::DynamicConditions::reset()
 {
+    field_desc_ = nullptr;
+    this_msg_ = nullptr;
+    root_msg_ = nullptr;
+    native_ = nullptr;
+    compiled_.reset();
+
 #if DCCL_HAS_LUA
-    if (lua_)
+    // don't leave the Lua proxies referring to messages that may be destroyed after this pass
+    if (lua_ && (lua_->this_msg || lua_->root_msg))
     {
-        // without this, we get a segfault in Ubuntu jammy
-        lua_->script("pb.clear()");
-        delete lua_;
+        lua_->lua["this"] = sol::lua_nil;
+        lua_->lua["root"] = sol::lua_nil;
+        lua_->this_msg = nullptr;
+        lua_->root_msg = nullptr;
     }
 #endif
 }
@@ -66,45 +241,40 @@ void dccl::DynamicConditions::regenerate(const google::protobuf::Message* this_m
     if (!this_msg_)
         this_msg_ = root_msg_;
 
+    // native conditions are evaluated directly on the messages, so there is nothing to prepare
+    if (field_desc_ && native_conditions().complete)
+        return;
+
 #if DCCL_HAS_LUA
     if (this_msg_ && root_msg_)
     {
         if (!lua_)
         {
-            lua_ = new sol::state;
-            lua_->open_libraries();
-            lua_->require("pb", luaopen_pb);
+            lua_.reset(new LuaState);
+            lua_->lua.open_libraries();
+            lua_->lua.new_usertype<MessageProxy>(
+                "DCCLMessage", "new", sol::no_constructor, sol::meta_function::index, &message_index,
+                sol::meta_function::pairs, &message_pairs);
+            lua_->lua.new_usertype<RepeatedProxy>(
+                "DCCLRepeatedField", "new", sol::no_constructor, sol::meta_function::index,
+                &repeated_index, sol::meta_function::length, &repeated_length,
+                sol::meta_function::pairs, &repeated_pairs);
         }
 
-        sol::load_result desc_load = lua_->load(R"(local desc = ...; return pb.load(desc) )");
-
-        google::protobuf::FileDescriptorSet file_desc_set;
-        build_file_desc_set(root_msg_->GetDescriptor()->file(), file_desc_set);
-
-        std::tuple<bool, int> desc_load_result = desc_load(file_desc_set.SerializeAsString());
-        assert(std::get<0>(desc_load_result));
-        const auto& decode_script = R"(
-         local this_encoded_msg, this_type, root_encoded_msg, root_type, cpp_index = ...;
-         pb.option('use_default_metatable');
-         root = pb.decode(root_type, root_encoded_msg);
-         this = pb.decode(this_type, this_encoded_msg); this_index = cpp_index+1;
-         return this;
-        )";
-
-        sol::load_result decode_message = lua_->load(decode_script);
-        if (!decode_message.valid())
+        // the proxies read the messages as they are when the condition is evaluated, so only
+        // need replacing when given a different message (or after reset() at the end of the
+        // previous encode/decode pass), rather than on every call
+        if (this_msg_ != lua_->this_msg)
         {
-            sol::error err = decode_message;
-            throw(Exception(std::string("Failed to load condition script into the Lua program: ") +
-                                err.what(),
-                            this_msg_->GetDescriptor()));
+            lua_->lua["this"] = MessageProxy{this_msg_};
+            lua_->this_msg = this_msg_;
         }
-
-        auto index = index_;
-
-        sol::table decoded_message = decode_message(
-            this_msg_->SerializePartialAsString(), this_msg_->GetDescriptor()->full_name(),
-            root_msg_->SerializePartialAsString(), root_msg_->GetDescriptor()->full_name(), index);
+        if (root_msg_ != lua_->root_msg)
+        {
+            lua_->lua["root"] = MessageProxy{root_msg_};
+            lua_->root_msg = root_msg_;
+        }
+        lua_->lua["this_index"] = index_ + 1;
     }
 #endif
 }
@@ -117,101 +287,139 @@ const dccl::DCCLFieldOptions::Conditions& dccl::DynamicConditions::conditions()
         throw(Exception("Null field_desc"));
 }
 
-bool dccl::DynamicConditions::required()
+#if DCCL_HAS_LUA
+template <typename T> T dccl::DynamicConditions::lua_evaluate(const std::string& condition)
 {
+    auto it = lua_->conditions.find(condition);
+    if (it == lua_->conditions.end())
+    {
+        sol::load_result script = lua_->lua.load(return_prefix(condition));
+        if (!script.valid())
+        {
+            sol::error err = script;
+            throw(Exception("Failed to compile dynamic condition \"" + condition +
+                                "\": " + err.what(),
+                            this_msg_->GetDescriptor()));
+        }
+        it = lua_->conditions.emplace(condition, script.get<sol::protected_function>()).first;
+    }
+
+    sol::protected_function_result result = it->second();
+    if (!result.valid())
+    {
+        sol::error err = result;
+        throw(Exception("Failed to evaluate dynamic condition \"" + condition + "\": " + err.what(),
+                        this_msg_->GetDescriptor()));
+    }
+    return result.get<T>();
+}
+#endif
+
+std::shared_ptr<const dccl::DynamicConditions::NativeConditions>
+dccl::DynamicConditions::compile(const google::protobuf::FieldDescriptor* field_desc)
+{
+    std::shared_ptr<NativeConditions> native = std::make_shared<NativeConditions>();
+    auto compile_one = [&native](bool has_condition, const std::string& condition,
+                                 std::unique_ptr<internal::ConditionExpression>* expression) {
+        if (!has_condition)
+            return;
+        *expression = internal::ConditionExpression::compile(condition);
+        if (!*expression)
+            native->complete = false;
+    };
+
+    const dccl::DCCLFieldOptions::Conditions& c =
+        field_desc->options().GetExtension(dccl::field).dynamic_conditions();
+    compile_one(c.has_required_if(), c.required_if(), &native->required_if);
+    compile_one(c.has_omit_if(), c.omit_if(), &native->omit_if);
+    compile_one(c.has_only_if(), c.only_if(), &native->only_if);
+    compile_one(c.has_min(), c.min(), &native->min);
+    compile_one(c.has_max(), c.max(), &native->max);
+    return native;
+}
+
+const dccl::DynamicConditions::NativeConditions& dccl::DynamicConditions::native_conditions()
+{
+    if (!native_)
+    {
+        compiled_ = compile(field_desc_);
+        native_ = compiled_.get();
+    }
+    return *native_;
+}
+
+bool dccl::DynamicConditions::evaluate_bool(
+    const std::unique_ptr<internal::ConditionExpression>& native, const std::string& condition)
+{
+    if (native)
+        return native->evaluate_bool(this_msg_, root_msg_, index_);
+#if DCCL_HAS_LUA
+    return lua_evaluate<bool>(condition);
+#else
+    throw(Exception("DCCL built without Lua support: cannot use dynamic_conditions \"" +
+                    condition + "\" (outside the subset that can be evaluated natively)"));
+#endif
+}
+
+double dccl::DynamicConditions::evaluate_number(
+    const std::unique_ptr<internal::ConditionExpression>& native, const std::string& condition)
+{
+    if (native)
+        return native->evaluate_number(this_msg_, root_msg_, index_);
 #if DCCL_HAS_LUA
+    return lua_evaluate<double>(condition);
+#else
+    throw(Exception("DCCL built without Lua support: cannot use dynamic_conditions \"" +
+                    condition + "\" (outside the subset that can be evaluated natively)"));
+#endif
+}
+
+bool dccl::DynamicConditions::required()
+{
     if (is_initialized())
     {
         if (conditions().has_required_if())
-        {
-            auto condition_script = return_prefix(conditions().required_if());
-            bool required = lua_->script(condition_script);
-            return required;
-        }
+            return evaluate_bool(native_conditions().required_if, conditions().required_if());
         else if (conditions().has_only_if())
-        {
-            auto condition_script = return_prefix(conditions().only_if());
-            bool only = lua_->script(condition_script);
-            return only;
-        }
+            return evaluate_bool(native_conditions().only_if, conditions().only_if());
         else
-        {
             return false;
-        }
     }
     else
     {
         return false;
     }
-
-#else
-    throw(Exception("DCCL built without Lua support: cannot use dynamic_conditions"));
-#endif
 }
 
 bool dccl::DynamicConditions::omit()
 {
-#if DCCL_HAS_LUA
     if (is_initialized())
     {
         if (conditions().has_omit_if())
-        {
-            auto condition_script = return_prefix(conditions().omit_if());
-            bool omit = lua_->script(condition_script);
-            return omit;
-        }
+            return evaluate_bool(native_conditions().omit_if, conditions().omit_if());
         else if (conditions().has_only_if())
-        {
-            auto condition_script = return_prefix(conditions().only_if());
-            bool only = lua_->script(condition_script);
-            return !only;
-        }
+            return !evaluate_bool(native_conditions().only_if, conditions().only_if());
         else
-        {
             return false;
-        }
     }
     else
     {
         return false;
     }
-#else
-    throw(Exception("DCCL built without Lua support: cannot use dynamic_conditions"));
-#endif
 }
 
 double dccl::DynamicConditions::min()
 {
-#if DCCL_HAS_LUA
     if (is_initialized())
-    {
-        auto condition_script = return_prefix(conditions().min());
-        double v = lua_->script(condition_script);
-        return v;
-    }
+        return evaluate_number(native_conditions().min, conditions().min());
     else
-    {
         return -std::numeric_limits<double>::infinity();
-    }
-#else
-    throw(Exception("DCCL built without Lua support: cannot use dynamic_conditions"));
-#endif
 }
 
 double dccl::DynamicConditions::max()
 {
-#if DCCL_HAS_LUA
     if (is_initialized())
-    {
-        auto condition_script = return_prefix(conditions().max());
-        double v = lua_->script(condition_script);
-        return v;
-    }
+        return evaluate_number(native_conditions().max, conditions().max());
     else
-    {
         return std::numeric_limits<double>::infinity();
-    }
-#else
-    throw(Exception("DCCL built without Lua support: cannot use dynamic_conditions"));
-#endif
 }
@@ -23,30 +23,55 @@
 #ifndef DCCLDYNAMICCONDITIONALS20220214H
 #define DCCLDYNAMICCONDITIONALS20220214H
 
+#include <memory>
+
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/message.h>
 
 #include "dccl/def.h"
 #include "option_extensions.pb.h"
 
-namespace sol
+namespace dccl
 {
-class state;
+namespace internal
+{
+class ConditionExpression;
 }
 
-namespace dccl
-{
 class DynamicConditions
 {
   public:
     DynamicConditions();
     ~DynamicConditions();
 
-    void set_field(const google::protobuf::FieldDescriptor* field_desc)
+    // conditions of a field compiled into native expressions (nullptr where Lua is required)
+    struct NativeConditions
+    {
+        std::unique_ptr<internal::ConditionExpression> required_if, omit_if, only_if, min, max;
+        // all of the field's conditions can be evaluated natively
+        bool complete{true};
+    };
+
+    /// \brief Compile the dynamic conditions of a field (see FieldCodecManagerLocal::native_conditions() for the cached version)
+    static std::shared_ptr<const NativeConditions>
+    compile(const google::protobuf::FieldDescriptor* field_desc);
+
+    /// \brief Set the field, compiling its conditions if not given
+    ///
+    /// \param native Compiled conditions of field_desc (not owned, e.g. from FieldCodecManagerLocal::native_conditions()), which must remain valid until the field is changed or reset() is called
+    void set_field(const google::protobuf::FieldDescriptor* field_desc,
+                   const NativeConditions* native = nullptr)
     {
         field_desc_ = field_desc;
+        native_ = native;
+        compiled_.reset();
     }
 
+    const google::protobuf::FieldDescriptor* field() const { return field_desc_; }
+
+    /// \brief Drop the field and messages at the end of each encode/decode pass, after which the messages and descriptors may be destroyed (so the Lua `this` and `root` are set again by the next pass)
+    void reset();
+
     void set_repeated_index(int index) { index_ = index; }
 
     void regenerate(const google::protobuf::Message* this_msg,
@@ -78,13 +103,34 @@ class DynamicConditions
     }
 
     bool is_initialized() { return root_msg_ && this_msg_ && field_desc_; }
+
+    const NativeConditions& native_conditions();
+
+    // evaluate natively if possible, otherwise using Lua
+    bool evaluate_bool(const std::unique_ptr<internal::ConditionExpression>& native,
+                       const std::string& condition);
+    double evaluate_number(const std::unique_ptr<internal::ConditionExpression>& native,
+                           const std::string& condition);
+
+#if DCCL_HAS_LUA
+    // evaluate a condition script using its cached compiled form
+    template <typename T> T lua_evaluate(const std::string& condition);
+#endif
+
     const google::protobuf::FieldDescriptor* field_desc_{nullptr};
     const google::protobuf::Message* this_msg_{nullptr};
     const google::protobuf::Message* root_msg_{nullptr};
     int index_{0};
 
+    // compiled conditions of field_desc_ (owned by the FieldCodecManagerLocal's cache, or by compiled_)
+    const NativeConditions* native_{nullptr};
+    // conditions compiled by native_conditions() when none were given to set_field()
+    std::shared_ptr<const NativeConditions> compiled_;
+
 #if DCCL_HAS_LUA
-    sol::state* lua_{nullptr};
+    // Lua state plus the descriptors, scripts, and messages already loaded into it
+    struct LuaState;
+    std::unique_ptr<LuaState> lua_;
 #endif
 };
 
@@ -30,6 +30,7 @@
 #include <set>
 #include <stdexcept>
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/compiler/importer.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/descriptor.pb.h>
@@ -102,6 +103,18 @@ class DynamicProtobufManager
             get_instance()->msg_factory_->GetPrototype(desc)->New());
     }
 
+    /// \brief Create a new (empty) Google Protobuf message of a given type by Descriptor, allocated on a Google Protobuf Arena
+    ///
+    /// \param desc The Google Protobuf Descriptor of the message to create.
+    /// \param arena Arena to allocate the message on. If nullptr, the message is allocated on the heap and deleting it is up to the caller.
+    /// \return A pointer to the newly created object, owned by `arena` (if not nullptr).
+    static google::protobuf::Message* new_protobuf_message(const google::protobuf::Descriptor* desc,
+                                                           google::protobuf::Arena* arena)
+    {
+        DCCL_LOCK_DYNAMIC_PROTOBUF_MANAGER_MUTEX
+        return get_instance()->msg_factory_->GetPrototype(desc)->New(arena);
+    }
+
     /// \brief Create a new (empty) Google Protobuf message of a given type by Descriptor
     ///
     /// \param desc The Google Protobuf Descriptor of the message to create.
@@ -64,6 +64,16 @@ class NullValueException : public Exception
     NullValueException() : Exception(exception_string("NULL value", nullptr, nullptr)) {}
 };
 
+/// \brief Exception used to stop encoding once the message is known to be larger than the limit given to Codec::encode_if_fits().
+class EncodeSizeExceededException : public Exception
+{
+  public:
+    EncodeSizeExceededException()
+        : Exception(exception_string("Encoded size exceeds limit", nullptr, nullptr))
+    {
+    }
+};
+
 class OutOfRangeException : public std::out_of_range
 {
   public:
@@ -24,10 +24,80 @@
 #include "field_codec.h"
 #include "codec.h"
 #include "exception.h"
+#include "trace.h"
 
 using dccl::dlog;
 using namespace dccl::logger;
 
+namespace
+{
+// records one field in the TraceBuffer set by Codec::set_trace() (does nothing if none is set)
+class FieldTrace
+{
+  public:
+    FieldTrace(dccl::internal::CodecData& data, const dccl::FieldCodecBase& codec,
+               const dccl::Bitset* bits, const google::protobuf::FieldDescriptor* field,
+               unsigned char flags)
+        : data_(data), trace_(data.part_trace_)
+    {
+        if (!trace_)
+            return;
+
+        record_.field_number = field ? field->number() : 0;
+        record_.part = data_.part_;
+        record_.flags = flags;
+        record_.depth = std::min(data_.trace_depth_, 255u);
+
+        // the position is only known for fields written to/read from the part's Bitset directly
+        if (bits == data_.trace_bits_)
+            record_.bit_offset = (flags & dccl::TraceRecord::DECODE)
+                                     ? data_.trace_base_ - bits->size()
+                                     : bits->size() - data_.trace_base_;
+
+        if (flags & dccl::TraceRecord::DECODE)
+            remaining_ = remaining(bits);
+
+        sequence_ = trace_->start(codec, &record_.codec_id);
+        ++data_.trace_depth_;
+    }
+
+    ~FieldTrace()
+    {
+        if (trace_)
+            --data_.trace_depth_;
+    }
+
+    FieldTrace(const FieldTrace&) = delete;
+    FieldTrace& operator=(const FieldTrace&) = delete;
+
+    // for decoding: the number of bits no longer available to `bits` (including its parents)
+    void finish_decode(const dccl::Bitset* bits) { finish(remaining_ - remaining(bits)); }
+
+    void finish(std::size_t bit_length)
+    {
+        if (!trace_)
+            return;
+        record_.bit_length = bit_length;
+        trace_->finish(sequence_, record_);
+    }
+
+  private:
+    static std::size_t remaining(const dccl::Bitset* bits)
+    {
+        std::size_t size = 0;
+        for (; bits; bits = bits->parent()) size += bits->size();
+        return size;
+    }
+
+  private:
+    dccl::internal::CodecData& data_;
+    dccl::TraceBuffer* trace_;
+    dccl::TraceRecord record_;
+    std::size_t remaining_{0};
+    dccl::uint64 sequence_{0};
+};
+} // namespace
+
 //
 // FieldCodecBase public
 //
@@ -37,6 +107,9 @@ void dccl::FieldCodecBase::base_encode(Bitset* bits, const google::protobuf::Mes
                                        MessagePart part, bool strict)
 {
     BaseRAII scoped_globals(this, part, &field_value, strict);
+    internal::CodecData& data = manager().codec_data();
+    data.trace_bits_ = bits;
+    data.trace_base_ = bits->size();
 
     // we pass this through the FromProtoCppTypeBase to do dynamic_cast (RTTI) for
     // custom message codecs so that these codecs can be written in the derived class (not google::protobuf::Message)
@@ -45,10 +118,56 @@ void dccl::FieldCodecBase::base_encode(Bitset* bits, const google::protobuf::Mes
                  nullptr);
 }
 
+// defined before its callers (all in this file) so it can be inlined into each field_encode*()
+inline void dccl::FieldCodecBase::check_encode_limit(internal::CodecData& data,
+                                                     const Bitset& bits)
+{
+    // only Codec::encode_if_fits() sets a limit
+    if (data.encode_bit_limit_ == std::numeric_limits<std::size_t>::max())
+        return;
+
+    if (bits.size() > data.encode_bit_limit_)
+        throw EncodeSizeExceededException();
+}
+
+template <typename StreamEncode, typename BitsEncode>
+void dccl::FieldCodecBase::field_encode_single(internal::CodecData& data, int depth, Bitset* bits,
+                                               const google::protobuf::FieldDescriptor* field,
+                                               StreamEncode encode_stream, BitsEncode encode_bits)
+{
+    FieldTrace trace(data, *this, bits, field, 0);
+    if (streaming())
+    {
+        BitWriter writer(bits);
+        encode_stream(&writer);
+        disp_size(field, writer.size(), depth);
+        trace.finish(writer.size());
+        check_encode_limit(data, *bits);
+
+        if (field)
+            dlog.is(DEBUG2, ENCODE) && dlog << "... produced these " << writer.size()
+                                            << " bits: " << writer.written() << std::endl;
+    }
+    else
+    {
+        Bitset new_bits;
+        encode_bits(&new_bits);
+        disp_size(field, new_bits.size(), depth);
+        trace.finish(new_bits.size());
+        bits->append(new_bits);
+        check_encode_limit(data, *bits);
+
+        if (field)
+            dlog.is(DEBUG2, ENCODE) && dlog << "... produced these " << new_bits.size()
+                                            << " bits: " << new_bits << std::endl;
+    }
+}
+
 void dccl::FieldCodecBase::field_encode(Bitset* bits, const dccl::any& field_value,
                                         const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     if (field)
         dlog.is(DEBUG2, ENCODE) && dlog << "Starting encode for field: " << field->DebugString()
@@ -57,29 +176,56 @@ void dccl::FieldCodecBase::field_encode(Bitset* bits, const dccl::any& field_val
     dccl::any wire_value;
     field_pre_encode(&wire_value, field_value);
 
-    Bitset new_bits;
-    any_encode(&new_bits, wire_value);
-    disp_size(field, new_bits, msg_handler.field_size());
-    bits->append(new_bits);
-
-    if (field)
-        dlog.is(DEBUG2, ENCODE) && dlog << "... produced these " << new_bits.size()
-                                        << " bits: " << new_bits << std::endl;
+    field_encode_single(
+        data, msg_handler.field_size(), bits, field,
+        [&](BitWriter* writer) { any_encode_stream(writer, wire_value); },
+        [&](Bitset* new_bits) { any_encode(new_bits, wire_value); });
 }
 
 void dccl::FieldCodecBase::field_encode_repeated(Bitset* bits,
                                                  const std::vector<dccl::any>& field_values,
                                                  const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     std::vector<dccl::any> wire_values;
     field_pre_encode_repeated(&wire_values, field_values);
 
-    Bitset new_bits;
-    any_encode_repeated(&new_bits, wire_values);
-    disp_size(field, new_bits, msg_handler.field_size(), wire_values.size());
-    bits->append(new_bits);
+    FieldTrace trace(data, *this, bits, field, TraceRecord::REPEATED);
+    if (streaming())
+    {
+        // any_encode_repeated appends to the most significant end, so we can write directly
+        BitWriter writer(bits);
+        any_encode_repeated(bits, wire_values);
+        disp_size(field, writer.size(), msg_handler.field_size(), wire_values.size());
+        trace.finish(writer.size());
+        check_encode_limit(data, *bits);
+    }
+    else
+    {
+        Bitset new_bits;
+        any_encode_repeated(&new_bits, wire_values);
+        disp_size(field, new_bits.size(), msg_handler.field_size(), wire_values.size());
+        trace.finish(new_bits.size());
+        bits->append(new_bits);
+        check_encode_limit(data, *bits);
+    }
+}
+
+void dccl::FieldCodecBase::field_encode_direct(Bitset* bits, const google::protobuf::Message& msg,
+                                               const google::protobuf::FieldDescriptor* field)
+{
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
+
+    dlog.is(DEBUG2, ENCODE) && dlog << "Starting encode for field: " << field->DebugString()
+                                    << std::flush;
+
+    field_encode_single(
+        data, msg_handler.field_size(), bits, field,
+        [&](BitWriter* writer) { direct_encode(writer, msg, field); },
+        [&](Bitset* new_bits) { direct_encode(new_bits, msg, field); });
 }
 
 void dccl::FieldCodecBase::base_size(unsigned* bit_size, const google::protobuf::Message& msg,
@@ -95,7 +241,8 @@ void dccl::FieldCodecBase::base_size(unsigned* bit_size, const google::protobuf:
 void dccl::FieldCodecBase::field_size(unsigned* bit_size, const dccl::any& field_value,
                                       const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     dccl::any wire_value;
     field_pre_encode(&wire_value, field_value);
@@ -103,11 +250,22 @@ void dccl::FieldCodecBase::field_size(unsigned* bit_size, const dccl::any& field
     *bit_size += any_size(wire_value);
 }
 
+void dccl::FieldCodecBase::field_size_direct(unsigned* bit_size,
+                                             const google::protobuf::Message& msg,
+                                             const google::protobuf::FieldDescriptor* field)
+{
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
+
+    *bit_size += direct_size(msg, field);
+}
+
 void dccl::FieldCodecBase::field_size_repeated(unsigned* bit_size,
                                                const std::vector<dccl::any>& field_values,
                                                const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     std::vector<dccl::any> wire_values;
     field_pre_encode_repeated(&wire_values, field_values);
@@ -119,20 +277,18 @@ void dccl::FieldCodecBase::base_decode(Bitset* bits, google::protobuf::Message*
                                        MessagePart part)
 {
     BaseRAII scoped_globals(this, part, field_value);
+    internal::CodecData& data = manager().codec_data();
+    data.trace_bits_ = bits;
+    data.trace_base_ = bits->size();
     dccl::any value(field_value);
     field_decode(bits, &value, nullptr);
 }
 
-void dccl::FieldCodecBase::field_decode(Bitset* bits, dccl::any* field_value,
-                                        const google::protobuf::FieldDescriptor* field)
+template <typename StreamDecode, typename BitsDecode>
+void dccl::FieldCodecBase::field_decode_single(internal::CodecData& data, Bitset* bits,
+                                               const google::protobuf::FieldDescriptor* field,
+                                               StreamDecode decode_stream, BitsDecode decode_bits)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
-
-    if (!field_value)
-        throw(Exception("Decode called with NULL dccl::any"));
-    else if (!bits)
-        throw(Exception("Decode called with NULL Bitset"));
-
     if (field)
         dlog.is(DEBUG2, DECODE) && dlog << "Starting decode for field: " << field->DebugString()
                                         << std::flush;
@@ -141,26 +297,70 @@ void dccl::FieldCodecBase::field_decode(Bitset* bits, dccl::any* field_value,
         dlog.is(DEBUG3, DECODE) && dlog << "Message thus far is: " << root_message()->DebugString()
                                         << std::flush;
 
-    Bitset these_bits(bits);
+    FieldTrace trace(data, *this, bits, field, TraceRecord::DECODE);
+    if (streaming())
+    {
+        BitReader reader(bits);
+        decode_stream(&reader);
+        trace.finish_decode(bits);
 
-    unsigned bits_to_transfer = 0;
-    field_min_size(&bits_to_transfer, field);
-    these_bits.get_more_bits(bits_to_transfer);
+        if (field)
+            dlog.is(DEBUG2, DECODE) && dlog << "... used " << reader.consumed() << " bits"
+                                            << std::endl;
+    }
+    else
+    {
+        Bitset these_bits(bits);
 
-    if (field)
-        dlog.is(DEBUG2, DECODE) && dlog << "... using these bits: " << these_bits << std::endl;
+        unsigned bits_to_transfer = 0;
+        field_min_size(&bits_to_transfer, field);
+        these_bits.get_more_bits(bits_to_transfer);
+
+        if (field)
+            dlog.is(DEBUG2, DECODE) && dlog << "... using these bits: " << these_bits
+                                            << std::endl;
+
+        decode_bits(&these_bits);
+        trace.finish_decode(bits);
+    }
+}
+
+void dccl::FieldCodecBase::field_decode(Bitset* bits, dccl::any* field_value,
+                                        const google::protobuf::FieldDescriptor* field)
+{
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
+
+    if (!field_value)
+        throw(Exception("Decode called with NULL dccl::any"));
+    else if (!bits)
+        throw(Exception("Decode called with NULL Bitset"));
 
     dccl::any wire_value = *field_value;
 
-    any_decode(&these_bits, &wire_value);
+    field_decode_single(
+        data, bits, field, [&](BitReader* reader) { any_decode_stream(reader, &wire_value); },
+        [&](Bitset* these_bits) { any_decode(these_bits, &wire_value); });
 
     field_post_decode(wire_value, field_value);
 }
 
+void dccl::FieldCodecBase::field_decode_direct(Bitset* bits, google::protobuf::Message* msg,
+                                               const google::protobuf::FieldDescriptor* field)
+{
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
+
+    field_decode_single(
+        data, bits, field, [&](BitReader* reader) { direct_decode(reader, msg, field); },
+        [&](Bitset* these_bits) { direct_decode(these_bits, msg, field); });
+}
+
 void dccl::FieldCodecBase::field_decode_repeated(Bitset* bits, std::vector<dccl::any>* field_values,
                                                  const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     if (!field_values)
         throw(Exception("Decode called with NULL field_values"));
@@ -171,17 +371,30 @@ void dccl::FieldCodecBase::field_decode_repeated(Bitset* bits, std::vector<dccl:
         dlog.is(DEBUG2, DECODE) &&
             dlog << "Starting repeated decode for field: " << field->DebugString() << std::endl;
 
-    Bitset these_bits(bits);
+    std::vector<dccl::any> wire_values = *field_values;
+
+    FieldTrace trace(data, *this, bits, field,
+                     TraceRecord::DECODE | TraceRecord::REPEATED);
+    if (streaming())
+    {
+        // any_decode_repeated reads from the least significant end, so we can read directly
+        any_decode_repeated(bits, &wire_values);
+        trace.finish_decode(bits);
+    }
+    else
+    {
+        Bitset these_bits(bits);
 
-    unsigned bits_to_transfer = 0;
-    field_min_size(&bits_to_transfer, field);
-    these_bits.get_more_bits(bits_to_transfer);
+        unsigned bits_to_transfer = 0;
+        field_min_size(&bits_to_transfer, field);
+        these_bits.get_more_bits(bits_to_transfer);
 
-    dlog.is(DEBUG2, DECODE) && dlog << "using these " << these_bits.size()
-                                    << " bits: " << these_bits << std::endl;
+        dlog.is(DEBUG2, DECODE) && dlog << "using these " << these_bits.size()
+                                        << " bits: " << these_bits << std::endl;
 
-    std::vector<dccl::any> wire_values = *field_values;
-    any_decode_repeated(&these_bits, &wire_values);
+        any_decode_repeated(&these_bits, &wire_values);
+        trace.finish_decode(bits);
+    }
 
     field_values->clear();
     field_post_decode_repeated(wire_values, field_values);
@@ -205,7 +418,8 @@ void dccl::FieldCodecBase::base_max_size(unsigned* bit_size,
 void dccl::FieldCodecBase::field_max_size(unsigned* bit_size,
                                           const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     if (this_field())
         *bit_size += this_field()->is_repeated() ? max_size_repeated() : max_size();
@@ -233,7 +447,8 @@ void dccl::FieldCodecBase::field_min_size(unsigned* bit_size,
                                           const google::protobuf::FieldDescriptor* field)
 
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     if (this_field())
         *bit_size += this_field()->is_repeated() ? min_size_repeated() : min_size();
@@ -258,7 +473,8 @@ void dccl::FieldCodecBase::base_validate(const google::protobuf::Descriptor* des
 void dccl::FieldCodecBase::field_validate(bool* /*b*/,
                                           const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     if (field && dccl_field_options().in_head() && variable_size())
         throw(Exception("Variable size codec used in header - header fields must be encoded with "
@@ -268,6 +484,10 @@ void dccl::FieldCodecBase::field_validate(bool* /*b*/,
         throw(Exception(
             "Oneof field used in header - oneof fields cannot be encoded in the header."));
 
+    // compile any dynamic conditions now rather than on the first encode/decode
+    if (field && dccl_field_options().has_dynamic_conditions())
+        manager().native_conditions(field);
+
     validate();
 }
 
@@ -288,7 +508,8 @@ void dccl::FieldCodecBase::base_info(std::ostream* os, const google::protobuf::D
 void dccl::FieldCodecBase::field_info(std::ostream* os,
                                       const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     std::stringstream ss;
     int depth = msg_handler.count();
@@ -366,7 +587,8 @@ void dccl::FieldCodecBase::base_hash(std::size_t* hash, const google::protobuf::
 void dccl::FieldCodecBase::field_hash(std::size_t* hash_value,
                                       const google::protobuf::FieldDescriptor* field)
 {
-    internal::MessageStack msg_handler(root_message(), message_data(), field);
+    internal::CodecData& data = manager().codec_data();
+    internal::MessageStack msg_handler(data.root_message_, data.message_data_, field);
 
     if (field && dccl_field_options().in_head() && variable_size())
         throw(Exception("Variable size codec used in header - header fields must be encoded with "
@@ -447,15 +669,17 @@ void dccl::FieldCodecBase::any_encode_repeated(dccl::Bitset* bits,
         wire_vector_size = std::max(static_cast<int>(dccl_field_options().min_repeat()),
                                     static_cast<int>(wire_vector_size));
 
-        Bitset size_bits(repeated_vector_field_size(dccl_field_options().min_repeat(),
-                                                    dccl_field_options().max_repeat()),
-                         wire_vector_size - dccl_field_options().min_repeat());
-        bits->append(size_bits);
+        BitWriter size_writer(bits);
+        size_writer.write(wire_vector_size - dccl_field_options().min_repeat(),
+                          repeated_vector_field_size(dccl_field_options().min_repeat(),
+                                                     dccl_field_options().max_repeat()));
 
         dlog.is(DEBUG2, ENCODE) && dlog << "repeated size field ... produced these "
-                                        << size_bits.size() << " bits: " << size_bits << std::endl;
+                                        << size_writer.size()
+                                        << " bits: " << size_writer.written() << std::endl;
     }
 
+    const dccl::any empty_value;
     internal::MessageStack msg_handler(root_message(), message_data(), this->this_field());
     for (unsigned i = 0, n = wire_vector_size; i < n; ++i)
     {
@@ -470,12 +694,18 @@ void dccl::FieldCodecBase::any_encode_repeated(dccl::Bitset* bits,
                 continue;
         }
 
-        Bitset new_bits;
-        if (i < wire_values.size())
-            any_encode(&new_bits, wire_values[i]);
+        const dccl::any& wire_value = (i < wire_values.size()) ? wire_values[i] : empty_value;
+        if (streaming())
+        {
+            BitWriter writer(bits);
+            any_encode_stream(&writer, wire_value);
+        }
         else
-            any_encode(&new_bits, dccl::any());
-        bits->append(new_bits);
+        {
+            Bitset new_bits;
+            any_encode(&new_bits, wire_value);
+            bits->append(new_bits);
+        }
     }
 }
 
@@ -485,11 +715,10 @@ void dccl::FieldCodecBase::any_decode_repeated(Bitset* repeated_bits,
     unsigned wire_vector_size = dccl_field_options().max_repeat();
     if (codec_version() > 2)
     {
-        Bitset size_bits(repeated_bits);
-        size_bits.get_more_bits(repeated_vector_field_size(dccl_field_options().min_repeat(),
-                                                           dccl_field_options().max_repeat()));
-
-        wire_vector_size = size_bits.to_ulong() + dccl_field_options().min_repeat();
+        BitReader size_reader(repeated_bits);
+        wire_vector_size = size_reader.read(repeated_vector_field_size(
+                               dccl_field_options().min_repeat(), dccl_field_options().max_repeat())) +
+                           dccl_field_options().min_repeat();
     }
 
     wire_values->resize(wire_vector_size);
@@ -508,9 +737,17 @@ void dccl::FieldCodecBase::any_decode_repeated(Bitset* repeated_bits,
                 continue;
         }
 
-        Bitset these_bits(repeated_bits);
-        these_bits.get_more_bits(min_size());
-        any_decode(&these_bits, &(*wire_values)[i]);
+        if (streaming())
+        {
+            BitReader reader(repeated_bits);
+            any_decode_stream(&reader, &(*wire_values)[i]);
+        }
+        else
+        {
+            Bitset these_bits(repeated_bits);
+            these_bits.get_more_bits(min_size());
+            any_decode(&these_bits, &(*wire_values)[i]);
+        }
     }
 }
 
@@ -615,7 +852,7 @@ void dccl::FieldCodecBase::any_post_decode_repeated(const std::vector<dccl::any>
 //
 
 void dccl::FieldCodecBase::disp_size(const google::protobuf::FieldDescriptor* field,
-                                     const Bitset& new_bits, int depth, int vector_size /* = -1 */)
+                                     unsigned bit_size, int depth, int vector_size /* = -1 */)
 {
     if (!root_descriptor())
         return;
@@ -627,7 +864,7 @@ void dccl::FieldCodecBase::disp_size(const google::protobuf::FieldDescriptor* fi
             name += "[" + std::to_string(vector_size) + "]";
 
         dlog.is(DEBUG2, SIZE) && dlog << std::string(depth, '|') << name << std::setfill('.')
-                                      << std::setw(40 - name.size() - depth) << new_bits.size()
+                                      << std::setw(40 - name.size() - depth) << bit_size
                                       << std::endl;
 
         if (!field)
@@ -709,8 +946,10 @@ std::string dccl::FieldCodecBase::codec_group() { return codec_group(root_descri
 dccl::DynamicConditions&
 dccl::FieldCodecBase::dynamic_conditions(const google::protobuf::FieldDescriptor* field)
 {
-    manager().codec_data().dynamic_conditions_.set_field(field);
-    return manager().codec_data().dynamic_conditions_;
+    DynamicConditions& dc = manager().codec_data().dynamic_conditions_;
+    if (dc.field() != field)
+        dc.set_field(field, manager().native_conditions(field));
+    return dc;
 }
 
 dccl::FieldCodecBase::BaseRAII::BaseRAII(FieldCodecBase* field_codec, MessagePart part,
@@ -719,25 +958,33 @@ dccl::FieldCodecBase::BaseRAII::BaseRAII(FieldCodecBase* field_codec, MessagePar
     : field_codec_(field_codec)
 
 {
-    field_codec_->manager().codec_data().part_ = part;
-    field_codec_->manager().codec_data().strict_ = strict;
-    field_codec_->manager().codec_data().root_message_ = nullptr;
-    field_codec_->manager().codec_data().root_descriptor_ = root_descriptor;
+    internal::CodecData& data = field_codec_->manager().codec_data();
+    data.part_ = part;
+    data.strict_ = strict;
+    data.root_message_ = nullptr;
+    data.root_descriptor_ = root_descriptor;
+    // only trace the fields of the message itself (not e.g. the DCCL ID when looking it up)
+    data.part_trace_ = (part == dccl::UNKNOWN) ? nullptr : data.trace_;
 }
 dccl::FieldCodecBase::BaseRAII::BaseRAII(FieldCodecBase* field_codec, MessagePart part,
                                          const google::protobuf::Message* root_message, bool strict)
     : field_codec_(field_codec)
 
 {
-    field_codec_->manager().codec_data().part_ = part;
-    field_codec_->manager().codec_data().strict_ = strict;
-    field_codec_->manager().codec_data().root_message_ = root_message;
-    field_codec_->manager().codec_data().root_descriptor_ = root_message->GetDescriptor();
+    internal::CodecData& data = field_codec_->manager().codec_data();
+    data.part_ = part;
+    data.strict_ = strict;
+    data.root_message_ = root_message;
+    data.root_descriptor_ = root_message->GetDescriptor();
+    // only trace the fields of the message itself (not e.g. the DCCL ID when looking it up)
+    data.part_trace_ = (part == dccl::UNKNOWN) ? nullptr : data.trace_;
 }
 dccl::FieldCodecBase::BaseRAII::~BaseRAII()
 {
-    field_codec_->manager().codec_data().part_ = dccl::UNKNOWN;
-    field_codec_->manager().codec_data().strict_ = false;
-    field_codec_->manager().codec_data().root_message_ = nullptr;
-    field_codec_->manager().codec_data().root_descriptor_ = nullptr;
+    internal::CodecData& data = field_codec_->manager().codec_data();
+    data.part_ = dccl::UNKNOWN;
+    data.strict_ = false;
+    data.root_message_ = nullptr;
+    data.root_descriptor_ = nullptr;
+    data.part_trace_ = nullptr;
 }
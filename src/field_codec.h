@@ -24,6 +24,7 @@
 #ifndef DCCLFIELDCODEC20110322H
 #define DCCLFIELDCODEC20110322H
 
+#include <atomic>
 #include <map>
 #include <string>
 
@@ -47,7 +48,8 @@ class Codec;
 namespace internal
 {
 class MessageStack;
-}
+struct CodecData;
+} // namespace internal
 
 /// \brief Provides a base class for defining DCCL field encoders / decoders. Most users who wish to define custom encoders/decoders will use the RepeatedTypedFieldCodec, TypedFieldCodec or its children (e.g. TypedFixedFieldCodec) instead of directly inheriting from this class.
 class FieldCodecBase
@@ -74,6 +76,11 @@ class FieldCodecBase
     /// \return the C++ type used to encode and decode. See http://code.google.com/apis/protocolbuffers/docs/reference/cpp/google.protobuf.descriptor.html#FieldDescriptor.CppType.details
     google::protobuf::FieldDescriptor::CppType wire_type() const { return wire_type_; }
 
+    /// \brief Whether this codec encodes / decodes directly to / from the message's Bitset using a BitWriter / BitReader cursor (any_encode_stream() and any_decode_stream()) rather than through a new Bitset for each field (any_encode() and any_decode()).
+    ///
+    /// Codecs opt in by overriding this method. Since derived classes may override the Bitset based methods, codecs should generally only return true for their exact type (not derived types).
+    virtual bool streaming() { return false; }
+
     /// \brief Returns the FieldDescriptor (field schema  meta-data) for this field
     ///
     /// \return FieldDescriptor for the current field or 0 if this codec is encoding the base message.
@@ -276,6 +283,27 @@ class FieldCodecBase
     void field_decode_repeated(Bitset* bits, std::vector<dccl::any>* field_values,
                                const google::protobuf::FieldDescriptor* field);
 
+    /// \brief Whether field_encode_direct(), field_size_direct() and field_decode_direct() can be used for this (singular) field. These read and write the field's value in its parent message with the typed codec interface, without boxing it in a dccl::any.
+    ///
+    /// TypedFieldCodec returns true when its FieldType is a scalar Protobuf C++ type matching the field.
+    virtual bool direct_access(const google::protobuf::FieldDescriptor* /*field*/) { return false; }
+
+    /// \brief Encode a non-repeated field, reading its value directly from the parent message. Equivalent to field_encode() with the field's value (or an empty value if unset).
+    ///
+    /// \param bits Pointer to bitset to store encoded bits. Bits are added to the most significant end of `bits`
+    /// \param msg Parent message of `field`
+    /// \param field Protobuf descriptor to the field to encode.
+    void field_encode_direct(Bitset* bits, const google::protobuf::Message& msg,
+                             const google::protobuf::FieldDescriptor* field);
+
+    /// \brief Calculate the size of a non-repeated field, reading its value directly from the parent message. Equivalent to field_size() with the field's value (or an empty value if unset).
+    void field_size_direct(unsigned* bit_size, const google::protobuf::Message& msg,
+                           const google::protobuf::FieldDescriptor* field);
+
+    /// \brief Decode a non-repeated field, setting its value directly in the parent message. Equivalent to field_decode() followed by setting the field if the decoded value is not empty.
+    void field_decode_direct(Bitset* bits, google::protobuf::Message* msg,
+                             const google::protobuf::FieldDescriptor* field);
+
     /// \brief Post-decodes a non-repeated (i.e. optional or required) field by converting the WireType (the type used in the encoded DCCL message) representation into the FieldType representation (the Google Protobuf representation). This allows for type-converting codecs.
     ///
     /// \param wire_value Should be set to the desired value to translate
@@ -422,6 +450,66 @@ class FieldCodecBase
     /// \param wire_value Place to store decoded value (as FieldType)
     virtual void any_decode(Bitset* bits, dccl::any* wire_value) = 0;
 
+    /// \brief Virtual method used to encode when streaming() is true
+    ///
+    /// \param writer Cursor to write encoded bits to (to the most significant end of the message's Bitset)
+    /// \param wire_value Value to encode (WireType)
+    virtual void any_encode_stream(BitWriter* writer, const dccl::any& wire_value)
+    {
+        Bitset bits;
+        any_encode(&bits, wire_value);
+        writer->write(bits);
+    }
+
+    /// \brief Virtual method used to decode when streaming() is true
+    ///
+    /// \param reader Cursor to read bits from. Unlike any_decode(), no bits are read in advance: read exactly the bits required.
+    /// \param wire_value Place to store decoded value (as FieldType)
+    virtual void any_decode_stream(BitReader* reader, dccl::any* wire_value)
+    {
+        Bitset bits(reader->bits());
+        bits.get_more_bits(min_size());
+        any_decode(&bits, wire_value);
+    }
+
+    /// \name Direct field access (see direct_access())
+    //@{
+    /// \brief Virtual method used to encode the value of `field` in `msg` (pre-encoded), or an empty field if unset
+    virtual void direct_encode(Bitset* /*bits*/, const google::protobuf::Message& /*msg*/,
+                               const google::protobuf::FieldDescriptor* /*field*/)
+    {
+        throw(Exception("Direct field access is not supported by codec: " + name()));
+    }
+
+    /// \brief Virtual method used to encode the value of `field` in `msg` when streaming() is true
+    virtual void direct_encode(BitWriter* /*writer*/, const google::protobuf::Message& /*msg*/,
+                               const google::protobuf::FieldDescriptor* /*field*/)
+    {
+        throw(Exception("Direct field access is not supported by codec: " + name()));
+    }
+
+    /// \brief Virtual method used to calculate the size of the value of `field` in `msg`
+    virtual unsigned direct_size(const google::protobuf::Message& /*msg*/,
+                                 const google::protobuf::FieldDescriptor* /*field*/)
+    {
+        throw(Exception("Direct field access is not supported by codec: " + name()));
+    }
+
+    /// \brief Virtual method used to decode `field` and set it (post-decoded) in `msg`, unless empty
+    virtual void direct_decode(Bitset* /*bits*/, google::protobuf::Message* /*msg*/,
+                               const google::protobuf::FieldDescriptor* /*field*/)
+    {
+        throw(Exception("Direct field access is not supported by codec: " + name()));
+    }
+
+    /// \brief Virtual method used to decode `field` and set it in `msg` when streaming() is true
+    virtual void direct_decode(BitReader* /*reader*/, google::protobuf::Message* /*msg*/,
+                               const google::protobuf::FieldDescriptor* /*field*/)
+    {
+        throw(Exception("Direct field access is not supported by codec: " + name()));
+    }
+    //@}
+
     /// \brief Virtual method used to pre-encode (convert from FieldType to WireType). The default implementation of this method is for when WireType == FieldType and simply copies the field_value to the wire_value.
     ///
     /// \param wire_value Converted value (WireType)
@@ -503,8 +591,23 @@ class FieldCodecBase
         return dccl::ceil_log2(max_repeat - min_repeat + 1);
     }
 
-    void disp_size(const google::protobuf::FieldDescriptor* field, const Bitset& new_bits,
-                   int depth, int vector_size = -1);
+    void disp_size(const google::protobuf::FieldDescriptor* field, unsigned bit_size, int depth,
+                   int vector_size = -1);
+
+    // throws EncodeSizeExceededException if bits (a lower bound on the final encoded size) exceeds the limit set by Codec::encode_if_fits()
+    void check_encode_limit(internal::CodecData& data, const Bitset& bits);
+
+    // common to field_encode() and field_encode_direct(): writes one field with encode_stream(BitWriter*) for streaming() codecs or encode_bits(Bitset*) otherwise
+    template <typename StreamEncode, typename BitsEncode>
+    void field_encode_single(internal::CodecData& data, int depth, Bitset* bits,
+                             const google::protobuf::FieldDescriptor* field,
+                             StreamEncode encode_stream, BitsEncode encode_bits);
+
+    // common to field_decode() and field_decode_direct(): reads one field with decode_stream(BitReader*) for streaming() codecs or decode_bits(Bitset*) otherwise
+    template <typename StreamDecode, typename BitsDecode>
+    void field_decode_single(internal::CodecData& data, Bitset* bits,
+                             const google::protobuf::FieldDescriptor* field,
+                             StreamDecode decode_stream, BitsDecode decode_bits);
 
   private:
     // sets global statics relating the current message begin processed
@@ -522,6 +625,7 @@ class FieldCodecBase
         FieldCodecBase* field_codec_;
     };
     friend struct BaseRAII;
+    friend class TraceBuffer;
 
     std::string name_;
     google::protobuf::FieldDescriptor::Type field_type_;
@@ -530,6 +634,9 @@ class FieldCodecBase
     bool force_required_{false};
 
     FieldCodecManagerLocal* manager_{nullptr};
+
+    // this codec's id in the TraceBuffer it was last traced into, as (TraceBuffer serial << 16) | id, or 0 if never traced (see TraceBuffer::codec_id())
+    mutable std::atomic<uint64> trace_codec_id_{0};
 };
 
 std::ostream& operator<<(std::ostream& os, const FieldCodecBase& field_codec);
@@ -23,6 +23,8 @@
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
 #include "field_codec_manager.h"
 
+thread_local dccl::internal::CodecDataScope* dccl::internal::CodecDataScope::innermost_ = nullptr;
+
 dccl::FieldCodecManagerLocal::FieldCodecManagerLocal()
     : deprecated_names_{{"_static", "dccl.static"}, {"_time", "dccl.time"}}
 {
@@ -72,6 +74,134 @@ dccl::FieldCodecManagerLocal::__find(google::protobuf::FieldDescriptor::Type typ
     throw(Exception(err_ss.str()));
 }
 
+std::shared_ptr<dccl::FieldCodecBase>
+dccl::FieldCodecManagerLocal::find(const google::protobuf::FieldDescriptor* field,
+                                   int codec_version, bool has_codec_group,
+                                   const std::string& codec_group) const
+{
+    std::size_t generation;
+    {
+#if DCCL_THREAD_SUPPORT
+        std::shared_lock<internal::SharedMutex> l(cache_mutex_);
+#endif
+        generation = generation_;
+        auto it = field_codec_cache_.find(field);
+        if (it != field_codec_cache_.end())
+        {
+            for (const CachedFieldCodec& cached : it->second)
+            {
+                if (cached.codec_version == codec_version &&
+                    cached.has_codec_group == has_codec_group &&
+                    (!has_codec_group || cached.codec_group == codec_group))
+                    return cached.codec;
+            }
+        }
+    }
+
+    std::string name = __find_codec(field, has_codec_group, codec_group);
+
+    std::shared_ptr<FieldCodecBase> codec;
+    if (field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE)
+        codec = find(field->message_type(), codec_version, name);
+    else
+        codec = __find(field->type(), codec_version, name, "");
+
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<internal::SharedMutex> l(cache_mutex_);
+#endif
+    if (generation == generation_)
+        field_codec_cache_[field].push_back(
+            {codec_version, has_codec_group, has_codec_group ? codec_group : std::string(), codec});
+    return codec;
+}
+
+std::shared_ptr<dccl::FieldCodecBase>
+dccl::FieldCodecManagerLocal::find_root(const google::protobuf::Descriptor* desc) const
+{
+    std::size_t generation;
+    {
+#if DCCL_THREAD_SUPPORT
+        std::shared_lock<internal::SharedMutex> l(cache_mutex_);
+#endif
+        generation = generation_;
+        auto it = root_codec_cache_.find(desc);
+        if (it != root_codec_cache_.end())
+            return it->second;
+    }
+
+    std::string name;
+    // explicitly declared codec takes precedence over group
+    if (desc->options().GetExtension(dccl::msg).has_codec())
+        name = desc->options().GetExtension(dccl::msg).codec();
+    else
+        name = FieldCodecBase::codec_group(desc);
+    int codec_version = desc->options().GetExtension(dccl::msg).codec_version();
+
+    std::shared_ptr<FieldCodecBase> codec = __find(google::protobuf::FieldDescriptor::TYPE_MESSAGE,
+                                                   codec_version, name, desc->full_name());
+
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<internal::SharedMutex> l(cache_mutex_);
+#endif
+    if (generation == generation_)
+        root_codec_cache_[desc] = codec;
+    return codec;
+}
+
+dccl::FieldCodecBase*
+dccl::FieldCodecManagerLocal::find_root_codec(const google::protobuf::Descriptor* desc) const
+{
+    {
+#if DCCL_THREAD_SUPPORT
+        std::shared_lock<internal::SharedMutex> l(cache_mutex_);
+#endif
+        auto it = root_codec_cache_.find(desc);
+        if (it != root_codec_cache_.end())
+            return it->second.get();
+    }
+    // owned by codecs_, so valid even if not cached
+    return find_root(desc).get();
+}
+
+void dccl::FieldCodecManagerLocal::invalidate()
+{
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<internal::SharedMutex> l(cache_mutex_);
+#endif
+    ++generation_;
+    field_codec_cache_.clear();
+    root_codec_cache_.clear();
+    native_conditions_cache_.clear();
+    codec_data_.dynamic_conditions_.reset();
+}
+
+const dccl::DynamicConditions::NativeConditions*
+dccl::FieldCodecManagerLocal::native_conditions(const google::protobuf::FieldDescriptor* field) const
+{
+    std::size_t generation;
+    {
+#if DCCL_THREAD_SUPPORT
+        std::shared_lock<internal::SharedMutex> l(cache_mutex_);
+#endif
+        generation = generation_;
+        auto it = native_conditions_cache_.find(field);
+        if (it != native_conditions_cache_.end())
+            return it->second.get();
+    }
+
+    // compile outside the lock
+    std::shared_ptr<const DynamicConditions::NativeConditions> native =
+        DynamicConditions::compile(field);
+
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<internal::SharedMutex> l(cache_mutex_);
+#endif
+    if (generation != generation_)
+        return nullptr;
+    // another thread may have compiled the same conditions in the meantime
+    return native_conditions_cache_.emplace(field, std::move(native)).first->second.get();
+}
+
 void dccl::FieldCodecManagerLocal::check_deprecated(const std::string& codec_name) const
 {
     auto it = deprecated_names_.find(codec_name);
@@ -82,3 +212,59 @@ void dccl::FieldCodecManagerLocal::check_deprecated(const std::string& codec_nam
                                               << "\" instead " << std::endl;
     }
 }
+
+dccl::internal::CodecDataScope::CodecDataScope(const FieldCodecManagerLocal& manager)
+    : manager_(manager), previous_(innermost_)
+{
+    {
+#if DCCL_THREAD_SUPPORT
+        std::lock_guard<std::mutex> l(manager.codec_data_pool_mutex_);
+#endif
+        if (!manager.codec_data_pool_.empty())
+        {
+            data_ = std::move(manager.codec_data_pool_.back());
+            manager.codec_data_pool_.pop_back();
+        }
+    }
+
+    if (!data_)
+    {
+        data_.reset(new CodecData);
+        // codec specific data belongs to the manager, so is shared rather than copied
+        data_->codec_specific_ = manager.codec_data_.codec_specific_;
+    }
+
+    innermost_ = this;
+}
+
+dccl::internal::CodecDataScope::~CodecDataScope()
+{
+    innermost_ = previous_;
+    data_->part_ = dccl::UNKNOWN;
+    data_->strict_ = false;
+    data_->root_message_ = nullptr;
+    data_->root_descriptor_ = nullptr;
+    data_->encode_bit_limit_ = std::numeric_limits<std::size_t>::max();
+    data_->trace_ = nullptr;
+    data_->part_trace_ = nullptr;
+    data_->trace_bits_ = nullptr;
+    data_->trace_base_ = 0;
+    data_->trace_depth_ = 0;
+    data_->dynamic_conditions_.reset();
+
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<std::mutex> l(manager_.codec_data_pool_mutex_);
+#endif
+    manager_.codec_data_pool_.push_back(std::move(data_));
+}
+
+dccl::internal::CodecData*
+dccl::internal::CodecDataScope::active_outer(const FieldCodecManagerLocal& manager)
+{
+    for (CodecDataScope* scope = innermost_->previous_; scope; scope = scope->previous_)
+    {
+        if (&scope->manager_ == &manager)
+            return scope->data_.get();
+    }
+    return nullptr;
+}
@@ -25,6 +25,7 @@
 #define FieldCodecManager20110405H
 
 #include <type_traits>
+#include <unordered_map>
 
 #include "field_codec.h"
 #include "internal/field_codec_data.h"
@@ -111,17 +112,11 @@ class FieldCodecManagerLocal
     void remove(const std::string& name);
 
     /// \brief Find the codec for a given field. For embedded messages, prefers (dccl.field).codec (inside field) over (dccl.msg).codec (inside embedded message).
+    ///
+    /// The result is cached per field (and codec version and group) until the set of codecs changes (see generation()).
     std::shared_ptr<FieldCodecBase> find(const google::protobuf::FieldDescriptor* field,
                                          int codec_version, bool has_codec_group,
-                                         const std::string& codec_group) const
-    {
-        std::string name = __find_codec(field, has_codec_group, codec_group);
-
-        if (field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE)
-            return find(field->message_type(), codec_version, name);
-        else
-            return __find(field->type(), codec_version, name, "");
-    }
+                                         const std::string& codec_group) const;
 
     /// \brief Find the codec for a given base (or embedded) message.
     ///
@@ -132,14 +127,7 @@ class FieldCodecManagerLocal
     {
         // this was called on the root message
         if (name.empty())
-        {
-            // explicitly declared codec takes precedence over group
-            if (desc->options().GetExtension(dccl::msg).has_codec())
-                name = desc->options().GetExtension(dccl::msg).codec();
-            else
-                name = FieldCodecBase::codec_group(desc);
-            codec_version = desc->options().GetExtension(dccl::msg).codec_version();
-        }
+            return find_root(desc);
 
         return __find(google::protobuf::FieldDescriptor::TYPE_MESSAGE, codec_version, name,
                       desc->full_name());
@@ -151,26 +139,71 @@ class FieldCodecManagerLocal
         return __find(type, codec_version, name, "");
     }
 
+    /// \brief Find the codec for a base message, as find(desc) but without copying the shared_ptr (for the encode, decode and size calls).
+    ///
+    /// The codec is owned by this manager, so the pointer remains valid until the codec is removed (or the manager is cleared).
+    FieldCodecBase* find_root_codec(const google::protobuf::Descriptor* desc) const;
+
     void clear()
     {
         type_helper_.reset();
         codecs_.clear();
+        invalidate();
     }
 
+    /// \brief Counter incremented whenever the set of codecs changes (add, remove, clear) or invalidate() is called. Used by codecs to discard cached lookups (e.g. precomputed message plans).
+    std::size_t generation() const { return generation_; }
+
+    /// \brief Discard any lookups cached against the current set of codecs and descriptors (e.g. when a Descriptor is unloaded and may be destroyed).
+    void invalidate();
+
+    /// \brief The dynamic conditions of a field compiled into native expressions, cached per FieldDescriptor until invalidate() is called. Filled when messages are validated (by Codec::load()).
+    ///
+    /// \return The cached conditions, which remain valid until invalidate() is called, or nullptr if invalidate() was called while they were being compiled (in which case the caller should compile its own with DynamicConditions::compile())
+    const DynamicConditions::NativeConditions*
+    native_conditions(const google::protobuf::FieldDescriptor* field) const;
+
     internal::TypeHelper& type_helper() { return type_helper_; }
     const internal::TypeHelper& type_helper() const { return type_helper_; }
 
-    internal::CodecData& codec_data() { return codec_data_; }
-    const internal::CodecData& codec_data() const { return codec_data_; }
+    /// \brief Data shared amongst the field codecs while encoding/decoding a message. This is the CodecData of the innermost internal::CodecDataScope for this manager on the calling thread, if any (as used by Codec encode/decode/size), otherwise the manager's own.
+    internal::CodecData& codec_data()
+    {
+        internal::CodecData* data = internal::CodecDataScope::active(*this);
+        return data ? *data : codec_data_;
+    }
+    const internal::CodecData& codec_data() const
+    {
+        const internal::CodecData* data = internal::CodecDataScope::active(*this);
+        return data ? *data : codec_data_;
+    }
 
+    // hashes are set by Codec::load(), which may be called on one Codec while another sharing this manager is encoding
     void set_hash(const google::protobuf::Descriptor* desc, std::size_t hash)
     {
+#if DCCL_THREAD_SUPPORT
+        std::lock_guard<internal::SharedMutex> l(cache_mutex_);
+#endif
         hashes_[desc] = hash;
     }
-    bool has_hash(const google::protobuf::Descriptor* desc) const { return hashes_.count(desc); }
-    std::size_t hash(const google::protobuf::Descriptor* desc) const { return hashes_.at(desc); }
+    bool has_hash(const google::protobuf::Descriptor* desc) const
+    {
+#if DCCL_THREAD_SUPPORT
+        std::shared_lock<internal::SharedMutex> l(cache_mutex_);
+#endif
+        return hashes_.count(desc);
+    }
+    std::size_t hash(const google::protobuf::Descriptor* desc) const
+    {
+#if DCCL_THREAD_SUPPORT
+        std::shared_lock<internal::SharedMutex> l(cache_mutex_);
+#endif
+        return hashes_.at(desc);
+    }
 
   private:
+    friend class internal::CodecDataScope;
+
     std::shared_ptr<FieldCodecBase> __find(google::protobuf::FieldDescriptor::Type type,
                                            int codec_version, const std::string& codec_name,
                                            const std::string& type_name) const;
@@ -222,6 +255,9 @@ class FieldCodecManagerLocal
 
     void check_deprecated(const std::string& name) const;
 
+    // find() for a root message, cached per Descriptor
+    std::shared_ptr<FieldCodecBase> find_root(const google::protobuf::Descriptor* desc) const;
+
   private:
     using InsideMap = std::map<std::string, std::shared_ptr<FieldCodecBase>>;
     std::map<google::protobuf::FieldDescriptor::Type, InsideMap> codecs_;
@@ -229,8 +265,44 @@ class FieldCodecManagerLocal
     internal::TypeHelper type_helper_;
     internal::CodecData codec_data_;
 
+    // CodecData objects not currently in use by an internal::CodecDataScope, reused by the next one
+    mutable std::vector<std::unique_ptr<internal::CodecData>> codec_data_pool_;
+#if DCCL_THREAD_SUPPORT
+    mutable std::mutex codec_data_pool_mutex_;
+#endif
+
     std::map<const google::protobuf::Descriptor*, std::size_t> hashes_;
+
     std::map<std::string, std::string> deprecated_names_;
+
+#if DCCL_THREAD_SUPPORT
+    std::atomic<std::size_t> generation_{0};
+#else
+    std::size_t generation_{0};
+#endif
+
+    struct CachedFieldCodec
+    {
+        int codec_version;
+        bool has_codec_group;
+        std::string codec_group;
+        std::shared_ptr<FieldCodecBase> codec;
+    };
+
+    // find() results, cleared by invalidate() so that removed codecs are not kept alive
+    mutable std::unordered_map<const google::protobuf::FieldDescriptor*,
+                               std::vector<CachedFieldCodec>>
+        field_codec_cache_;
+    mutable std::unordered_map<const google::protobuf::Descriptor*, std::shared_ptr<FieldCodecBase>>
+        root_codec_cache_;
+    // native_conditions() results, also cleared by invalidate() as the descriptors may be destroyed after unloading
+    mutable std::unordered_map<const google::protobuf::FieldDescriptor*,
+                               std::shared_ptr<const DynamicConditions::NativeConditions>>
+        native_conditions_cache_;
+    // shared (read) lock for cache hits, exclusive for filling and clearing the caches
+#if DCCL_THREAD_SUPPORT
+    mutable internal::SharedMutex cache_mutex_;
+#endif
 };
 
 class FieldCodecManager
@@ -313,6 +385,7 @@ typename std::enable_if<
 dccl::FieldCodecManagerLocal::add(const std::string& name)
 {
     type_helper_.add<typename Codec::wire_type>();
+    invalidate();
     add_single_type<Codec>(__mangle_name(name, Codec::wire_type::descriptor()->full_name()),
                            google::protobuf::FieldDescriptor::TYPE_MESSAGE,
                            google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE);
@@ -365,6 +438,7 @@ void dccl::FieldCodecManagerLocal::add_single_type(
     if (!codecs_[field_type].count(name))
     {
         codecs_[field_type][name] = new_field_codec;
+        invalidate();
         dccl::dlog.is(dccl::logger::DEBUG1) && dccl::dlog << "Adding codec " << *new_field_codec
                                                           << std::endl;
     }
@@ -385,6 +459,7 @@ typename std::enable_if<
 dccl::FieldCodecManagerLocal::remove(const std::string& name)
 {
     type_helper_.remove<typename Codec::wire_type>();
+    invalidate();
     remove_single_type<Codec>(__mangle_name(name, Codec::wire_type::descriptor()->full_name()),
                               google::protobuf::FieldDescriptor::TYPE_MESSAGE,
                               google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE);
@@ -434,6 +509,7 @@ void dccl::FieldCodecManagerLocal::remove_single_type(
         dccl::dlog.is(dccl::logger::DEBUG1) &&
             dccl::dlog << "Removing codec " << *codecs_[field_type][name] << std::endl;
         codecs_[field_type].erase(name);
+        invalidate();
     }
     else
     {
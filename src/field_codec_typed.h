@@ -104,7 +104,135 @@ class TypedFieldCodec : public FieldCodecSelector<WireType, FieldType>
     /// \return the size (in bits) of the field.
     virtual unsigned size(const WireType& wire_value) = 0;
 
+    /// \name Streaming (opt-in)
+    ///
+    /// Codecs that override these methods (and return true from streaming()) encode directly into, and decode directly from, the message's Bitset. The default implementations call the Bitset based methods above.
+    //@{
+    /// \brief Encode an empty field
+    ///
+    /// \param writer Cursor to write the encoded field to
+    virtual void encode(BitWriter* writer) { writer->write(encode()); }
+
+    /// \brief Encode a non-empty field
+    ///
+    /// \param writer Cursor to write the encoded field to
+    /// \param wire_value Value to encode.
+    virtual void encode(BitWriter* writer, const WireType& wire_value)
+    {
+        writer->write(encode(wire_value));
+    }
+
+    /// \brief Decode a field. If the field is empty (i.e. was encoded using the one-argument encode()), throw NullValueException to indicate this.
+    ///
+    /// \param reader Cursor to read (exactly) the bits of this field from.
+    /// \return the decoded value.
+    virtual WireType decode(BitReader* reader)
+    {
+        Bitset bits(reader->bits());
+        bits.get_more_bits(this->min_size());
+        return decode(&bits);
+    }
+    //@}
+
+    bool direct_access(const google::protobuf::FieldDescriptor* field) override
+    {
+        return field && !field->is_repeated() &&
+               internal::DirectFieldAccess<FieldType>::supported(field);
+    }
+
   private:
+    void direct_encode(Bitset* bits, const google::protobuf::Message& msg,
+                       const google::protobuf::FieldDescriptor* field) override
+    {
+        direct_encode_specific(bits, msg, field);
+    }
+
+    void direct_encode(BitWriter* writer, const google::protobuf::Message& msg,
+                       const google::protobuf::FieldDescriptor* field) override
+    {
+        direct_encode_specific(writer, msg, field);
+    }
+
+    unsigned direct_size(const google::protobuf::Message& msg,
+                         const google::protobuf::FieldDescriptor* field) override
+    {
+        bool pre_encoded = false;
+        try
+        {
+            if (msg.GetReflection()->HasField(msg, field))
+            {
+                const WireType& wire_value =
+                    this->pre_encode(internal::DirectFieldAccess<FieldType>::get(msg, field));
+                pre_encoded = true;
+                return size(wire_value);
+            }
+        }
+        catch (NullValueException&)
+        {
+            // only a NullValueException from pre_encode means an empty value
+            if (pre_encoded)
+                throw;
+        }
+        return size();
+    }
+
+    void direct_decode(Bitset* bits, google::protobuf::Message* msg,
+                       const google::protobuf::FieldDescriptor* field) override
+    {
+        direct_decode_specific(bits, msg, field);
+    }
+
+    void direct_decode(BitReader* reader, google::protobuf::Message* msg,
+                       const google::protobuf::FieldDescriptor* field) override
+    {
+        direct_decode_specific(reader, msg, field);
+    }
+
+    template <typename BitSink>
+    void direct_encode_specific(BitSink* bits, const google::protobuf::Message& msg,
+                                const google::protobuf::FieldDescriptor* field)
+    {
+        bool pre_encoded = false;
+        try
+        {
+            if (msg.GetReflection()->HasField(msg, field))
+            {
+                const WireType& wire_value =
+                    this->pre_encode(internal::DirectFieldAccess<FieldType>::get(msg, field));
+                pre_encoded = true;
+                encode_to(bits, wire_value);
+                return;
+            }
+        }
+        catch (NullValueException&)
+        {
+            // only a NullValueException from pre_encode means an empty value
+            if (pre_encoded)
+                throw;
+        }
+        encode_to(bits);
+    }
+
+    template <typename BitSource>
+    void direct_decode_specific(BitSource* bits, google::protobuf::Message* msg,
+                                const google::protobuf::FieldDescriptor* field)
+    {
+        try
+        {
+            internal::DirectFieldAccess<FieldType>::set(msg, field,
+                                                        this->post_decode(decode(bits)));
+        }
+        catch (NullValueException&)
+        {
+            // empty, leave the field unset
+        }
+    }
+
+    void encode_to(Bitset* bits, const WireType& wire_value) { *bits = encode(wire_value); }
+    void encode_to(Bitset* bits) { *bits = encode(); }
+    void encode_to(BitWriter* writer, const WireType& wire_value) { encode(writer, wire_value); }
+    void encode_to(BitWriter* writer) { encode(writer); }
+
     unsigned any_size(const dccl::any& wire_value) override
     {
         try
@@ -134,6 +262,26 @@ class TypedFieldCodec : public FieldCodecSelector<WireType, FieldType>
         any_decode_specific<WireType>(bits, wire_value);
     }
 
+    void any_encode_stream(BitWriter* writer, const dccl::any& wire_value) override
+    {
+        try
+        {
+            if (is_empty(wire_value))
+                encode(writer);
+            else
+                encode(writer, dccl::any_cast<WireType>(wire_value));
+        }
+        catch (dccl::bad_any_cast&)
+        {
+            throw(type_error("encode", typeid(WireType), wire_value.type()));
+        }
+    }
+
+    void any_decode_stream(BitReader* reader, dccl::any* wire_value) override
+    {
+        any_decode_specific<WireType>(reader, wire_value);
+    }
+
     void any_pre_encode(dccl::any* wire_value, const dccl::any& field_value) override
     {
         try
@@ -183,9 +331,9 @@ class TypedFieldCodec : public FieldCodecSelector<WireType, FieldType>
         }
     }
 
-    template <typename T>
+    template <typename T, typename BitSource>
     typename std::enable_if_t<std::is_base_of<google::protobuf::Message, T>::value, void>
-    any_decode_specific(Bitset* bits, dccl::any* wire_value)
+    any_decode_specific(BitSource* bits, dccl::any* wire_value)
     {
         try
         {
@@ -199,9 +347,9 @@ class TypedFieldCodec : public FieldCodecSelector<WireType, FieldType>
         }
     }
 
-    template <typename T>
+    template <typename T, typename BitSource>
     typename std::enable_if_t<!std::is_base_of<google::protobuf::Message, T>::value, void>
-    any_decode_specific(Bitset* bits, dccl::any* wire_value)
+    any_decode_specific(BitSource* bits, dccl::any* wire_value)
     {
         try
         {
@@ -0,0 +1,834 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "../common.h"
+#include "../exception.h"
+#include "dynamic_conditions_expression.h"
+
+using dccl::internal::ConditionExpression;
+
+/// \brief Lua value produced while evaluating a ConditionExpression
+struct dccl::internal::ConditionExpression::Value
+{
+    enum Type
+    {
+        NIL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        MESSAGE,
+        REPEATED
+    };
+
+    static Value make_boolean(bool b)
+    {
+        Value v;
+        v.type = BOOLEAN;
+        v.boolean = b;
+        return v;
+    }
+
+    static Value make_number(double n)
+    {
+        Value v;
+        v.type = NUMBER;
+        v.number = n;
+        return v;
+    }
+
+    // Lua (5.3+) integer subtype, kept exact rather than only as a double so that 64-bit fields compare correctly
+    static Value make_integer(dccl::int64 i)
+    {
+        Value v = make_number(static_cast<double>(i));
+        v.is_integer = true;
+        v.integer = i;
+        return v;
+    }
+
+    static Value make_string(std::string s)
+    {
+        Value v;
+        v.type = STRING;
+        v.str = std::move(s);
+        return v;
+    }
+
+    bool truthy() const { return !(type == NIL || (type == BOOLEAN && !boolean)); }
+
+    std::string type_name() const
+    {
+        switch (type)
+        {
+            case NIL: return "nil";
+            case BOOLEAN: return "boolean";
+            case NUMBER: return "number";
+            case STRING: return "string";
+            case MESSAGE:
+            case REPEATED: return "table";
+        }
+        return "unknown";
+    }
+
+    Type type{NIL};
+    bool boolean{false};
+    double number{0};
+    // NUMBER that is an integer (`number` is its nearest double)
+    bool is_integer{false};
+    dccl::int64 integer{0};
+    std::string str;
+    // MESSAGE, or the message containing `field` for REPEATED
+    const google::protobuf::Message* msg{nullptr};
+    const google::protobuf::FieldDescriptor* field{nullptr};
+};
+
+/// \brief Node of the expression tree
+struct dccl::internal::ConditionExpression::Node
+{
+    enum Kind
+    {
+        LITERAL,
+        THIS,
+        ROOT,
+        THIS_INDEX,
+        FIELD,  // lhs.name
+        INDEX,  // lhs[rhs]
+        LENGTH, // #lhs
+        NOT,    // not lhs
+        NEGATE, // -lhs
+        AND,
+        OR,
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        MODULO
+    };
+
+    explicit Node(Kind k) : kind(k) {}
+    Node(Kind k, std::unique_ptr<Node> l, std::unique_ptr<Node> r = nullptr)
+        : kind(k), lhs(std::move(l)), rhs(std::move(r))
+    {
+    }
+
+    Kind kind;
+    Value literal;
+    std::string name;
+    std::unique_ptr<Node> lhs, rhs;
+
+    // field found for `name` the last time this node was evaluated (valid for messages of its
+    // containing_type()). Atomic as compiled expressions are shared by the FieldCodecManagerLocal
+    mutable std::atomic<const google::protobuf::FieldDescriptor*> cached_field{nullptr};
+};
+
+namespace
+{
+using Node = ConditionExpression::Node;
+using Value = ConditionExpression::Value;
+
+struct Token
+{
+    enum Type
+    {
+        END,
+        NUMBER,
+        STRING,
+        NAME,
+        SYMBOL
+    };
+    Type type;
+    std::string text;
+    double number{0};
+    bool is_integer{false};
+    dccl::int64 integer{0};
+};
+
+bool is_name_char(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+// splits the script into tokens, returning false on anything outside the supported subset
+bool tokenize(const std::string& script, std::vector<Token>* tokens)
+{
+    std::string::size_type i = 0, n = script.size();
+    while (true)
+    {
+        while (i < n && std::isspace(static_cast<unsigned char>(script[i]))) ++i;
+        if (i == n)
+            break;
+
+        char c = script[i];
+        bool starts_number = std::isdigit(static_cast<unsigned char>(c)) ||
+                             (c == '.' && i + 1 < n &&
+                              std::isdigit(static_cast<unsigned char>(script[i + 1])));
+        if (starts_number)
+        {
+            std::string::size_type begin = i;
+            while (i < n && std::isdigit(static_cast<unsigned char>(script[i]))) ++i;
+            if (i < n && script[i] == '.')
+            {
+                ++i;
+                while (i < n && std::isdigit(static_cast<unsigned char>(script[i]))) ++i;
+            }
+            if (i < n && (script[i] == 'e' || script[i] == 'E'))
+            {
+                ++i;
+                if (i < n && (script[i] == '+' || script[i] == '-'))
+                    ++i;
+                if (i == n || !std::isdigit(static_cast<unsigned char>(script[i])))
+                    return false;
+                while (i < n && std::isdigit(static_cast<unsigned char>(script[i]))) ++i;
+            }
+            // hexadecimal, concatenation, etc.
+            if (i < n && (is_name_char(script[i]) || script[i] == '.'))
+                return false;
+
+            Token t{Token::NUMBER, script.substr(begin, i - begin)};
+            t.number = std::strtod(t.text.c_str(), nullptr);
+            // as in Lua, decimal integers are integers unless they overflow, when they are floats
+            if (t.text.find_first_of(".eE") == std::string::npos)
+            {
+                errno = 0;
+                long long integer = std::strtoll(t.text.c_str(), nullptr, 10);
+                if (errno != ERANGE)
+                {
+                    t.is_integer = true;
+                    t.integer = integer;
+                }
+            }
+            tokens->push_back(t);
+        }
+        else if (is_name_char(c))
+        {
+            std::string::size_type begin = i;
+            while (i < n && is_name_char(script[i])) ++i;
+            tokens->push_back(Token{Token::NAME, script.substr(begin, i - begin)});
+        }
+        else if (c == '\'' || c == '"')
+        {
+            std::string::size_type end = script.find(c, i + 1);
+            if (end == std::string::npos)
+                return false;
+            std::string s = script.substr(i + 1, end - i - 1);
+            // escape sequences are left to Lua
+            if (s.find_first_of("\\\n") != std::string::npos)
+                return false;
+            tokens->push_back(Token{Token::STRING, s});
+            i = end + 1;
+        }
+        else
+        {
+            std::string two = script.substr(i, 2);
+            if (two == "==" || two == "~=" || two == "<=" || two == ">=")
+            {
+                tokens->push_back(Token{Token::SYMBOL, two});
+                i += 2;
+            }
+            // comments, concatenation and floor division are left to Lua
+            else if (two == "--" || two == ".." || two == "//")
+            {
+                return false;
+            }
+            else if (std::string("<>+-*/%#()[].;").find(c) != std::string::npos)
+            {
+                tokens->push_back(Token{Token::SYMBOL, std::string(1, c)});
+                ++i;
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
+    tokens->push_back(Token{Token::END, ""});
+    return true;
+}
+
+// recursive descent parser following Lua's operator precedence. Each parse function returns
+// nullptr if the tokens are outside the supported subset
+class Parser
+{
+  public:
+    Parser(std::vector<Token> tokens) : tokens_(std::move(tokens)) {}
+
+    std::unique_ptr<Node> parse()
+    {
+        accept(Token::NAME, "return");
+        std::unique_ptr<Node> expression = parse_or();
+        accept(Token::SYMBOL, ";");
+        if (!expression || peek().type != Token::END)
+            return nullptr;
+        return expression;
+    }
+
+  private:
+    const Token& peek() const { return tokens_[pos_]; }
+
+    bool accept(Token::Type type, const std::string& text)
+    {
+        if (peek().type == type && peek().text == text)
+        {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    std::unique_ptr<Node> parse_or()
+    {
+        std::unique_ptr<Node> lhs = parse_and();
+        while (lhs && accept(Token::NAME, "or"))
+            lhs = binary(Node::OR, std::move(lhs), parse_and());
+        return lhs;
+    }
+
+    std::unique_ptr<Node> parse_and()
+    {
+        std::unique_ptr<Node> lhs = parse_comparison();
+        while (lhs && accept(Token::NAME, "and"))
+            lhs = binary(Node::AND, std::move(lhs), parse_comparison());
+        return lhs;
+    }
+
+    std::unique_ptr<Node> parse_comparison()
+    {
+        std::unique_ptr<Node> lhs = parse_additive();
+        while (lhs)
+        {
+            Node::Kind kind;
+            if (accept(Token::SYMBOL, "=="))
+                kind = Node::EQUAL;
+            else if (accept(Token::SYMBOL, "~="))
+                kind = Node::NOT_EQUAL;
+            else if (accept(Token::SYMBOL, "<"))
+                kind = Node::LESS;
+            else if (accept(Token::SYMBOL, "<="))
+                kind = Node::LESS_EQUAL;
+            else if (accept(Token::SYMBOL, ">"))
+                kind = Node::GREATER;
+            else if (accept(Token::SYMBOL, ">="))
+                kind = Node::GREATER_EQUAL;
+            else
+                break;
+            lhs = binary(kind, std::move(lhs), parse_additive());
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<Node> parse_additive()
+    {
+        std::unique_ptr<Node> lhs = parse_multiplicative();
+        while (lhs)
+        {
+            Node::Kind kind;
+            if (accept(Token::SYMBOL, "+"))
+                kind = Node::ADD;
+            else if (accept(Token::SYMBOL, "-"))
+                kind = Node::SUBTRACT;
+            else
+                break;
+            lhs = binary(kind, std::move(lhs), parse_multiplicative());
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<Node> parse_multiplicative()
+    {
+        std::unique_ptr<Node> lhs = parse_unary();
+        while (lhs)
+        {
+            Node::Kind kind;
+            if (accept(Token::SYMBOL, "*"))
+                kind = Node::MULTIPLY;
+            else if (accept(Token::SYMBOL, "/"))
+                kind = Node::DIVIDE;
+            else if (accept(Token::SYMBOL, "%"))
+                kind = Node::MODULO;
+            else
+                break;
+            lhs = binary(kind, std::move(lhs), parse_unary());
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<Node> parse_unary()
+    {
+        Node::Kind kind;
+        if (accept(Token::NAME, "not"))
+            kind = Node::NOT;
+        else if (accept(Token::SYMBOL, "-"))
+            kind = Node::NEGATE;
+        else if (accept(Token::SYMBOL, "#"))
+            kind = Node::LENGTH;
+        else
+            return parse_suffixed();
+
+        std::unique_ptr<Node> operand = parse_unary();
+        if (!operand)
+            return nullptr;
+        return std::unique_ptr<Node>(new Node(kind, std::move(operand)));
+    }
+
+    // primary expression followed by any number of .name and [expression]
+    std::unique_ptr<Node> parse_suffixed()
+    {
+        std::unique_ptr<Node> lhs = parse_primary();
+        while (lhs)
+        {
+            if (accept(Token::SYMBOL, "."))
+            {
+                if (peek().type != Token::NAME)
+                    return nullptr;
+                lhs.reset(new Node(Node::FIELD, std::move(lhs)));
+                lhs->name = tokens_[pos_++].text;
+            }
+            else if (accept(Token::SYMBOL, "["))
+            {
+                std::unique_ptr<Node> index = parse_or();
+                if (!index || !accept(Token::SYMBOL, "]"))
+                    return nullptr;
+                lhs.reset(new Node(Node::INDEX, std::move(lhs), std::move(index)));
+            }
+            else
+            {
+                break;
+            }
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<Node> parse_primary()
+    {
+        const Token& t = tokens_[pos_++];
+        switch (t.type)
+        {
+            case Token::NUMBER:
+                return literal(t.is_integer ? Value::make_integer(t.integer)
+                                            : Value::make_number(t.number));
+            case Token::STRING: return literal(Value::make_string(t.text));
+            case Token::NAME:
+                if (t.text == "this")
+                    return std::unique_ptr<Node>(new Node(Node::THIS));
+                else if (t.text == "root")
+                    return std::unique_ptr<Node>(new Node(Node::ROOT));
+                else if (t.text == "this_index")
+                    return std::unique_ptr<Node>(new Node(Node::THIS_INDEX));
+                else if (t.text == "true" || t.text == "false")
+                    return literal(Value::make_boolean(t.text == "true"));
+                else if (t.text == "nil")
+                    return literal(Value());
+                // other globals and functions are left to Lua
+                return nullptr;
+            case Token::SYMBOL:
+                if (t.text == "(")
+                {
+                    std::unique_ptr<Node> expression = parse_or();
+                    if (!expression || !accept(Token::SYMBOL, ")"))
+                        return nullptr;
+                    return expression;
+                }
+                return nullptr;
+            case Token::END: --pos_; return nullptr;
+        }
+        return nullptr;
+    }
+
+    static std::unique_ptr<Node> literal(Value v)
+    {
+        std::unique_ptr<Node> node(new Node(Node::LITERAL));
+        node->literal = std::move(v);
+        return node;
+    }
+
+    static std::unique_ptr<Node> binary(Node::Kind kind, std::unique_ptr<Node> lhs,
+                                        std::unique_ptr<Node> rhs)
+    {
+        if (!rhs)
+            return nullptr;
+        return std::unique_ptr<Node>(new Node(kind, std::move(lhs), std::move(rhs)));
+    }
+
+  private:
+    std::vector<Token> tokens_;
+    std::vector<Token>::size_type pos_{0};
+};
+
+struct Context
+{
+    const google::protobuf::Message* this_msg;
+    const google::protobuf::Message* root_msg;
+    int index;
+};
+
+Value message_value(const google::protobuf::Message* msg)
+{
+    Value v;
+    v.type = Value::MESSAGE;
+    v.msg = msg;
+    return v;
+}
+
+// value of a non-repeated field, or element `index` of a repeated field
+Value read_field(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field,
+                 int index = -1)
+{
+    const google::protobuf::Reflection* refl = msg.GetReflection();
+    bool repeated = field->is_repeated();
+    if (repeated && index < 0)
+    {
+        Value v;
+        v.type = Value::REPEATED;
+        v.msg = &msg;
+        v.field = field;
+        return v;
+    }
+
+    switch (field->cpp_type())
+    {
+        case google::protobuf::FieldDescriptor::CPPTYPE_INT32:
+            return Value::make_integer(repeated ? refl->GetRepeatedInt32(msg, field, index)
+                                                : refl->GetInt32(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_INT64:
+            return Value::make_integer(repeated ? refl->GetRepeatedInt64(msg, field, index)
+                                                : refl->GetInt64(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_UINT32:
+            return Value::make_integer(repeated ? refl->GetRepeatedUInt32(msg, field, index)
+                                                : refl->GetUInt32(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_UINT64:
+        {
+            dccl::uint64 v =
+                repeated ? refl->GetRepeatedUInt64(msg, field, index) : refl->GetUInt64(msg, field);
+            // Lua integers are signed, so larger values are floats (as given to Lua)
+            if (v > static_cast<dccl::uint64>(std::numeric_limits<dccl::int64>::max()))
+                return Value::make_number(static_cast<double>(v));
+            return Value::make_integer(static_cast<dccl::int64>(v));
+        }
+        case google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE:
+            return Value::make_number(repeated ? refl->GetRepeatedDouble(msg, field, index)
+                                               : refl->GetDouble(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_FLOAT:
+            return Value::make_number(repeated ? refl->GetRepeatedFloat(msg, field, index)
+                                               : refl->GetFloat(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_BOOL:
+            return Value::make_boolean(repeated ? refl->GetRepeatedBool(msg, field, index)
+                                                : refl->GetBool(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_STRING:
+            return Value::make_string(repeated ? refl->GetRepeatedString(msg, field, index)
+                                               : refl->GetString(msg, field));
+        case google::protobuf::FieldDescriptor::CPPTYPE_ENUM:
+            return Value::make_string(repeated ? refl->GetRepeatedEnum(msg, field, index)->name()
+                                               : refl->GetEnum(msg, field)->name());
+        case google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE:
+            if (repeated)
+                return message_value(&refl->GetRepeatedMessage(msg, field, index));
+            // Lua sees unset messages as nil
+            else if (refl->HasField(msg, field))
+                return message_value(&refl->GetMessage(msg, field));
+            else
+                return Value();
+    }
+    return Value();
+}
+
+void require_type(const Value& v, Value::Type type, const std::string& action)
+{
+    if (v.type != type)
+        throw(dccl::Exception("attempt to " + action + " a " + v.type_name() + " value"));
+}
+
+// exact comparison of two numbers, as Lua does for integers and mixed integer/float operands:
+// <0, 0, >0, or UNORDERED if either is NaN
+const int UNORDERED = 2;
+int compare_numbers(const Value& a, const Value& b)
+{
+    if (a.is_integer && b.is_integer)
+        return (a.integer < b.integer) ? -1 : (a.integer > b.integer ? 1 : 0);
+    if (std::isnan(a.number) || std::isnan(b.number))
+        return UNORDERED;
+    if (!a.is_integer && !b.is_integer)
+        return (a.number < b.number) ? -1 : (a.number > b.number ? 1 : 0);
+    if (a.is_integer)
+        return -compare_numbers(b, a);
+
+    // float a with integer b, without rounding b to a double
+    const double two_63 = 9223372036854775808.0;
+    if (a.number >= two_63)
+        return 1;
+    if (a.number < -two_63)
+        return -1;
+    double floor_a = std::floor(a.number);
+    dccl::int64 integer_a = static_cast<dccl::int64>(floor_a);
+    if (integer_a != b.integer)
+        return (integer_a < b.integer) ? -1 : 1;
+    return (a.number > floor_a) ? 1 : 0;
+}
+
+bool equal(const Value& a, const Value& b)
+{
+    if (a.type != b.type)
+        return false;
+    switch (a.type)
+    {
+        case Value::NIL: return true;
+        case Value::BOOLEAN: return a.boolean == b.boolean;
+        case Value::NUMBER: return compare_numbers(a, b) == 0;
+        case Value::STRING: return a.str == b.str;
+        case Value::MESSAGE: return a.msg == b.msg;
+        case Value::REPEATED: return a.msg == b.msg && a.field == b.field;
+    }
+    return false;
+}
+
+// returns <0, 0, >0 as for strcmp, or UNORDERED
+int compare(const Value& a, const Value& b)
+{
+    if (a.type == Value::NUMBER && b.type == Value::NUMBER)
+        return compare_numbers(a, b);
+    else if (a.type == Value::STRING && b.type == Value::STRING)
+    {
+        int c = a.str.compare(b.str);
+        return (c < 0) ? -1 : (c > 0 ? 1 : 0);
+    }
+    else
+        throw(dccl::Exception("attempt to compare " + a.type_name() + " with " + b.type_name()));
+}
+
+// two's complement wrap around of unsigned integer arithmetic
+dccl::int64 wrap(dccl::uint64 v)
+{
+    return (v > static_cast<dccl::uint64>(std::numeric_limits<dccl::int64>::max()))
+               ? -static_cast<dccl::int64>(~v) - 1
+               : static_cast<dccl::int64>(v);
+}
+
+Value evaluate(const Node& node, const Context& ctx)
+{
+    switch (node.kind)
+    {
+        case Node::LITERAL: return node.literal;
+        case Node::THIS: return message_value(ctx.this_msg);
+        case Node::ROOT: return message_value(ctx.root_msg);
+        case Node::THIS_INDEX: return Value::make_integer(ctx.index + 1);
+
+        case Node::FIELD:
+        {
+            Value parent = evaluate(*node.lhs, ctx);
+            require_type(parent, Value::MESSAGE, "index field '" + node.name + "' of");
+            const google::protobuf::Descriptor* desc = parent.msg->GetDescriptor();
+            const google::protobuf::FieldDescriptor* field =
+                node.cached_field.load(std::memory_order_relaxed);
+            if (!field || field->containing_type() != desc)
+            {
+                field = desc->FindFieldByName(node.name);
+                if (field)
+                    node.cached_field.store(field, std::memory_order_relaxed);
+            }
+            return field ? read_field(*parent.msg, field) : Value();
+        }
+
+        case Node::INDEX:
+        {
+            Value parent = evaluate(*node.lhs, ctx);
+            Value key = evaluate(*node.rhs, ctx);
+            if (parent.type == Value::REPEATED)
+            {
+                // Lua indexes from 1
+                int size = parent.msg->GetReflection()->FieldSize(*parent.msg, parent.field);
+                if (key.type != Value::NUMBER || key.number != std::floor(key.number) ||
+                    key.number < 1 || key.number > size)
+                    return Value();
+                return read_field(*parent.msg, parent.field, static_cast<int>(key.number) - 1);
+            }
+
+            require_type(parent, Value::MESSAGE, "index");
+            const google::protobuf::FieldDescriptor* field =
+                (key.type == Value::STRING) ? parent.msg->GetDescriptor()->FindFieldByName(key.str)
+                                            : nullptr;
+            return field ? read_field(*parent.msg, field) : Value();
+        }
+
+        case Node::LENGTH:
+        {
+            Value operand = evaluate(*node.lhs, ctx);
+            if (operand.type == Value::REPEATED)
+                return Value::make_integer(
+                    operand.msg->GetReflection()->FieldSize(*operand.msg, operand.field));
+            require_type(operand, Value::STRING, "get length of");
+            return Value::make_integer(operand.str.size());
+        }
+
+        case Node::NOT: return Value::make_boolean(!evaluate(*node.lhs, ctx).truthy());
+
+        case Node::NEGATE:
+        {
+            Value operand = evaluate(*node.lhs, ctx);
+            require_type(operand, Value::NUMBER, "perform arithmetic on");
+            if (operand.is_integer)
+                return Value::make_integer(wrap(0 - static_cast<dccl::uint64>(operand.integer)));
+            return Value::make_number(-operand.number);
+        }
+
+        // Lua's and/or result in one of their operands, not necessarily a boolean
+        case Node::AND:
+        {
+            Value lhs = evaluate(*node.lhs, ctx);
+            return lhs.truthy() ? evaluate(*node.rhs, ctx) : lhs;
+        }
+        case Node::OR:
+        {
+            Value lhs = evaluate(*node.lhs, ctx);
+            return lhs.truthy() ? lhs : evaluate(*node.rhs, ctx);
+        }
+
+        default: break;
+    }
+
+    Value lhs = evaluate(*node.lhs, ctx);
+    Value rhs = evaluate(*node.rhs, ctx);
+    switch (node.kind)
+    {
+        case Node::EQUAL: return Value::make_boolean(equal(lhs, rhs));
+        case Node::NOT_EQUAL: return Value::make_boolean(!equal(lhs, rhs));
+        case Node::LESS: return Value::make_boolean(compare(lhs, rhs) < 0);
+        case Node::LESS_EQUAL: return Value::make_boolean(compare(lhs, rhs) <= 0);
+        case Node::GREATER: return Value::make_boolean(compare(lhs, rhs) == 1);
+        case Node::GREATER_EQUAL:
+        {
+            int c = compare(lhs, rhs);
+            return Value::make_boolean(c == 0 || c == 1);
+        }
+        default: break;
+    }
+
+    require_type(lhs, Value::NUMBER, "perform arithmetic on");
+    require_type(rhs, Value::NUMBER, "perform arithmetic on");
+
+    // integer arithmetic wraps around as in Lua; "/" is always a float division
+    if (lhs.is_integer && rhs.is_integer)
+    {
+        dccl::uint64 a = lhs.integer, b = rhs.integer;
+        switch (node.kind)
+        {
+            case Node::ADD: return Value::make_integer(wrap(a + b));
+            case Node::SUBTRACT: return Value::make_integer(wrap(a - b));
+            case Node::MULTIPLY: return Value::make_integer(wrap(a * b));
+            case Node::MODULO:
+            {
+                if (rhs.integer == 0)
+                    throw(dccl::Exception("attempt to perform 'n%0'"));
+                // avoids overflow of min() % -1
+                if (rhs.integer == -1)
+                    return Value::make_integer(0);
+                dccl::int64 m = lhs.integer % rhs.integer;
+                // result takes the sign of the divisor
+                if (m != 0 && ((m < 0) != (rhs.integer < 0)))
+                    m += rhs.integer;
+                return Value::make_integer(m);
+            }
+            default: break;
+        }
+    }
+
+    switch (node.kind)
+    {
+        case Node::ADD: return Value::make_number(lhs.number + rhs.number);
+        case Node::SUBTRACT: return Value::make_number(lhs.number - rhs.number);
+        case Node::MULTIPLY: return Value::make_number(lhs.number * rhs.number);
+        case Node::DIVIDE: return Value::make_number(lhs.number / rhs.number);
+        case Node::MODULO:
+            return Value::make_number(lhs.number -
+                                      std::floor(lhs.number / rhs.number) * rhs.number);
+        default: break;
+    }
+    throw(dccl::Exception("Unknown dynamic condition expression node"));
+}
+} // namespace
+
+dccl::internal::ConditionExpression::ConditionExpression(std::string script,
+                                                         std::unique_ptr<Node> root)
+    : script_(std::move(script)), root_(std::move(root))
+{
+}
+
+dccl::internal::ConditionExpression::~ConditionExpression() = default;
+
+std::unique_ptr<ConditionExpression>
+dccl::internal::ConditionExpression::compile(const std::string& script)
+{
+    std::vector<Token> tokens;
+    if (!tokenize(script, &tokens))
+        return nullptr;
+
+    std::unique_ptr<Node> root = Parser(std::move(tokens)).parse();
+    if (!root)
+        return nullptr;
+
+    return std::unique_ptr<ConditionExpression>(
+        new ConditionExpression(script, std::move(root)));
+}
+
+ConditionExpression::Value
+dccl::internal::ConditionExpression::evaluate(const google::protobuf::Message* this_msg,
+                                              const google::protobuf::Message* root_msg,
+                                              int index) const
+{
+    try
+    {
+        return ::evaluate(*root_, Context{this_msg, root_msg, index});
+    }
+    catch (const dccl::Exception& e)
+    {
+        throw(Exception("Failed to evaluate dynamic condition \"" + script_ + "\": " + e.what(),
+                        this_msg->GetDescriptor()));
+    }
+}
+
+bool dccl::internal::ConditionExpression::evaluate_bool(const google::protobuf::Message* this_msg,
+                                                        const google::protobuf::Message* root_msg,
+                                                        int index) const
+{
+    return evaluate(this_msg, root_msg, index).truthy();
+}
+
+double
+dccl::internal::ConditionExpression::evaluate_number(const google::protobuf::Message* this_msg,
+                                                     const google::protobuf::Message* root_msg,
+                                                     int index) const
+{
+    Value v = evaluate(this_msg, root_msg, index);
+    if (v.type != Value::NUMBER)
+        throw(Exception("Dynamic condition \"" + script_ + "\" must result in a number, not a " +
+                            v.type_name(),
+                        this_msg->GetDescriptor()));
+    return v.number;
+}
@@ -0,0 +1,77 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef DCCLDYNAMICCONDITIONSEXPRESSION20231017H
+#define DCCLDYNAMICCONDITIONSEXPRESSION20231017H
+
+#include <memory>
+#include <string>
+
+#include <google/protobuf/message.h>
+
+namespace dccl
+{
+namespace internal
+{
+/// \brief Native (Lua-free) evaluator for the common subset of the Lua used in (dccl.field).dynamic_conditions
+///
+/// Supports an optional leading "return" followed by a single expression made of:
+///   - `this`, `root` and `this_index` (1-based), field access (`this.a.b`, `this["a"]`) and repeated field indexing (`root.child[this_index]`)
+///   - number, string ('...' or "..." without escapes), `true`, `false` and `nil` literals
+///   - `==`, `~=`, `<`, `<=`, `>`, `>=`, `and`, `or`, `not`, `+`, `-`, `*`, `/`, `%`, `#` and parentheses
+///
+/// Messages are read directly using Reflection, with the same values the Lua scripts see: enumerations are their value name, unset scalar fields are their default value, and unset message fields and out-of-range repeated indices are nil.
+class ConditionExpression
+{
+  public:
+    ~ConditionExpression();
+
+    /// \brief Compile a condition script
+    ///
+    /// \return The compiled expression, or nullptr if the script uses anything outside the supported subset (and must be run by Lua instead)
+    static std::unique_ptr<ConditionExpression> compile(const std::string& script);
+
+    /// \brief Evaluate the expression for the given messages and repeated index (0-based), returning its Lua truth value
+    bool evaluate_bool(const google::protobuf::Message* this_msg,
+                       const google::protobuf::Message* root_msg, int index) const;
+
+    /// \brief Evaluate the expression for the given messages and repeated index (0-based), which must result in a number
+    double evaluate_number(const google::protobuf::Message* this_msg,
+                           const google::protobuf::Message* root_msg, int index) const;
+
+    struct Node;
+    struct Value;
+
+  private:
+    ConditionExpression(std::string script, std::unique_ptr<Node> root);
+    Value evaluate(const google::protobuf::Message* this_msg,
+                   const google::protobuf::Message* root_msg, int index) const;
+
+  private:
+    std::string script_;
+    std::unique_ptr<Node> root_;
+};
+
+} // namespace internal
+} // namespace dccl
+
+#endif
@@ -23,10 +23,14 @@
 #ifndef DCCLFIELDCODECDATAH
 #define DCCLFIELDCODECDATAH
 
+#include "../bitset.h"
 #include "../dynamic_conditions.h"
 
 #include "field_codec_message_stack.h"
 
+#include <limits>
+#include <map>
+#include <memory>
 #include <typeindex>
 
 namespace google
@@ -40,6 +44,9 @@ class Descriptor;
 
 namespace dccl
 {
+class FieldCodecManagerLocal;
+class TraceBuffer;
+
 namespace internal
 {
 // Data shared amongst all the FieldCodecs for a single message
@@ -51,25 +58,78 @@ struct CodecData
     const google::protobuf::Descriptor* root_descriptor_{nullptr};
     MessageStackData message_data_;
     DynamicConditions dynamic_conditions_;
-    
+
+    // scratch space for Codec::encode(), reused across calls
+    Bitset encode_bits_;
+    // field_encode() throws EncodeSizeExceededException once the encoded bits exceed this
+    std::size_t encode_bit_limit_{std::numeric_limits<std::size_t>::max()};
+
+    // set by Codec::set_trace(): records each field encoded/decoded
+    TraceBuffer* trace_{nullptr};
+    // trace_ while encoding/decoding a HEAD or BODY part, otherwise nullptr (set once per part by BaseRAII so each field only checks this)
+    TraceBuffer* part_trace_{nullptr};
+    // Bitset given to base_encode()/base_decode() for the current part, and its size at that time (trace offsets are relative to this)
+    const Bitset* trace_bits_{nullptr};
+    std::size_t trace_base_{0};
+    unsigned trace_depth_{0};
+
     template <typename FieldCodecType>
     void set_codec_specific_data(std::shared_ptr<dccl::any> data)
     {
-        codec_specific_[std::type_index(typeid(FieldCodecType))] = data;
+        (*codec_specific_)[std::type_index(typeid(FieldCodecType))] = data;
     }
 
     template <typename FieldCodecType> std::shared_ptr<dccl::any> codec_specific_data()
     {
-        return codec_specific_.at(std::type_index(typeid(FieldCodecType)));
+        return codec_specific_->at(std::type_index(typeid(FieldCodecType)));
     }
 
     template <typename FieldCodecType> bool has_codec_specific_data()
     {
-        return codec_specific_.count(std::type_index(typeid(FieldCodecType)));
+        return codec_specific_->count(std::type_index(typeid(FieldCodecType)));
     }
 
   private:
-    std::map<std::type_index, std::shared_ptr<dccl::any>> codec_specific_;
+    friend class CodecDataScope;
+    // codec specific data is set up at load time and belongs to the FieldCodecManagerLocal, so it is shared (not copied) by the per-call CodecData
+    std::shared_ptr<std::map<std::type_index, std::shared_ptr<dccl::any>>> codec_specific_{
+        std::make_shared<std::map<std::type_index, std::shared_ptr<dccl::any>>>()};
+};
+
+/// \brief RAII object that provides a CodecData for a single call (encode, decode, size, ...) on a FieldCodecManagerLocal.
+///
+/// While in scope, FieldCodecManagerLocal::codec_data() returns this object's CodecData (on the calling thread only) rather than the manager's own, so that concurrent calls from different threads using the same manager do not share state. CodecData objects are pooled by their FieldCodecManagerLocal to avoid reallocation, so their caches (e.g. compiled dynamic conditions) are never shared between unrelated managers, and are freed with the manager.
+class CodecDataScope
+{
+  public:
+    explicit CodecDataScope(const FieldCodecManagerLocal& manager);
+    ~CodecDataScope();
+
+    CodecDataScope(const CodecDataScope&) = delete;
+    CodecDataScope& operator=(const CodecDataScope&) = delete;
+
+    CodecData& data() { return *data_; }
+
+    /// \brief Returns the innermost CodecData in scope for this manager on the calling thread, or nullptr if there is none.
+    static CodecData* active(const FieldCodecManagerLocal& manager)
+    {
+        // almost always the innermost scope, so avoid walking the list
+        CodecDataScope* scope = innermost_;
+        if (scope && &scope->manager_ == &manager)
+            return scope->data_.get();
+        return scope ? active_outer(manager) : nullptr;
+    }
+
+  private:
+    static CodecData* active_outer(const FieldCodecManagerLocal& manager);
+
+    // innermost CodecDataScope on this thread
+    static thread_local CodecDataScope* innermost_;
+
+  private:
+    const FieldCodecManagerLocal& manager_;
+    std::unique_ptr<CodecData> data_;
+    CodecDataScope* previous_;
 };
 } // namespace internal
 } // namespace dccl
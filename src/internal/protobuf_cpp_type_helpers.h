@@ -25,6 +25,7 @@
 #define DCCLPROTOBUFCPPTYPEHELPERS20110323H
 
 #include "../any.h"
+#include "../exception.h"
 
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/descriptor.pb.h>
@@ -625,6 +626,215 @@ template <> class ToProtoCppType<google::protobuf::Message>
         return google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE;
     }
 };
+
+/// \brief Typed (no dccl::any) access to a singular field whose C++ type is T. Specialized for the scalar Protobuf C++ types; for all other types supported() is false and get() / set() throw.
+template <typename T> class DirectFieldAccess
+{
+  public:
+    /// \brief True if get() and set() can be used on this field
+    static bool supported(const google::protobuf::FieldDescriptor* /*field*/) { return false; }
+
+    static T get(const google::protobuf::Message& /*msg*/,
+                 const google::protobuf::FieldDescriptor* /*field*/)
+    {
+        throw(Exception("Direct field access is not supported for this type"));
+    }
+
+    static void set(google::protobuf::Message* /*msg*/,
+                    const google::protobuf::FieldDescriptor* /*field*/, const T& /*value*/)
+    {
+        throw(Exception("Direct field access is not supported for this type"));
+    }
+};
+
+template <> class DirectFieldAccess<double>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<double>::as_enum();
+    }
+
+    static double get(const google::protobuf::Message& msg,
+                      const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetDouble(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const double& value)
+    {
+        msg->GetReflection()->SetDouble(msg, field, value);
+    }
+};
+
+template <> class DirectFieldAccess<float>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<float>::as_enum();
+    }
+
+    static float get(const google::protobuf::Message& msg,
+                     const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetFloat(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const float& value)
+    {
+        msg->GetReflection()->SetFloat(msg, field, value);
+    }
+};
+
+template <> class DirectFieldAccess<google::protobuf::int32>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<google::protobuf::int32>::as_enum();
+    }
+
+    static google::protobuf::int32 get(const google::protobuf::Message& msg,
+                                       const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetInt32(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const google::protobuf::int32& value)
+    {
+        msg->GetReflection()->SetInt32(msg, field, value);
+    }
+};
+
+template <> class DirectFieldAccess<google::protobuf::int64>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<google::protobuf::int64>::as_enum();
+    }
+
+    static google::protobuf::int64 get(const google::protobuf::Message& msg,
+                                       const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetInt64(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const google::protobuf::int64& value)
+    {
+        msg->GetReflection()->SetInt64(msg, field, value);
+    }
+};
+
+template <> class DirectFieldAccess<google::protobuf::uint32>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<google::protobuf::uint32>::as_enum();
+    }
+
+    static google::protobuf::uint32 get(const google::protobuf::Message& msg,
+                                        const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetUInt32(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const google::protobuf::uint32& value)
+    {
+        msg->GetReflection()->SetUInt32(msg, field, value);
+    }
+};
+
+template <> class DirectFieldAccess<google::protobuf::uint64>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<google::protobuf::uint64>::as_enum();
+    }
+
+    static google::protobuf::uint64 get(const google::protobuf::Message& msg,
+                                        const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetUInt64(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const google::protobuf::uint64& value)
+    {
+        msg->GetReflection()->SetUInt64(msg, field, value);
+    }
+};
+
+template <> class DirectFieldAccess<bool>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<bool>::as_enum();
+    }
+
+    static bool get(const google::protobuf::Message& msg,
+                    const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetBool(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const bool& value)
+    {
+        msg->GetReflection()->SetBool(msg, field, value);
+    }
+};
+
+template <> class DirectFieldAccess<std::string>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<std::string>::as_enum();
+    }
+
+    static std::string get(const google::protobuf::Message& msg,
+                           const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetString(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const std::string& value)
+    {
+        msg->GetReflection()->SetString(msg, field, value);
+    }
+};
+
+template <> class DirectFieldAccess<const google::protobuf::EnumValueDescriptor*>
+{
+  public:
+    static bool supported(const google::protobuf::FieldDescriptor* field)
+    {
+        return field->cpp_type() == ToProtoCppType<const google::protobuf::EnumValueDescriptor*>::as_enum();
+    }
+
+    static const google::protobuf::EnumValueDescriptor*
+    get(const google::protobuf::Message& msg, const google::protobuf::FieldDescriptor* field)
+    {
+        return msg.GetReflection()->GetEnum(msg, field);
+    }
+
+    static void set(google::protobuf::Message* msg, const google::protobuf::FieldDescriptor* field,
+                    const google::protobuf::EnumValueDescriptor* value)
+    {
+        msg->GetReflection()->SetEnum(msg, field, value);
+    }
+};
 } // namespace internal
 } // namespace dccl
 
@@ -0,0 +1,135 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include "thread_pool.h"
+
+#if DCCL_THREAD_SUPPORT
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+// one call to run(): the tasks are claimed by index by the calling thread and by each worker the batch is handed to
+struct dccl::internal::ThreadPool::Batch
+{
+    Batch(std::size_t n, const std::function<void(std::size_t)>& task) : n(n), task(task) {}
+
+    // runs unclaimed tasks until there are none left
+    void help()
+    {
+        // `task` belongs to the caller of run(), so it must not be used once all n are claimed
+        for (std::size_t i = next++; i < n; i = next++)
+        {
+            std::exception_ptr task_error;
+            try
+            {
+                task(i);
+            }
+            catch (...)
+            {
+                task_error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> l(mutex);
+            if (task_error && !error)
+                error = task_error;
+            if (++finished == n)
+                done.notify_all();
+        }
+    }
+
+    const std::size_t n;
+    const std::function<void(std::size_t)>& task;
+    std::atomic<std::size_t> next{0};
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t finished{0};
+    std::exception_ptr error;
+};
+
+dccl::internal::ThreadPool::ThreadPool(unsigned workers)
+{
+    try
+    {
+        for (unsigned i = 0; i < workers; ++i) threads_.emplace_back([this]() { work(); });
+    }
+    catch (...)
+    {
+        // don't leave the threads already started joinable (std::terminate)
+        stop();
+        throw;
+    }
+}
+
+dccl::internal::ThreadPool::~ThreadPool() { stop(); }
+
+void dccl::internal::ThreadPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> l(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& t : threads_) t.join();
+    threads_.clear();
+}
+
+void dccl::internal::ThreadPool::work()
+{
+    for (;;)
+    {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> l(mutex_);
+            cv_.wait(l, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty())
+                return;
+            batch = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        batch->help();
+    }
+}
+
+void dccl::internal::ThreadPool::run(std::size_t n, const std::function<void(std::size_t)>& task)
+{
+    // shared with the workers, which may only get to it after this call has returned
+    auto batch = std::make_shared<Batch>(n, task);
+
+    std::size_t helpers = std::min(threads_.size(), n > 0 ? n - 1 : 0);
+    if (helpers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> l(mutex_);
+            queue_.insert(queue_.end(), helpers, batch);
+        }
+        for (std::size_t i = 0; i < helpers; ++i) cv_.notify_one();
+    }
+
+    batch->help();
+
+    std::unique_lock<std::mutex> l(batch->mutex);
+    batch->done.wait(l, [&]() { return batch->finished == n; });
+    if (batch->error)
+        std::rethrow_exception(batch->error);
+}
+#endif
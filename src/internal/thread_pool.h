@@ -0,0 +1,77 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef DCCLTHREADPOOL20231018H
+#define DCCLTHREADPOOL20231018H
+
+#include "dccl/def.h"
+
+#if DCCL_THREAD_SUPPORT
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dccl
+{
+namespace internal
+{
+/// \brief Small fixed set of worker threads that are started once and then reused (e.g. by Codec::encode_batch() to encrypt the message bodies). run() may be called from several threads at once.
+class ThreadPool
+{
+  public:
+    /// \param workers Number of worker threads to start
+    explicit ThreadPool(unsigned workers);
+    /// \brief Stops and joins the worker threads
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// \brief Number of worker threads (not counting the threads calling run())
+    std::size_t workers() const { return threads_.size(); }
+
+    /// \brief Calls task(i) for each i in [0, n) on the calling thread and up to workers() worker threads, returning once all the calls have finished
+    ///
+    /// If any call throws, the other calls are still made and the first exception is then rethrown.
+    void run(std::size_t n, const std::function<void(std::size_t)>& task);
+
+  private:
+    struct Batch;
+    void work();
+    void stop();
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Batch>> queue_;
+    bool stopping_{false};
+    std::vector<std::thread> threads_;
+};
+} // namespace internal
+} // namespace dccl
+
+#endif
+#endif
@@ -23,59 +23,228 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
 #include <ctime>
+#include <memory>
 
 #include "logger.h"
 
+#if DCCL_THREAD_SUPPORT
+thread_local dccl::Logger dccl::dlog;
+thread_local bool dccl::internal::dlog_destroyed = false;
+#else
 dccl::Logger dccl::dlog;
+#endif
 
-int dccl::internal::LogBuffer::sync()
+dccl::internal::LogSinks& dccl::internal::LogSinks::instance()
+{
+    static LogSinks sinks;
+    return sinks;
+}
+
+namespace
 {
+// construct the slots along with the library's globals (rather than on first use), so that they outlive the globals of programs using the library
+dccl::internal::LogSinks& sinks_at_load = dccl::internal::LogSinks::instance();
+} // namespace
+
 #if DCCL_THREAD_SUPPORT
-    if (verbosity() == logger::UNKNOWN)
+// each thread keeps the Records it takes from free_, returning any left over when it exits
+struct dccl::internal::LogSinks::RecordCache
+{
+    Record* head{nullptr};
+    ~RecordCache()
     {
-        std::cerr
-            << "Must use 'dlog.is(...) && dlog << ... << std::endl;' expression when running in "
-               "thread safe mode to allow the dlog mutex to be correctly locked and unlocked. "
-               "Offending line: "
-            << buffer_.front() << std::endl;
-        exit(EXIT_FAILURE);
+        LogSinks::instance().release(head);
+        head = nullptr;
     }
+};
+#endif
+
+dccl::internal::LogSinks::~LogSinks()
+{
+    auto delete_records = [](Record* chain) {
+        while (chain)
+        {
+            Record* next = chain->next;
+            delete chain;
+            chain = next;
+        }
+    };
 
+#if DCCL_THREAD_SUPPORT
+    delete_records(pending_.exchange(nullptr));
+    delete_records(free_.exchange(nullptr));
+#else
+    delete_records(free_);
 #endif
+}
 
-    // all but last one
-    while (buffer_.size() > 1)
-    {
-        display(buffer_.front());
-        buffer_.pop_front();
-    }
+dccl::internal::LogSinks::Record* dccl::internal::LogSinks::acquire()
+{
+#if DCCL_THREAD_SUPPORT
+    static thread_local RecordCache cache;
+    if (!cache.head)
+        cache.head = free_.exchange(nullptr);
+    Record*& head = cache.head;
+#else
+    Record*& head = free_;
+#endif
+    if (!head)
+        return new Record;
 
-    if (!verbosity_.empty())
-        verbosity_.pop();
-    if (!group_.empty())
-        group_.pop();
+    Record* record = head;
+    head = record->next;
+    record->next = nullptr;
+    return record;
+}
+
+void dccl::internal::LogSinks::release(Record* chain)
+{
+    if (!chain)
+        return;
+
+    Record* last = chain;
+    while (last->next) last = last->next;
 
 #if DCCL_THREAD_SUPPORT
-    g_dlog_mutex.unlock();
+    last->next = free_.load();
+    while (!free_.compare_exchange_weak(last->next, chain)) {}
+#else
+    last->next = free_;
+    free_ = chain;
 #endif
-    return 0;
 }
 
-int dccl::internal::LogBuffer::overflow(int c)
+void dccl::internal::LogSinks::post(const char* line, std::size_t length,
+                                    logger::Verbosity verbosity, logger::Group group)
 {
-    if (c == EOF)
+    if (!contains(verbosity))
+        return;
+
+    Record* record = acquire();
+    try
+    {
+        record->msg.assign(line, length);
+    }
+    catch (...)
+    {
+        release(record);
+        throw;
+    }
+    record->verbosity = verbosity;
+    record->group = group;
+
+#if DCCL_THREAD_SUPPORT
+    record->next = pending_.load();
+    while (!pending_.compare_exchange_weak(record->next, record)) {}
+    drain();
+#else
+    try
     {
-        return c;
+        display(record->msg, verbosity, group);
     }
-    else if (c == '\n')
+    catch (...)
     {
-        buffer_.emplace_back();
+        release(record);
+        throw;
     }
-    else
+    release(record);
+#endif
+}
+
+#if DCCL_THREAD_SUPPORT
+void dccl::internal::LogSinks::drain()
+{
+    while (!draining_.test_and_set())
+    {
+        try
+        {
+            // the slots can be changed by connect() and disconnect()
+            DCCL_LOCK_DLOG_MUTEX
+            while (Record* record = pending_.exchange(nullptr))
+            {
+                // reverse into the order the lines were posted
+                Record* ordered = nullptr;
+                while (record)
+                {
+                    Record* next = record->next;
+                    record->next = ordered;
+                    ordered = record;
+                    record = next;
+                }
+
+                // displayed lines, released together
+                Record* done = nullptr;
+                try
+                {
+                    while (ordered)
+                    {
+                        Record* current = ordered;
+                        ordered = ordered->next;
+                        current->next = done;
+                        done = current;
+                        display(current->msg, current->verbosity, current->group);
+                    }
+                }
+                catch (...)
+                {
+                    // the lines not yet displayed are dropped
+                    release(done);
+                    release(ordered);
+                    throw;
+                }
+                release(done);
+            }
+        }
+        catch (...)
+        {
+            draining_.clear();
+            throw;
+        }
+
+        draining_.clear();
+
+        // another thread may have posted after the last exchange() but before clear(), leaving
+        // its line for us to display
+        if (!pending_.load())
+            break;
+    }
+}
+#endif
+
+int dccl::internal::LogBuffer::sync()
+{
+    flush_area();
+
+    // work on a copy in case the slots write to dlog themselves
+    std::string text;
+    text.swap(text_);
+
+    std::string::size_type begin = 0, end;
+    while ((end = text.find('\n', begin)) != std::string::npos)
     {
-        buffer_.back().push_back(c);
+        LogSinks::instance().post(text.data() + begin, end - begin, verbosity(), group());
+        begin = end + 1;
     }
-    return c;
+
+    // keep any incomplete line (and the larger buffer)
+    text.erase(0, begin);
+    text.append(text_);
+    text_.swap(text);
+
+    if (!verbosity_.empty())
+        verbosity_.pop_back();
+    if (!group_.empty())
+        group_.pop_back();
+
+    return 0;
+}
+
+int dccl::internal::LogBuffer::overflow(int c)
+{
+    flush_area();
+    if (c != EOF)
+        text_.push_back(static_cast<char>(c));
+    return traits_type::not_eof(c);
 }
 
 void dccl::to_ostream(const std::string& msg, dccl::logger::Verbosity /*vrb*/,
@@ -26,12 +26,10 @@
 #define DCCLLOGGER20121009H
 
 #include <cstdio>
-#include <deque>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
-#include <stack>
 #include <string>
 #include <vector>
 
@@ -57,6 +55,7 @@ enum Verbosity
     DEBUG3_PLUS = DEBUG3 | (DEBUG3 - 1),
     UNKNOWN = 0
 };
+
 enum Group
 {
     GENERAL,
@@ -65,6 +64,12 @@ enum Group
     SIZE
 };
 
+/// \brief Whether any of the levels in `verbosity` (a single level or a mask such as DEBUG1_PLUS) are at or below DCCL_LOG_LEVEL, i.e. whether dlog statements with this verbosity are compiled in
+constexpr bool compiled_in(Verbosity verbosity)
+{
+    return (verbosity & ((DCCL_LOG_LEVEL << 1) - 1)) != 0;
+}
+
 } // namespace logger
 
 void to_ostream(const std::string& msg, dccl::logger::Verbosity vrb, dccl::logger::Group grp,
@@ -74,11 +79,18 @@ class Logger;
 
 namespace internal
 {
-class LogBuffer : public std::streambuf
+#if DCCL_THREAD_SUPPORT
+/// set once the calling thread's dlog has been destroyed
+extern thread_local bool dlog_destroyed;
+#endif
+
+/// \brief The slots connected to dlog, shared by all threads
+///
+/// With DCCL_THREAD_SUPPORT, completed log lines are handed over through a lock-free queue: the thread that posts a line passes all queued lines to the slots unless another thread is already doing so, in which case that thread passes on the new line too. Logging threads therefore never wait on each other.
+class LogSinks
 {
   public:
-    LogBuffer() : buffer_(1) {}
-    ~LogBuffer() override = default;
+    static LogSinks& instance();
 
     /// connect a signal to a slot (function pointer or similar)
     template <typename Slot> void connect(int verbosity_mask, Slot slot)
@@ -111,95 +123,168 @@ class LogBuffer : public std::streambuf
             debug3_signal.clear();
     }
 
-    /// sets the verbosity level until the next sync()
-    void set_verbosity(logger::Verbosity verbosity) { verbosity_.push(verbosity); }
-
-    void set_group(logger::Group group) { group_.push(group); }
-
     bool contains(logger::Verbosity verbosity) const { return verbosity & enabled_verbosities_; }
 
-  private:
-    /// virtual inherited from std::streambuf.
-    /// Called when std::endl or std::flush is inserted into the stream
-    int sync() override;
+    /// \brief Pass a completed line (of `length` characters at `line`, copied) to the slots connected to its verbosity
+    void post(const char* line, std::size_t length, logger::Verbosity verbosity,
+              logger::Group group);
 
-    /// virtual inherited from std::streambuf. Called when something is inserted into the stream
-    /// Called when std::endl or std::flush is inserted into the stream
-    int overflow(int c = EOF) override;
+  private:
+    LogSinks() = default;
+    ~LogSinks();
 
-    void display(const std::string& s)
+    void display(const std::string& s, logger::Verbosity verbosity, logger::Group group)
     {
-        if (verbosity() & logger::WARN)
+        if (verbosity & logger::WARN)
         {
-            for (auto& slot : warn_signal) slot(s, logger::WARN, group());
+            for (auto& slot : warn_signal) slot(s, logger::WARN, group);
         }
-        if (verbosity() & logger::INFO)
+        if (verbosity & logger::INFO)
         {
-            for (auto& slot : info_signal) slot(s, logger::INFO, group());
+            for (auto& slot : info_signal) slot(s, logger::INFO, group);
         }
-        if (verbosity() & logger::DEBUG1)
+        if (verbosity & logger::DEBUG1)
         {
-            for (auto& slot : debug1_signal) slot(s, logger::DEBUG1, group());
+            for (auto& slot : debug1_signal) slot(s, logger::DEBUG1, group);
         }
-        if (verbosity() & logger::DEBUG2)
+        if (verbosity & logger::DEBUG2)
         {
-            for (auto& slot : debug2_signal) slot(s, logger::DEBUG2, group());
+            for (auto& slot : debug2_signal) slot(s, logger::DEBUG2, group);
         }
-        if (verbosity() & logger::DEBUG3)
+        if (verbosity & logger::DEBUG3)
         {
-            for (auto& slot : debug3_signal) slot(s, logger::DEBUG3, group());
+            for (auto& slot : debug3_signal) slot(s, logger::DEBUG3, group);
         }
     }
 
-    logger::Verbosity verbosity()
+  private:
+    // a posted line; reused (along with the capacity of msg) once displayed, so that logging does not allocate for each line
+    struct Record
     {
-        return verbosity_.empty() ? logger::UNKNOWN : verbosity_.top();
-    }
-    logger::Group group() { return group_.empty() ? logger::GENERAL : group_.top(); }
+        std::string msg;
+        logger::Verbosity verbosity{logger::UNKNOWN};
+        logger::Group group{logger::GENERAL};
+        Record* next{nullptr};
+    };
+    struct RecordCache;
 
-  private:
-    std::stack<logger::Verbosity> verbosity_;
-    std::stack<logger::Group> group_;
-    std::deque<std::string> buffer_;
-    int enabled_verbosities_; // mask of verbosity settings enabled
+    // take a Record for a new line from the calling thread's cache, refilled from free_ (or allocated if there are none)
+    Record* acquire();
+    // return a chain of Records (linked by next) to free_
+    void release(Record* chain);
+
+#if DCCL_THREAD_SUPPORT
+    // pass all posted lines to the slots, unless another thread is already doing so
+    void drain();
+
+    // lines posted but not yet displayed (most recent first)
+    std::atomic<Record*> pending_{nullptr};
+    // set while a thread is passing lines to the slots
+    std::atomic_flag draining_ = ATOMIC_FLAG_INIT;
+    // Records released after display. Threads only ever take the whole list at once (exchange), so there is no ABA problem with the lock-free push in release()
+    std::atomic<Record*> free_{nullptr};
+
+    // mask of verbosity settings enabled
+    std::atomic<int> enabled_verbosities_{0};
+#else
+    int enabled_verbosities_{0};
+    Record* free_{nullptr};
+#endif
 
     using LogSignal = std::vector<
         std::function<void(const std::string& msg, logger::Verbosity vrb, logger::Group grp)>>;
 
     LogSignal warn_signal, info_signal, debug1_signal, debug2_signal, debug3_signal;
 };
+
+/// \brief Per-Logger (and so, with DCCL_THREAD_SUPPORT, per-thread) buffer for the text of the current log statement
+class LogBuffer : public std::streambuf
+{
+  public:
+    LogBuffer() { setp(area_, area_ + sizeof(area_)); }
+    ~LogBuffer() override = default;
+
+    /// sets the verbosity level until the next sync()
+    void set_verbosity(logger::Verbosity verbosity) { verbosity_.push_back(verbosity); }
+
+    void set_group(logger::Group group) { group_.push_back(group); }
+
+  private:
+    /// virtual inherited from std::streambuf.
+    /// Called when std::endl or std::flush is inserted into the stream
+    int sync() override;
+
+    /// virtual inherited from std::streambuf. Called when the put area is full
+    int overflow(int c = EOF) override;
+
+    // move the contents of the put area into text_
+    void flush_area()
+    {
+        text_.append(pbase(), pptr());
+        setp(area_, area_ + sizeof(area_));
+    }
+
+    logger::Verbosity verbosity() const
+    {
+        return verbosity_.empty() ? logger::UNKNOWN : verbosity_.back();
+    }
+    logger::Group group() const { return group_.empty() ? logger::GENERAL : group_.back(); }
+
+  private:
+    // stacks (the vectors keep their capacity, so do not allocate once in use)
+    std::vector<logger::Verbosity> verbosity_;
+    std::vector<logger::Group> group_;
+    char area_[256];
+    // text written but not yet posted
+    std::string text_;
+};
 } // namespace internal
 
 /// The DCCL Logger class. Do not instantiate this class directly. Rather, use the dccl::dlog object.
+///
+/// With DCCL_THREAD_SUPPORT, dlog is thread_local so each thread formats its log statements independently, without locking. The slots are shared by all threads. Note that this changes the ABI of dlog compared to earlier versions (where it was a plain global): code using dlog must be recompiled against these headers, and each access to dlog goes through the compiler's thread_local wrapper function (which initializes the calling thread's Logger on first use).
 class Logger : public std::ostream
 {
   public:
     Logger() : std::ostream(&buf_) {}
+#if DCCL_THREAD_SUPPORT
+    ~Logger() override { internal::dlog_destroyed = true; }
+#else
     ~Logger() override = default;
+#endif
 
-    /// \brief Same as is() but doesn't set the verbosity or lock the mutex.
-    bool check(logger::Verbosity verbosity) { return buf_.contains(verbosity); }
+    /// \brief Same as is() but doesn't set the verbosity.
+    bool check(logger::Verbosity verbosity)
+    {
+        // constant for the typical literal verbosity, allowing statements above DCCL_LOG_LEVEL to be removed at compile time
+        if (!logger::compiled_in(verbosity))
+            return false;
+#if DCCL_THREAD_SUPPORT
+        // the main thread's dlog is destroyed before the globals, so statements in their destructors (e.g. of a global dccl::Codec) are dropped
+        if (internal::dlog_destroyed)
+            return false;
+#endif
+        return internal::LogSinks::instance().contains(verbosity);
+    }
 
-    /// \brief Indicates the verbosity of the Logger until the next std::flush or std::endl. The boolean return is used to take advantage of short-circuit evaluation of && to avoid spending CPU time generating log files that if they are not used. This locks the dlog mutex when running with DCCL_THREAD_SUPPORT
+    /// \brief Indicates the verbosity of the Logger until the next std::flush or std::endl. The boolean return is used to take advantage of short-circuit evaluation of && to avoid spending CPU time generating log files that if they are not used.
     ///
     /// The typical usage is
     /// \code
     /// dlog.is(INFO) && dlog << "Something of interest." << std::endl;
     /// dlog.is(WARN, ENCODE) && dlog << "Something bad happened while encoding." << std::endl;
     /// \endcode
+    /// Statements with a verbosity above DCCL_LOG_LEVEL (set at compile time, e.g. with -DDCCL_LOG_LEVEL=INFO) always return false, so are removed entirely by the optimizer.
     /// \param verbosity The verbosity level to tag the following message with. These levels are used to direct the output of dlog to different logs or omit them completely.
     /// \param group The group that this message belongs to.
     bool is(logger::Verbosity verbosity, logger::Group group = logger::GENERAL)
     {
-        if (!buf_.contains(verbosity))
+        if (!check(verbosity))
         {
             return false;
         }
         else
         {
-#if DCCL_THREAD_SUPPORT
-            g_dlog_mutex.lock();
-#endif
             buf_.set_verbosity(verbosity);
             buf_.set_group(group);
             return true;
@@ -214,7 +299,7 @@ class Logger : public std::ostream
     template <typename Slot> void connect(int verbosity_mask, Slot slot)
     {
         DCCL_LOCK_DLOG_MUTEX
-        buf_.connect(verbosity_mask, slot);
+        internal::LogSinks::instance().connect(verbosity_mask, slot);
     }
 
     /// \brief Connect the output of one or more given verbosities to a member function
@@ -241,23 +326,28 @@ class Logger : public std::ostream
     void connect(int verbosity_mask, std::ostream* os, bool add_timestamp = true)
     {
         DCCL_LOCK_DLOG_MUTEX
-        buf_.connect(verbosity_mask,
-                     std::bind(to_ostream, std::placeholders::_1, std::placeholders::_2,
-                               std::placeholders::_3, os, add_timestamp));
+        internal::LogSinks::instance().connect(
+            verbosity_mask, std::bind(to_ostream, std::placeholders::_1, std::placeholders::_2,
+                                      std::placeholders::_3, os, add_timestamp));
     }
 
     /// \brief Disconnect all slots for one or more given verbosities
     void disconnect(int verbosity_mask)
     {
         DCCL_LOCK_DLOG_MUTEX
-        buf_.disconnect(verbosity_mask);
+        internal::LogSinks::instance().disconnect(verbosity_mask);
     }
 
   private:
     internal::LogBuffer buf_;
 };
 
+#if DCCL_THREAD_SUPPORT
+/// One Logger per thread (see Logger for the ABI implications)
+extern thread_local Logger dlog;
+#else
 extern Logger dlog;
+#endif
 
 inline std::string hash_as_string(std::size_t hash)
 {
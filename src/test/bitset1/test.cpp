@@ -22,7 +22,9 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
 #include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <string>
 #include <utility>
 
 #include "../../binary.h"
@@ -158,6 +160,155 @@ int main()
         assert(grandparent.to_ulong() == 0xD);
     }
 
+    // larger than the inline storage (256 bits)
+    {
+        std::cout << std::endl;
+        std::string bytes;
+        for (int i = 0; i < 80; ++i) bytes.push_back(static_cast<char>(i * 37 + 11));
+
+        Bitset big;
+        big.from_byte_string(bytes);
+        assert(big.size() == 640);
+        assert(big.to_byte_string() == bytes);
+
+        // append / prepend across word boundaries
+        Bitset odd(13, 0x1ABC);
+        Bitset appended(big);
+        appended.append(odd);
+        assert(appended.size() == 653);
+        for (Bitset::size_type i = 0; i < big.size(); ++i) assert(appended[i] == big[i]);
+        for (Bitset::size_type i = 0; i < odd.size(); ++i)
+            assert(appended[big.size() + i] == odd[i]);
+
+        Bitset prepended(big);
+        prepended.prepend(odd);
+        assert(prepended.size() == 653);
+        for (Bitset::size_type i = 0; i < odd.size(); ++i) assert(prepended[i] == odd[i]);
+        for (Bitset::size_type i = 0; i < big.size(); ++i)
+            assert(prepended[odd.size() + i] == big[i]);
+
+        // push_front / pop_front
+        Bitset pushed(big);
+        for (int i = 0; i < 100; ++i) pushed.push_front(i % 3 == 0);
+        for (int i = 99; i >= 0; --i)
+        {
+            assert(pushed.front() == (i % 3 == 0));
+            pushed.pop_front();
+        }
+        assert(pushed == big);
+
+        // shifts
+        Bitset shifted(big);
+        shifted <<= 75;
+        assert(shifted.size() == big.size());
+        for (Bitset::size_type i = 0; i < 75; ++i) assert(!shifted[i]);
+        for (Bitset::size_type i = 75; i < big.size(); ++i) assert(shifted[i] == big[i - 75]);
+        shifted >>= 75;
+        for (Bitset::size_type i = 0; i < big.size() - 75; ++i) assert(shifted[i] == big[i]);
+        for (Bitset::size_type i = big.size() - 75; i < big.size(); ++i) assert(!shifted[i]);
+
+        assert(shifted < big || shifted == big);
+        assert((big ^ big) == Bitset(big.size()));
+
+        // get_more_bits across the inline / heap boundary
+        Bitset parent(big);
+        Bitset child(&parent);
+        child.get_more_bits(3);
+        child.get_more_bits(300);
+        assert(child.size() == 303);
+        assert(parent.size() == big.size() - 303);
+        for (Bitset::size_type i = 0; i < child.size(); ++i) assert(child[i] == big[i]);
+        for (Bitset::size_type i = 0; i < parent.size(); ++i) assert(parent[i] == big[303 + i]);
+
+        bool caught = false;
+        try
+        {
+            child.get_more_bits(big.size());
+        }
+        catch (dccl::Exception&)
+        {
+            caught = true;
+        }
+        assert(caught);
+
+        // integer round trip
+        Bitset word(64);
+        word.from<std::uint64_t>(0xFEDCBA9876543210ull);
+        assert(word.to<std::uint64_t>() == 0xFEDCBA9876543210ull);
+        word.from<std::uint64_t>(0xFFull, 4);
+        assert(word.size() == 4 && word.to<std::uint64_t>() == 0xF);
+    }
+
+    // BitWriter / BitReader cursors
+    {
+        Bitset out;
+        dccl::BitWriter writer(&out);
+        writer.write(0x5, 3);
+        writer.write_bit(true);
+        writer.write_bytes("hello, world");
+        writer.write(0xFEDCBA9876543210ull, 64);
+        writer.write_zeros(5);
+        assert(writer.size() == 3 + 1 + 12 * 8 + 64 + 5);
+        assert(writer.written() == out);
+
+        Bitset parent(out);
+        Bitset child(&parent);
+        dccl::BitReader reader(&child);
+        assert(reader.read(3) == 0x5);
+        assert(reader.read_bit());
+        assert(reader.read_bytes(12) == "hello, world");
+        assert(reader.read(64) == 0xFEDCBA9876543210ull);
+        assert(reader.read(5) == 0);
+        assert(reader.consumed() == out.size());
+        assert(parent.empty() && child.empty());
+
+        bool caught = false;
+        try
+        {
+            reader.read(1);
+        }
+        catch (dccl::Exception&)
+        {
+            caught = true;
+        }
+        assert(caught);
+    }
+
+    // storing the bits directly in a caller's buffer
+    {
+        std::uint64_t words[3] = {~0ull, ~0ull, ~0ull};
+        char* buf = reinterpret_cast<char*>(words);
+        const std::uint64_t one = 1;
+        bool little_endian = *reinterpret_cast<const unsigned char*>(&one) == 1;
+
+        Bitset in_place;
+        assert(!in_place.store_in(buf + 1, sizeof(words) - 1));
+        assert(in_place.store_in(buf, sizeof(words)) == little_endian);
+        dccl::BitWriter writer(&in_place);
+        writer.write_bytes("hello");
+        writer.write(0x3, 3);
+        assert(in_place.stored_in(buf) == little_endian);
+
+        char out[6];
+        assert(in_place.to_byte_string(out, sizeof(out)) == 6);
+        assert(std::string(out, 5) == "hello" && out[5] == 0x3);
+        assert(in_place.to_byte_string(buf, sizeof(words)) == 6);
+        assert(std::string(buf, 6) == std::string(out, 6));
+        // rest of the buffer untouched
+        assert(static_cast<unsigned char>(buf[6]) == 0xFF);
+
+        // outgrowing the buffer moves the bits into the Bitset's own storage
+        writer.write_bytes(std::string(30, 'x'));
+        assert(!in_place.stored_in(buf));
+        Bitset expected;
+        expected.from_byte_string(std::string("hello") + std::string(1, 0x3));
+        expected.resize(5 * 8 + 3);
+        Bitset tail;
+        tail.from_byte_string(std::string(30, 'x'));
+        expected.append(tail);
+        assert(in_place == expected);
+    }
+
     std::cout << "all tests passed" << std::endl;
 
     return 0;
@@ -24,7 +24,11 @@
 // along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
 // tests all protobuf types with _default codecs, repeat and non repeat
 
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
+#include <stdexcept>
+#include <vector>
 
 #include <google/protobuf/descriptor.pb.h>
 
@@ -136,6 +140,68 @@ int main(int /*argc*/, char* /*argv*/ [])
     std::cout << "Try decode..." << std::endl;
     decode_check(bytes);
 
+    // encoding directly into a caller buffer must match the std::string encode
+    {
+        std::vector<char> buffer(bytes.size() + 10);
+        for (int n = 0; n < 2; ++n)
+        {
+            std::size_t size = codec.encode(buffer.data(), buffer.size(), msg_in);
+            assert(std::string(buffer.data(), size) == bytes);
+        }
+
+        // word aligned (encoded in place), unaligned (copied), and aligned but with max_len too
+        // short for the last (partial) word, all over stale contents which must be overwritten
+        // (and left alone past the end of the message)
+        std::vector<std::uint64_t> words(bytes.size() / 8 + 4);
+        char* aligned = reinterpret_cast<char*>(words.data());
+        for (std::size_t offset : {0, 1})
+        {
+            for (std::size_t max_len :
+                 {words.size() * 8 - offset, bytes.size(), bytes.size() - bytes.size() % 8 + 7})
+            {
+                if (max_len < bytes.size())
+                    continue;
+                std::fill(aligned, aligned + words.size() * 8, static_cast<char>(0xA5));
+                std::size_t size = codec.encode(aligned + offset, max_len, msg_in);
+                assert(std::string(aligned + offset, size) == bytes);
+                assert(std::all_of(aligned + offset + size, aligned + words.size() * 8,
+                                   [](char c) { return c == static_cast<char>(0xA5); }));
+            }
+        }
+
+        bool caught_too_small = false;
+        try
+        {
+            codec.encode(buffer.data(), bytes.size() - 1, msg_in);
+        }
+        catch (const std::length_error&)
+        {
+            caught_too_small = true;
+        }
+        assert(caught_too_small);
+    }
+
+    // encoding against a byte budget
+    {
+        std::string fits("prefix");
+        assert(codec.encode_if_fits(&fits, msg_in, bytes.size()) == bytes.size());
+        assert(fits == "prefix" + bytes);
+        assert(codec.encode_if_fits(&fits, msg_in, bytes.size() + 10) == codec.size(msg_in));
+        assert(fits == "prefix" + bytes + bytes);
+
+        for (std::size_t max_bytes : {bytes.size() - 1, std::size_t(1), std::size_t(0)})
+        {
+            std::string too_big("prefix");
+            assert(codec.encode_if_fits(&too_big, msg_in, max_bytes) == 0);
+            assert(too_big == "prefix");
+        }
+
+        // budget does not carry over to later calls
+        std::string again;
+        codec.encode(&again, msg_in);
+        assert(again == bytes);
+    }
+
     // make sure DCCL defaults stay wire compatible
 
     // v4
@@ -35,8 +35,9 @@
 using namespace dccl::test::arith;
 
 
-void run_test(dccl::arith::protobuf::ArithmeticModel& model,
-              const google::protobuf::Message& msg_in, bool set_model = true)
+// returns the encoded message
+std::string run_test(dccl::arith::protobuf::ArithmeticModel& model,
+                     const google::protobuf::Message& msg_in, bool set_model = true)
 {
     static int i = 0;
 
@@ -79,6 +80,151 @@ void run_test(dccl::arith::protobuf::ArithmeticModel& model,
 
     assert(msg_in.SerializeAsString() == msg_out->SerializeAsString());
     ++i;
+    return bytes;
+}
+
+// runs of pending follow bits longer than the 64 bit output buffer of the encoder
+void test_buffered_bit_writer()
+{
+    using Codec = dccl::arith::ArithmeticFieldCodec<double>;
+    Codec codec;
+
+    for (int follow : {0, 1, 63, 64, 65, 100, 200})
+    {
+        for (bool bit : {false, true})
+        {
+            dccl::Bitset bits;
+            Codec::BufferedBitWriter writer(&bits);
+
+            // offset the follow bits from the start of the buffered word
+            writer.write(true, 3);
+            int bits_to_follow = follow;
+            codec.bit_plus_follow(&writer, &bits_to_follow, bit);
+            assert(bits_to_follow == 0);
+            writer.write(false, 2);
+            writer.flush();
+
+            dccl::Bitset expected;
+            for (int i = 0; i < 3; ++i) expected.push_back(true);
+            expected.push_back(bit);
+            for (int i = 0; i < follow; ++i) expected.push_back(!bit);
+            for (int i = 0; i < 2; ++i) expected.push_back(false);
+
+            assert(bits == expected);
+        }
+    }
+}
+
+void test_reverse_code_bits()
+{
+    using Codec = dccl::arith::ArithmeticFieldCodec<double>;
+    assert(Codec::reverse_code_bits(0) == 0);
+    assert(Codec::reverse_code_bits(1) == 0x80000000);
+    assert(Codec::reverse_code_bits(0xB) == 0xD0000000);
+    assert(Codec::reverse_code_bits(0xFFFFFFFF) == 0xFFFFFFFF);
+    assert(Codec::reverse_code_bits(0x12345678) == 0x1E6A2C48);
+}
+
+// Model::value_to_symbol() as a plain std::upper_bound search of value_bound
+dccl::arith::Model::symbol_type reference_value_to_symbol(const dccl::arith::Model& model,
+                                                         double value)
+{
+    const auto& bounds = model.user_model().value_bound();
+    if (!(value >= bounds[0] && value <= bounds[bounds.size() - 1]))
+        return dccl::arith::Model::OUT_OF_RANGE_SYMBOL;
+
+    int upper = std::upper_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+    int lower = (upper == 0) ? 0 : upper - 1;
+    if (upper == bounds.size())
+        upper = lower;
+
+    // the closer of the two neighboring bounds, limited to the last symbol
+    int closest = (std::abs(bounds[lower] * bounds[lower] - value * value) <
+                   std::abs(bounds[upper] * bounds[upper] - value * value))
+                      ? lower
+                      : upper;
+    return std::min(closest, model.max_symbol());
+}
+
+// value_to_symbol() for evenly spaced (computed symbol) and uneven (searched) value_bound
+void test_value_to_symbol(dccl::Codec& codec)
+{
+    std::vector<std::vector<double>> all_bounds{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10},
+                                                {100.0, 100.1, 100.2, 100.3, 100.4, 100.5},
+                                                {-50, -25, 0, 25, 50},
+                                                {0, 1, 4, 9, 16, 100, 101}};
+
+    for (std::size_t m = 0; m < all_bounds.size(); ++m)
+    {
+        const std::vector<double>& bounds = all_bounds[m];
+
+        dccl::arith::protobuf::ArithmeticModel user_model;
+        user_model.set_name("value_to_symbol" + std::to_string(m));
+        for (std::size_t i = 0; i < bounds.size(); ++i)
+        {
+            user_model.add_value_bound(bounds[i]);
+            if (i + 1 < bounds.size())
+                user_model.add_frequency(i + 1);
+        }
+        dccl::arith::ModelManager::set_model(codec, user_model);
+        const dccl::arith::Model& model =
+            dccl::arith::model_manager(codec.manager()).find(user_model.name());
+
+        std::vector<double> values{std::numeric_limits<double>::quiet_NaN(),
+                                   std::numeric_limits<double>::infinity(),
+                                   -std::numeric_limits<double>::infinity(),
+                                   bounds.front() - 1,
+                                   bounds.back() + 1,
+                                   std::nextafter(bounds.back(), bounds.back() + 1)};
+        for (std::size_t i = 0; i + 1 < bounds.size(); ++i)
+        {
+            double step = bounds[i + 1] - bounds[i];
+            for (double frac : {0.0, 0.25, 0.49, 0.5, 0.51, 0.75, 0.99})
+                values.push_back(bounds[i] + frac * step);
+            values.push_back(std::nextafter(bounds[i + 1], bounds[i]));
+        }
+        values.push_back(bounds.back());
+
+        for (double value : values)
+            assert(model.value_to_symbol(value) == reference_value_to_symbol(model, value));
+
+        assert(model.value_to_symbol(std::numeric_limits<double>::quiet_NaN()) ==
+               dccl::arith::Model::OUT_OF_RANGE_SYMBOL);
+        assert(model.value_to_symbol(bounds.back()) == model.max_symbol());
+    }
+}
+
+// the static model's table from cumulative frequency to symbol, checked for every frequency
+void test_cumulative_lookup(dccl::Codec& codec)
+{
+    using dccl::arith::Model;
+
+    // evenly divisible frequencies put symbol boundaries on the table entry boundaries
+    for (bool even : {true, false})
+    {
+        dccl::arith::protobuf::ArithmeticModel user_model;
+        user_model.set_name(even ? "lookup_even" : "lookup_uneven");
+        user_model.set_eof_frequency(even ? 8 : 3);
+        user_model.set_out_of_range_frequency(0);
+        for (int i = 0; i < 300; ++i)
+        {
+            user_model.add_value_bound(i);
+            user_model.add_frequency(even ? 8 * (i % 5 + 1) : (i * 37) % 61 + 1);
+        }
+        user_model.add_value_bound(300);
+        dccl::arith::ModelManager::set_model(codec, user_model);
+        const Model& model = dccl::arith::model_manager(codec.manager()).find(user_model.name());
+
+        assert(model.total_freq(Model::DECODER) > 2 * 1024);
+        for (Model::freq_type c = 0, n = model.total_freq(Model::DECODER); c < n; ++c)
+        {
+            Model::symbol_type symbol =
+                model.cumulative_freq_to_symbol(std::make_pair(c, c), Model::DECODER).first;
+            std::pair<Model::freq_type, Model::freq_type> range =
+                model.symbol_to_cumulative_freq(symbol, Model::DECODER);
+            assert(range.first <= c && c < range.second);
+        }
+    }
 }
 
 // usage: dccl_test10 [boolean: verbose]
@@ -91,6 +237,84 @@ int main(int argc, char* argv[])
 
     dccl::Codec codec;
 
+    test_buffered_bit_writer();
+    test_reverse_code_bits();
+    test_value_to_symbol(codec);
+    test_cumulative_lookup(codec);
+
+    // message shorter than the decoder's 32 bit code register
+    {
+        dccl::arith::protobuf::ArithmeticModel model;
+
+        model.set_eof_frequency(1);
+
+        model.add_value_bound(0);
+        model.add_frequency(1);
+
+        model.add_value_bound(1);
+        model.add_frequency(1);
+
+        model.add_value_bound(2);
+
+        model.set_out_of_range_frequency(0);
+
+        ArithmeticDoubleTestMsg msg_in;
+        msg_in.add_value(1);
+
+        std::string bytes = run_test(model, msg_in);
+        // one byte DCCL ID, then the arithmetic coded field
+        assert((bytes.size() - 1) * 8 < 32);
+    }
+
+    // the bits kept for debug_assert belong to each Codec, not the process
+    {
+        dccl::arith::protobuf::ArithmeticModel model;
+        model.set_name("model");
+        model.set_eof_frequency(2);
+        for (int v = 0; v < 4; ++v)
+        {
+            model.add_value_bound(v);
+            model.add_frequency(v + 1);
+        }
+        model.add_value_bound(4);
+        model.set_out_of_range_frequency(0);
+
+        dccl::Codec codec_a, codec_b;
+        for (dccl::Codec* c : {&codec_a, &codec_b})
+        {
+            c->load_library(DCCL_ARITHMETIC_NAME);
+            dccl::arith::ModelManager::set_model(*c, model);
+            c->load<ArithmeticDoubleTestMsg>();
+        }
+
+        ArithmeticDoubleTestMsg msg_a, msg_b;
+        msg_a.add_value(0);
+        msg_a.add_value(3);
+        msg_b.add_value(2);
+        msg_b.add_value(1);
+        msg_b.add_value(1);
+
+        // interleave the encodes, so a shared map would hold msg_b's bits when decoding msg_a
+        std::string bytes_a, bytes_b;
+        codec_a.encode(&bytes_a, msg_a);
+        codec_b.encode(&bytes_b, msg_b);
+
+        const google::protobuf::FieldDescriptor* field =
+            ArithmeticDoubleTestMsg::descriptor()->FindFieldByName("value");
+        dccl::Bitset last_a =
+            dccl::arith::model_manager(codec_a.manager()).debug_bits().last_bits[field];
+        dccl::Bitset last_b =
+            dccl::arith::model_manager(codec_b.manager()).debug_bits().last_bits[field];
+        assert(!(last_a == last_b));
+
+        // decode asserts the bits consumed match those its own Codec last encoded
+        ArithmeticDoubleTestMsg out_a, out_b;
+        codec_a.decode(bytes_a, &out_a);
+        codec_b.decode(bytes_b, &out_b);
+        assert(out_a.SerializeAsString() == msg_a.SerializeAsString());
+        assert(out_b.SerializeAsString() == msg_b.SerializeAsString());
+    }
+
     // test case from Practical Implementations of Arithmetic Coding by Paul G. Howard and Je rey Scott Vitter
     {
         dccl::arith::protobuf::ArithmeticModel model;
@@ -354,6 +578,9 @@ int main(int argc, char* argv[])
 
         model.add_value_bound(high);
 
+        // alternate static and adaptive models (many symbols exercise the adaptive frequency tree)
+        model.set_is_adaptive(i % 2);
+
         ArithmeticDouble2TestMsg msg_in;
 
         for (unsigned j = 0; j < i; ++j) msg_in.add_value(model.value_bound(rand() % symbols));
@@ -0,0 +1,255 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests encoding and decoding batches of messages to and from a single buffer
+
+#include <memory>
+#include <vector>
+
+#include <google/protobuf/arena.h>
+
+#include "../../binary.h"
+#include "../../codec.h"
+#include "test.pb.h"
+using namespace dccl::test;
+
+int main(int /*argc*/, char* /*argv*/ [])
+{
+    dccl::dlog.connect(dccl::logger::ALL, &std::cerr);
+
+    dccl::Codec codec;
+    codec.load<TestMsgA>();
+    codec.load<TestMsgB>();
+
+    std::vector<std::unique_ptr<google::protobuf::Message>> storage;
+    for (int i = 0; i < 20; ++i)
+    {
+        // runs of the same type interspersed with the other type
+        if (i % 7 == 6)
+        {
+            auto* b = new TestMsgB;
+            b->set_s("msg" + std::to_string(i));
+            if (i % 2)
+                b->set_b(true);
+            storage.emplace_back(b);
+        }
+        else
+        {
+            auto* a = new TestMsgA;
+            a->set_d(i * 1.25 - 10);
+            if (i % 3)
+                a->set_i(i * 100);
+            for (int j = 0; j < i % 5; ++j) a->add_u(i + j);
+            storage.emplace_back(a);
+        }
+    }
+
+    std::vector<const google::protobuf::Message*> msgs;
+    for (const auto& m : storage) msgs.push_back(m.get());
+
+    // existing contents are preserved
+    std::string bytes = "prefix";
+    std::vector<std::size_t> offsets;
+    codec.encode_batch(msgs, &bytes, &offsets);
+
+    std::cout << "Batch (hex): " << dccl::hex_encode(bytes) << std::endl;
+
+    assert(offsets.size() == msgs.size() + 1);
+    assert(offsets.front() == std::string("prefix").size());
+    assert(offsets.back() == bytes.size());
+
+    for (std::size_t i = 0, n = msgs.size(); i < n; ++i)
+    {
+        std::string single;
+        codec.encode(&single, *msgs[i]);
+        std::string batched = bytes.substr(offsets[i], offsets[i + 1] - offsets[i]);
+        assert(single == batched);
+
+        std::unique_ptr<google::protobuf::Message> decoded(
+            codec.decode<google::protobuf::Message*>(batched));
+        assert(decoded->SerializeAsString() == msgs[i]->SerializeAsString());
+    }
+
+    // decode all of the batch at once, on an arena
+    {
+        google::protobuf::Arena arena;
+        std::string batch = bytes.substr(offsets.front());
+        auto decoded = codec.decode_all(batch, &arena);
+        assert(decoded.size() == msgs.size());
+        for (std::size_t i = 0, n = msgs.size(); i < n; ++i)
+        {
+            assert(decoded[i].first->GetArena() == &arena);
+            assert(decoded[i].second == offsets[i] - offsets.front());
+            assert(decoded[i].first->GetDescriptor() == msgs[i]->GetDescriptor());
+            assert(decoded[i].first->SerializeAsString() == msgs[i]->SerializeAsString());
+        }
+
+        // and on the heap
+        auto heap_decoded = codec.decode_all(batch.begin(), batch.end(), nullptr);
+        assert(heap_decoded.size() == msgs.size());
+        for (auto& msg_offset : heap_decoded)
+        {
+            assert(msg_offset.first->GetArena() == nullptr);
+            delete msg_offset.first;
+        }
+
+        // truncated buffer
+        bool caught = false;
+        try
+        {
+            codec.decode_all(batch.substr(0, batch.size() - 1), &arena);
+        }
+        catch (const dccl::Exception& e)
+        {
+            std::cout << "Expected exception: " << e.what() << std::endl;
+            caught = true;
+        }
+        assert(caught);
+    }
+
+    // a packet of many messages: each decode only reads its own message's bytes
+    {
+        std::vector<const google::protobuf::Message*> many_msgs;
+        for (int n = 0; n < 500; ++n) many_msgs.insert(many_msgs.end(), msgs.begin(), msgs.end());
+        std::string many_bytes;
+        std::vector<std::size_t> many_offsets;
+        codec.encode_batch(many_msgs, &many_bytes, &many_offsets);
+
+        google::protobuf::Arena arena;
+        auto decoded = codec.decode_all(many_bytes, &arena);
+        assert(decoded.size() == many_msgs.size());
+        for (std::size_t i = 0, n = many_msgs.size(); i < n; ++i)
+        {
+            assert(decoded[i].second == many_offsets[i]);
+            assert(decoded[i].first->SerializeAsString() == many_msgs[i]->SerializeAsString());
+        }
+
+        // decode(std::string*) also returns the remainder untouched
+        std::string remainder = many_bytes;
+        std::unique_ptr<google::protobuf::Message> first(
+            codec.decode<google::protobuf::Message*>(&remainder));
+        assert(first->SerializeAsString() == many_msgs[0]->SerializeAsString());
+        assert(remainder == many_bytes.substr(many_offsets[1]));
+    }
+
+    // header only
+    {
+        std::string head_bytes;
+        std::vector<std::size_t> head_offsets;
+        codec.encode_batch(msgs.begin(), msgs.end(), &head_bytes, &head_offsets, true);
+        for (std::size_t i = 0, n = msgs.size(); i < n; ++i)
+        {
+            std::string single;
+            codec.encode(&single, *msgs[i], true);
+            assert(single == head_bytes.substr(head_offsets[i],
+                                               head_offsets[i + 1] - head_offsets[i]));
+        }
+    }
+
+    // empty batch
+    {
+        std::string empty_bytes;
+        std::vector<std::size_t> empty_offsets{1, 2, 3};
+        codec.encode_batch(msgs.end(), msgs.end(), &empty_bytes, &empty_offsets);
+        assert(empty_bytes.empty());
+        assert(empty_offsets.size() == 1 && empty_offsets[0] == 0);
+    }
+
+    // encrypted batches, with the bodies encrypted across several threads
+    {
+        dccl::Codec crypto_codec;
+        crypto_codec.load<TestMsgA>();
+        crypto_codec.load<TestMsgB>();
+        crypto_codec.set_crypto_passphrase("my_passphrase!");
+        crypto_codec.set_crypto_threads(4);
+
+        std::vector<const google::protobuf::Message*> many_msgs;
+        for (int n = 0; n < 10; ++n) many_msgs.insert(many_msgs.end(), msgs.begin(), msgs.end());
+
+        std::string crypto_bytes;
+        std::vector<std::size_t> crypto_offsets;
+        crypto_codec.encode_batch(many_msgs, &crypto_bytes, &crypto_offsets);
+        assert(crypto_offsets.size() == many_msgs.size() + 1);
+
+        // same layout as without a passphrase, but the bodies must actually be encrypted
+        std::string plain_bytes;
+        std::vector<std::size_t> plain_offsets;
+        codec.encode_batch(many_msgs, &plain_bytes, &plain_offsets);
+        assert(plain_offsets == crypto_offsets);
+#if DCCL_HAS_CRYPTOPP
+        assert(crypto_bytes != plain_bytes);
+#else
+        assert(crypto_bytes == plain_bytes);
+#endif
+
+        // the crypto threads are reused by later batches
+        std::string again_bytes;
+        std::vector<std::size_t> again_offsets;
+        crypto_codec.encode_batch(many_msgs, &again_bytes, &again_offsets);
+        assert(again_bytes == crypto_bytes);
+        for (std::size_t i = 0, n = many_msgs.size(); i < n; ++i)
+        {
+            std::string single;
+            crypto_codec.encode(&single, *many_msgs[i]);
+            std::string batched =
+                crypto_bytes.substr(crypto_offsets[i], crypto_offsets[i + 1] - crypto_offsets[i]);
+            assert(single == batched);
+
+            std::unique_ptr<google::protobuf::Message> decoded(
+                crypto_codec.decode<google::protobuf::Message*>(batched));
+            assert(decoded->SerializeAsString() == many_msgs[i]->SerializeAsString());
+        }
+
+        // and all at once: each body is decrypted on its own, not along with the rest of the buffer
+        google::protobuf::Arena arena;
+        auto decoded = crypto_codec.decode_all(crypto_bytes, &arena);
+        assert(decoded.size() == many_msgs.size());
+        for (std::size_t i = 0, n = many_msgs.size(); i < n; ++i)
+        {
+            assert(decoded[i].second == crypto_offsets[i]);
+            assert(decoded[i].first->SerializeAsString() == many_msgs[i]->SerializeAsString());
+        }
+    }
+
+    // unloaded types throw, leaving prior messages in place
+    {
+        codec.unload(TestMsgB::descriptor());
+        std::string partial;
+        std::vector<std::size_t> partial_offsets;
+        bool caught = false;
+        try
+        {
+            codec.encode_batch(msgs, &partial, &partial_offsets);
+        }
+        catch (const dccl::Exception& e)
+        {
+            std::cout << "Expected exception: " << e.what() << std::endl;
+            caught = true;
+        }
+        assert(caught);
+        // messages 0-5 are TestMsgA
+        assert(partial_offsets.size() == 7);
+        assert(partial == bytes.substr(offsets[0], offsets[6] - offsets[0]));
+    }
+
+    std::cout << "all tests passed" << std::endl;
+}
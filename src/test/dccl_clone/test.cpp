@@ -0,0 +1,142 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests Codec::clone()
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "../../binary.h"
+#include "../../codec.h"
+#include "test.pb.h"
+using namespace dccl::test;
+
+template <typename ProtobufMessage>
+bool encodes(const dccl::Codec& codec, const ProtobufMessage& msg_in, std::string* bytes)
+{
+    try
+    {
+        bytes->clear();
+        codec.encode(bytes, msg_in);
+        return true;
+    }
+    catch (const dccl::Exception& e)
+    {
+        std::cout << "Expected exception: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+int main(int /*argc*/, char* /*argv*/ [])
+{
+    dccl::dlog.connect(dccl::logger::ALL, &std::cerr);
+
+    TestMsgA a;
+    a.set_d(10.25);
+    a.set_i(500);
+    a.add_u(3);
+    a.add_u(99);
+
+    TestMsgB b;
+    b.set_s("clone");
+
+    std::unique_ptr<dccl::Codec> clone;
+    std::string original_bytes;
+    {
+        dccl::Codec codec;
+        codec.load<TestMsgA>();
+
+        clone = codec.clone();
+        assert(&clone->manager() == &codec.manager());
+        assert(clone->loaded() == codec.loaded());
+
+        std::string clone_bytes;
+        assert(encodes(codec, a, &original_bytes));
+        assert(encodes(*clone, a, &clone_bytes));
+        assert(original_bytes == clone_bytes);
+
+        // loading and unloading are independent
+        clone->load<TestMsgB>();
+        assert(!codec.loaded().count(3));
+        std::string bytes;
+        assert(!encodes(codec, b, &bytes));
+        assert(encodes(*clone, b, &bytes));
+
+        codec.unload<TestMsgA>();
+        assert(!encodes(codec, a, &bytes));
+        assert(encodes(*clone, a, &bytes));
+
+        // clone of a clone
+        std::unique_ptr<dccl::Codec> clone2 = clone->clone();
+        assert(encodes(*clone2, b, &bytes));
+    }
+
+    // clone outlives the original
+    std::string bytes;
+    assert(encodes(*clone, a, &bytes));
+    assert(bytes == original_bytes);
+
+    TestMsgA a_out;
+    clone->decode(bytes, &a_out);
+    assert(a_out.SerializeAsString() == a.SerializeAsString());
+
+#if DCCL_THREAD_SUPPORT
+    // unload() on one clone invalidates the shared caches while another clone is encoding
+    {
+        dccl::Codec codec;
+        codec.load<TestMsgA>();
+        codec.load<TestMsgB>();
+
+        std::vector<std::unique_ptr<dccl::Codec>> clones;
+        for (int i = 0; i < 200; ++i) clones.push_back(codec.clone());
+
+        std::atomic<bool> done{false};
+        std::atomic<int> encoded{0};
+        std::thread worker([&]() {
+            while (!done || encoded < 100)
+            {
+                std::string worker_bytes;
+                codec.encode(&worker_bytes, a);
+                assert(worker_bytes == original_bytes);
+                TestMsgA worker_out;
+                codec.decode(worker_bytes, &worker_out);
+                assert(worker_out.SerializeAsString() == a.SerializeAsString());
+                ++encoded;
+            }
+        });
+
+        for (auto& c : clones)
+        {
+            c->unload<TestMsgB>();
+            c->unload<TestMsgA>();
+        }
+        done = true;
+        worker.join();
+
+        assert(codec.loaded().size() == 2);
+        assert(encodes(codec, b, &bytes));
+    }
+#endif
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -232,5 +232,32 @@ int main(int /*argc*/, char* /*argv*/ [])
     std::cout << "... got Message out:\n" << msg_out2.DebugString() << std::endl;
     assert(msg_in2.SerializeAsString() == msg_out2.SerializeAsString());
 
+    // cached codec lookups must follow changes to the codecs
+    {
+        const google::protobuf::FieldDescriptor* c_field =
+            CustomMsg2::descriptor()->FindFieldByName("c");
+        std::shared_ptr<dccl::FieldCodecBase> c_codec = codec.manager().find(c_field, 4, false, "");
+        assert(c_codec == codec.manager().find(c_field, 4, false, ""));
+        assert(codec.manager().find(CustomMsg::descriptor()) ==
+               codec.manager().find(CustomMsg::descriptor()));
+
+        codec.manager().remove<dccl::test::Int32RepeatedCodec>("int32_test_codec");
+        bool removed_codec_found = true;
+        try
+        {
+            codec.manager().find(c_field, 4, false, "");
+        }
+        catch (dccl::Exception& e)
+        {
+            removed_codec_found = false;
+        }
+        assert(!removed_codec_found);
+
+        codec.manager().add<dccl::test::Int32RepeatedCodec>("int32_test_codec");
+        std::shared_ptr<dccl::FieldCodecBase> new_c_codec =
+            codec.manager().find(c_field, 4, false, "");
+        assert(new_c_codec && new_c_codec != c_codec);
+    }
+
     std::cout << "all tests passed" << std::endl;
 }
@@ -0,0 +1,153 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests that the direct (typed) field path produces the same bits as the dccl::any path
+
+#include "../../codec.h"
+#include "../../codecs4/field_codec_default.h"
+#include "test.pb.h"
+
+using namespace dccl::test::direct_access;
+
+// identical to Codec, except that it always uses the dccl::any path
+template <typename Codec> class AnyPathCodec : public Codec
+{
+    bool direct_access(const google::protobuf::FieldDescriptor* /*field*/) override
+    {
+        return false;
+    }
+};
+
+template <typename Codec> void use_any_path(dccl::Codec& codec)
+{
+    const std::string name = dccl::Codec::default_codec_name(4);
+    codec.manager().remove<Codec>(name);
+    codec.manager().add<AnyPathCodec<Codec>>(name);
+}
+
+template <typename Codec, google::protobuf::FieldDescriptor::Type type>
+void use_any_path(dccl::Codec& codec)
+{
+    const std::string name = dccl::Codec::default_codec_name(4);
+    codec.manager().remove<Codec, type>(name);
+    codec.manager().add<AnyPathCodec<Codec>, type>(name);
+}
+
+void check(dccl::Codec& direct_codec, dccl::Codec& any_codec, const ScalarMsg& msg)
+{
+    std::cout << "Checking: " << msg.ShortDebugString() << std::endl;
+
+    std::string direct_bytes, any_bytes;
+    direct_codec.encode(&direct_bytes, msg);
+    any_codec.encode(&any_bytes, msg);
+    assert(direct_bytes == any_bytes);
+    assert(direct_codec.size(msg) == any_codec.size(msg));
+    assert(direct_codec.size(msg) == direct_bytes.size());
+
+    ScalarMsg direct_out, any_out;
+    direct_codec.decode(direct_bytes, &direct_out);
+    any_codec.decode(any_bytes, &any_out);
+    assert(direct_out.SerializeAsString() == any_out.SerializeAsString());
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    dccl::dlog.connect(dccl::logger::ALL, &std::cerr);
+
+    dccl::Codec direct_codec;
+    direct_codec.load<ScalarMsg>();
+
+    dccl::Codec any_codec;
+    {
+        using namespace dccl::v4;
+        using google::protobuf::FieldDescriptor;
+        use_any_path<DefaultNumericFieldCodec<double>>(any_codec);
+        use_any_path<DefaultNumericFieldCodec<float>>(any_codec);
+        use_any_path<DefaultNumericFieldCodec<dccl::int32>>(any_codec);
+        use_any_path<DefaultNumericFieldCodec<dccl::int64>>(any_codec);
+        use_any_path<DefaultNumericFieldCodec<dccl::uint32>>(any_codec);
+        use_any_path<DefaultNumericFieldCodec<dccl::uint64>>(any_codec);
+        use_any_path<DefaultBoolCodec>(any_codec);
+        use_any_path<DefaultEnumCodec>(any_codec);
+        use_any_path<DefaultStringCodec, FieldDescriptor::TYPE_STRING>(any_codec);
+        use_any_path<DefaultBytesCodec, FieldDescriptor::TYPE_BYTES>(any_codec);
+    }
+    any_codec.load<ScalarMsg>();
+
+    // make sure each codec actually takes the path we're comparing
+    const google::protobuf::Descriptor* desc = ScalarMsg::descriptor();
+    const std::string group = dccl::FieldCodecBase::codec_group(desc);
+    for (int i = 0, n = desc->field_count(); i < n; ++i)
+    {
+        const google::protobuf::FieldDescriptor* field = desc->field(i);
+        assert(direct_codec.manager().find(field, 4, true, group)->direct_access(field));
+        assert(!any_codec.manager().find(field, 4, true, group)->direct_access(field));
+    }
+
+    ScalarMsg msg;
+    msg.set_req_int32(-100);
+    msg.set_req_bool(false);
+    msg.set_req_string("");
+
+    // all optional fields unset (null values)
+    check(direct_codec, any_codec, msg);
+
+    // every field set
+    msg.set_req_int32(500);
+    msg.set_req_bool(true);
+    msg.set_req_string("required");
+    msg.set_double_default(-12.34);
+    msg.set_float_default(14.521);
+    msg.set_int32_default(2999);
+    msg.set_int64_default(-100);
+    msg.set_uint32_default(100);
+    msg.set_uint64_default(6);
+    msg.set_sint32_default(-59);
+    msg.set_sint64_default(33);
+    msg.set_fixed32_default(400);
+    msg.set_fixed64_default(0);
+    msg.set_sfixed32_default(11);
+    msg.set_sfixed64_default(-120);
+    msg.set_bool_default(false);
+    msg.set_string_default("abc123");
+    msg.set_bytes_default(std::string("\x00\x01\xff", 3));
+    msg.set_enum_default(ENUM_C);
+    check(direct_codec, any_codec, msg);
+
+    // out of range values are encoded as null (not strict)
+    msg.set_double_default(127);
+    msg.set_float_default(-21);
+    msg.set_int32_default(3001);
+    msg.set_int64_default(-101);
+    msg.set_uint32_default(101);
+    msg.set_uint64_default(4);
+    msg.set_sint32_default(-61);
+    msg.set_sint64_default(101);
+    msg.set_fixed32_default(401);
+    msg.set_fixed64_default(3001);
+    msg.set_sfixed32_default(10);
+    msg.set_sfixed64_default(-121);
+    msg.set_string_default("too long for this");
+    check(direct_codec, any_codec, msg);
+
+    std::cout << "all tests passed" << std::endl;
+}
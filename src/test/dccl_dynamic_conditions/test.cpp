@@ -41,6 +41,55 @@ using namespace dccl::test;
 dccl::Codec codec;
 TestMsg msg_in;
 
+// conditions run by Lua, with the same message object (so the same address) given different
+// contents for each encode/decode pass
+void test4()
+{
+    codec.load<LuaOnlyMsg>();
+
+    LuaOnlyMsg lua_in, lua_out;
+    for (int n : {3, 2, 5, 5, 0, 7, 4, 6, 9})
+    {
+        lua_in.Clear();
+        lua_in.set_n(n);
+        lua_in.set_v(n * 5);
+        for (int i = 0; i < n / 2; ++i) lua_in.add_r(i * 10);
+        if (n % 3 == 0)
+            lua_in.mutable_sub()->set_s(7);
+        lua_in.set_w1(n);
+        lua_in.set_w2(n);
+        lua_in.set_w3(n);
+        lua_in.set_w4(n);
+
+        std::cout << "Message in:\n" << lua_in.DebugString() << std::endl;
+        std::string bytes;
+        codec.encode(&bytes, lua_in);
+        std::cout << "... got bytes (hex): " << dccl::hex_encode(bytes) << std::endl;
+        assert(bytes.size() == codec.size(lua_in));
+
+        lua_out.Clear();
+        codec.decode(bytes, &lua_out);
+        std::cout << "... got Message out:\n" << lua_out.DebugString() << std::endl;
+
+        // v is only included for odd n
+        if (n % 2 == 0)
+            lua_in.clear_v();
+        // w1 needs at least two elements of r
+        if (n < 4)
+            lua_in.clear_w1();
+        // w2 needs sub to be set
+        if (n % 3 != 0)
+            lua_in.clear_w2();
+        // w3 needs n, r and sub to be set
+        if (n < 2 || n % 3 != 0)
+            lua_in.clear_w3();
+        // w4 needs r to be set
+        if (n < 2)
+            lua_in.clear_w4();
+        assert(lua_in.SerializeAsString() == lua_out.SerializeAsString());
+    }
+}
+
 void decode_check(const std::string& encoded);
 void test0();
 void test1();
@@ -48,6 +97,7 @@ void test2();
 #if CODEC_VERSION == 4
 void test3();
 #endif
+void test4();
 
 int main(int /*argc*/, char* /*argv*/ [])
 {
@@ -59,6 +109,7 @@ int main(int /*argc*/, char* /*argv*/ [])
     // oneof
     test3();
 #endif
+    test4();
     std::cout << "all tests passed" << std::endl;
 }
 
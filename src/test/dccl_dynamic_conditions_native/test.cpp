@@ -0,0 +1,209 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests dynamic conditions evaluated natively (without Lua)
+
+#include "../../codec.h"
+#include "../../internal/dynamic_conditions_expression.h"
+#include "test.pb.h"
+
+using namespace dccl::test::native;
+using dccl::internal::ConditionExpression;
+
+dccl::Codec codec;
+
+void check(NativeTestMsg msg_in, const NativeTestMsg& msg_expected)
+{
+    std::cout << "Message in:\n" << msg_in.DebugString() << std::endl;
+    std::string bytes;
+    codec.encode(&bytes, msg_in);
+    std::cout << "... got bytes (hex): " << dccl::hex_encode(bytes) << std::endl;
+    assert(bytes.size() == codec.size(msg_in));
+
+    NativeTestMsg msg_out;
+    codec.decode(bytes, &msg_out);
+    std::cout << "... got Message out:\n" << msg_out.DebugString() << std::endl;
+    assert(msg_out.SerializeAsString() == msg_expected.SerializeAsString());
+}
+
+bool compiles(const std::string& script) { return ConditionExpression::compile(script) != nullptr; }
+
+double number(const std::string& script, const google::protobuf::Message& msg, int index = 0)
+{
+    return ConditionExpression::compile(script)->evaluate_number(&msg, &msg, index);
+}
+
+bool boolean(const std::string& script, const google::protobuf::Message& msg, int index = 0)
+{
+    return ConditionExpression::compile(script)->evaluate_bool(&msg, &msg, index);
+}
+
+int main(int /*argc*/, char* /*argv*/ [])
+{
+    dccl::dlog.connect(dccl::logger::ALL, &std::cerr);
+
+    // anything outside the native subset is left to Lua
+    assert(compiles("return this.state == 'STATE_1'"));
+    assert(compiles("this_index*50+100"));
+    assert(compiles("not (1 < 2) or root.child[this_index].enabled"));
+    assert(!compiles("print(this_index); return true"));
+    assert(!compiles("this.name .. 'x'"));
+    assert(!compiles("math.max(this.a, 1)"));
+    assert(!compiles("this.a -- comment"));
+    assert(!compiles("0x10"));
+    assert(!compiles("'a\\n'"));
+    assert(!compiles("this.a ="));
+    assert(!compiles("(this.a"));
+    assert(!compiles(""));
+
+    NativeTestMsg msg;
+    msg.set_mode(NativeTestMsg::MODE_SURVEY);
+    msg.add_sample(3);
+    msg.add_sample(4);
+    msg.add_child()->set_enabled(true);
+
+    // same results as Lua
+    assert(number("(1 + 2) * 3 % 4", msg) == 1);
+    assert(number("-7 % 3", msg) == 2);
+    assert(number("7 / 2", msg) == 3.5);
+    assert(number("1 and 2", msg) == 2);
+    assert(number("nil or 1e1", msg) == 10);
+    assert(number("this_index", msg, 4) == 5);
+    assert(number("#this.sample + this.sample[2]", msg) == 6);
+    assert(number("root.center", msg) == 0);
+    assert(!boolean("false or nil", msg));
+    assert(boolean("0", msg));
+    assert(!boolean("nil == false", msg));
+    assert(boolean("this.mode == 'MODE_SURVEY' and this['mode'] ~= 'MODE_IDLE'", msg));
+    assert(boolean("this.sample[3] == nil and this.no_such_field == nil", msg));
+    assert(boolean("root.child[1].enabled and 'abc' < 'abd'", msg));
+
+    // integers (including 64-bit fields) are exact, as with Lua 5.3+
+    IntegerTestMsg ints;
+    ints.set_big(9007199254740993LL); // 2^53 + 1, not representable as a double
+    ints.set_ubig(18446744073709551615ULL);
+    ints.set_real(0.5);
+    assert(boolean("this.big == 9007199254740993", ints));
+    assert(boolean("this.big ~= 9007199254740992", ints));
+    assert(boolean("this.big > 9007199254740992 and this.big >= 9007199254740993", ints));
+    assert(boolean("this.big ~= 9007199254740992.0 and this.big > 9007199254740992.0", ints));
+    assert(boolean("this.big - 1 == 9007199254740992", ints));
+    assert(boolean("this.big % 2 == 1 and -this.big % 2 == 1", ints));
+    assert(boolean("this.ubig > 9223372036854775807", ints));
+    assert(boolean("9223372036854775807 + 1 == -9223372036854775807 - 1", ints));
+    assert(boolean("1 == 1.0 and 0 < this.real and this.real < 1", ints));
+    assert(boolean("0/0 ~= 0/0 and not (0/0 >= 0) and not (0/0 < 0)", ints));
+
+    for (const char* bad : {"this.mode + 1", "this.sample[3].x", "1 < 'a'", "1 % 0"})
+    {
+        bool caught = false;
+        try
+        {
+            boolean(bad, msg);
+        }
+        catch (const dccl::Exception& e)
+        {
+            std::cout << "Expected error: " << e.what() << std::endl;
+            caught = true;
+        }
+        assert(caught);
+    }
+
+    codec.load<NativeTestMsg>();
+    codec.info<NativeTestMsg>();
+
+    {
+        NativeTestMsg msg_in, msg_expected;
+        msg_in.set_mode(NativeTestMsg::MODE_SURVEY);
+        msg_in.set_depth(50);
+        msg_in.set_altitude(20);
+        msg_in.set_center(100);
+        msg_in.set_offset(110);
+        for (int sample : {120, 999, 330, 999, 520}) msg_in.add_sample(sample);
+        for (int i = 0; i < 3; ++i)
+        {
+            NativeTestMsg::Child* child = msg_in.add_child();
+            child->set_enabled(i != 1);
+            child->set_value(i + 5);
+        }
+
+        msg_expected = msg_in;
+        // samples 2 and 4 (1-based) are omitted
+        msg_expected.clear_sample();
+        for (int sample : {120, 330, 520}) msg_expected.add_sample(sample);
+        msg_expected.mutable_child(1)->clear_value();
+        check(msg_in, msg_expected);
+    }
+
+    {
+        NativeTestMsg msg_in, msg_expected;
+        msg_in.set_mode(NativeTestMsg::MODE_IDLE);
+        msg_in.set_depth(50);
+        msg_in.set_altitude(20);
+        msg_in.set_center(100);
+        msg_in.set_offset(90);
+
+        msg_expected = msg_in;
+        msg_expected.clear_depth();
+        msg_expected.clear_altitude();
+        check(msg_in, msg_expected);
+    }
+
+    {
+        // compiled when loaded and cached by the manager until unloaded
+        const google::protobuf::FieldDescriptor* depth =
+            NativeTestMsg::descriptor()->FindFieldByName("depth");
+        const auto* compiled = codec.manager().native_conditions(depth);
+        assert(compiled && compiled->complete && compiled->only_if);
+        assert(compiled == codec.manager().native_conditions(depth));
+        std::size_t generation = codec.manager().generation();
+        codec.unload<NativeTestMsg>();
+        // the cache was dropped (the address may be reused, so check the generation instead)
+        assert(codec.manager().generation() != generation);
+        codec.load<NativeTestMsg>();
+        compiled = codec.manager().native_conditions(depth);
+        assert(compiled && compiled->complete && compiled->only_if);
+        assert(compiled == codec.manager().native_conditions(depth));
+    }
+
+#if !DCCL_HAS_LUA
+    {
+        codec.load<LuaTestMsg>();
+        LuaTestMsg msg_in;
+        msg_in.set_a(1);
+        bool caught = false;
+        try
+        {
+            std::string bytes;
+            codec.encode(&bytes, msg_in);
+        }
+        catch (const dccl::Exception& e)
+        {
+            std::cout << "Expected error: " << e.what() << std::endl;
+            caught = true;
+        }
+        assert(caught);
+    }
+#endif
+
+    std::cout << "all tests passed" << std::endl;
+}
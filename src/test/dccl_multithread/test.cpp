@@ -23,6 +23,7 @@
 // tests all protobuf types with _default codecs, repeat and non repeat
 
 #include <thread>
+#include <vector>
 
 #include "../../arithmetic/field_codec_arithmetic.h"
 #include "../../codec.h"
@@ -60,8 +61,10 @@ void arithmetic_run_test(dccl::Codec& codec, dccl::arith::protobuf::ArithmeticMo
     assert(msg_in.SerializeAsString() == msg_out->SerializeAsString());
 }
 
-void decode_check(dccl::Codec& codec, const std::string& encoded, TestMsg msg_in);
+void decode_check(const dccl::Codec& codec, const std::string& encoded, TestMsg msg_in);
+TestMsg make_test_msg();
 void run(int thread, int num_iterations);
+void run_shared(const dccl::Codec& codec, int num_iterations);
 int main(int /*argc*/, char* /*argv*/ [])
 {
     {
@@ -87,6 +90,31 @@ int main(int /*argc*/, char* /*argv*/ [])
         t10.join();
     }
 
+    // a single Codec shared by all the threads
+    {
+        dccl::Codec codec;
+        codec.load<TestMsg>();
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 10; ++t)
+            threads.emplace_back([&codec]() { run_shared(codec, 100); });
+        for (auto& thread : threads) thread.join();
+    }
+
+    // a clone of a loaded Codec per thread
+    {
+        dccl::Codec codec;
+        codec.load<TestMsg>();
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 10; ++t)
+        {
+            std::shared_ptr<dccl::Codec> clone(codec.clone());
+            threads.emplace_back([clone]() { run_shared(*clone, 100); });
+        }
+        for (auto& thread : threads) thread.join();
+    }
+
     dccl::dlog.connect(dccl::logger::ALL, &std::cerr);
     {
         std::thread t1([]() { run(1, 10); });
@@ -123,84 +151,7 @@ void run(int thread, int num_iterations)
     {
         std::cout << "Thread " << thread << ", it: " << m << std::endl;
         codec.info<TestMsg>();
-        TestMsg msg_in;
-        int i = 0;
-        msg_in.set_double_default_optional(++i + 0.1);
-        msg_in.set_float_default_optional(++i + 0.2);
-
-        msg_in.set_int32_default_optional(++i);
-        msg_in.set_int64_default_optional(-++i);
-        msg_in.set_uint32_default_optional(++i);
-        msg_in.set_uint64_default_optional(++i);
-        msg_in.set_sint32_default_optional(-++i);
-        msg_in.set_sint64_default_optional(++i);
-        msg_in.set_fixed32_default_optional(++i);
-        msg_in.set_fixed64_default_optional(++i);
-        msg_in.set_sfixed32_default_optional(++i);
-        msg_in.set_sfixed64_default_optional(-++i);
-
-        msg_in.set_bool_default_optional(true);
-
-        msg_in.set_string_default_optional("abc123");
-        msg_in.set_bytes_default_optional(dccl::hex_decode("00112233aabbcc1234"));
-
-        msg_in.set_enum_default_optional(ENUM_C);
-        msg_in.mutable_msg_default_optional()->set_val(++i + 0.3);
-        msg_in.mutable_msg_default_optional()->mutable_msg()->set_val(++i);
-
-        msg_in.set_double_default_required(++i + 0.1);
-        msg_in.set_float_default_required(++i + 0.2);
-
-        msg_in.set_int32_default_required(++i);
-        msg_in.set_int64_default_required(-++i);
-        msg_in.set_uint32_default_required(++i);
-        msg_in.set_uint64_default_required(++i);
-        msg_in.set_sint32_default_required(-++i);
-        msg_in.set_sint64_default_required(++i);
-        msg_in.set_fixed32_default_required(++i);
-        msg_in.set_fixed64_default_required(++i);
-        msg_in.set_sfixed32_default_required(++i);
-        msg_in.set_sfixed64_default_required(-++i);
-
-        msg_in.set_bool_default_required(true);
-
-        msg_in.set_string_default_required("abc123");
-        msg_in.set_bytes_default_required(dccl::hex_decode("00112233aabbcc1234"));
-
-        msg_in.set_enum_default_required(ENUM_C);
-        msg_in.mutable_msg_default_required()->set_val(++i + 0.3);
-        msg_in.mutable_msg_default_required()->mutable_msg()->set_val(++i);
-
-        for (int j = 0; j < 2; ++j)
-        {
-            msg_in.add_double_default_repeat(++i + 0.1);
-            msg_in.add_float_default_repeat(++i + 0.2);
-
-            msg_in.add_int32_default_repeat(++i);
-            msg_in.add_int64_default_repeat(-++i);
-            msg_in.add_uint32_default_repeat(++i);
-            msg_in.add_uint64_default_repeat(++i);
-            msg_in.add_sint32_default_repeat(-++i);
-            msg_in.add_sint64_default_repeat(++i);
-            msg_in.add_fixed32_default_repeat(++i);
-            msg_in.add_fixed64_default_repeat(++i);
-            msg_in.add_sfixed32_default_repeat(++i);
-            msg_in.add_sfixed64_default_repeat(-++i);
-
-            msg_in.add_bool_default_repeat(true);
-
-            msg_in.add_string_default_repeat("abc123");
-
-            if (j)
-                msg_in.add_bytes_default_repeat(dccl::hex_decode("00aabbcc"));
-            else
-                msg_in.add_bytes_default_repeat(dccl::hex_decode("ffeedd12"));
-
-            msg_in.add_enum_default_repeat(static_cast<Enum1>((++i % 3) + 1));
-            EmbeddedMsg1* em_msg = msg_in.add_msg_default_repeat();
-            em_msg->set_val(++i + 0.3);
-            em_msg->mutable_msg()->set_val(++i);
-        }
+        TestMsg msg_in = make_test_msg();
 
         std::string bytes;
         codec.encode(&bytes, msg_in);
@@ -235,7 +186,106 @@ void run(int thread, int num_iterations)
     }
 }
 
-void decode_check(dccl::Codec& codec, const std::string& encoded, TestMsg msg_in)
+TestMsg make_test_msg()
+{
+    TestMsg msg_in;
+    int i = 0;
+    msg_in.set_double_default_optional(++i + 0.1);
+    msg_in.set_float_default_optional(++i + 0.2);
+
+    msg_in.set_int32_default_optional(++i);
+    msg_in.set_int64_default_optional(-++i);
+    msg_in.set_uint32_default_optional(++i);
+    msg_in.set_uint64_default_optional(++i);
+    msg_in.set_sint32_default_optional(-++i);
+    msg_in.set_sint64_default_optional(++i);
+    msg_in.set_fixed32_default_optional(++i);
+    msg_in.set_fixed64_default_optional(++i);
+    msg_in.set_sfixed32_default_optional(++i);
+    msg_in.set_sfixed64_default_optional(-++i);
+
+    msg_in.set_bool_default_optional(true);
+
+    msg_in.set_string_default_optional("abc123");
+    msg_in.set_bytes_default_optional(dccl::hex_decode("00112233aabbcc1234"));
+
+    msg_in.set_enum_default_optional(ENUM_C);
+    msg_in.mutable_msg_default_optional()->set_val(++i + 0.3);
+    msg_in.mutable_msg_default_optional()->mutable_msg()->set_val(++i);
+
+    msg_in.set_double_default_required(++i + 0.1);
+    msg_in.set_float_default_required(++i + 0.2);
+
+    msg_in.set_int32_default_required(++i);
+    msg_in.set_int64_default_required(-++i);
+    msg_in.set_uint32_default_required(++i);
+    msg_in.set_uint64_default_required(++i);
+    msg_in.set_sint32_default_required(-++i);
+    msg_in.set_sint64_default_required(++i);
+    msg_in.set_fixed32_default_required(++i);
+    msg_in.set_fixed64_default_required(++i);
+    msg_in.set_sfixed32_default_required(++i);
+    msg_in.set_sfixed64_default_required(-++i);
+
+    msg_in.set_bool_default_required(true);
+
+    msg_in.set_string_default_required("abc123");
+    msg_in.set_bytes_default_required(dccl::hex_decode("00112233aabbcc1234"));
+
+    msg_in.set_enum_default_required(ENUM_C);
+    msg_in.mutable_msg_default_required()->set_val(++i + 0.3);
+    msg_in.mutable_msg_default_required()->mutable_msg()->set_val(++i);
+
+    for (int j = 0; j < 2; ++j)
+    {
+        msg_in.add_double_default_repeat(++i + 0.1);
+        msg_in.add_float_default_repeat(++i + 0.2);
+
+        msg_in.add_int32_default_repeat(++i);
+        msg_in.add_int64_default_repeat(-++i);
+        msg_in.add_uint32_default_repeat(++i);
+        msg_in.add_uint64_default_repeat(++i);
+        msg_in.add_sint32_default_repeat(-++i);
+        msg_in.add_sint64_default_repeat(++i);
+        msg_in.add_fixed32_default_repeat(++i);
+        msg_in.add_fixed64_default_repeat(++i);
+        msg_in.add_sfixed32_default_repeat(++i);
+        msg_in.add_sfixed64_default_repeat(-++i);
+
+        msg_in.add_bool_default_repeat(true);
+
+        msg_in.add_string_default_repeat("abc123");
+
+        if (j)
+            msg_in.add_bytes_default_repeat(dccl::hex_decode("00aabbcc"));
+        else
+            msg_in.add_bytes_default_repeat(dccl::hex_decode("ffeedd12"));
+
+        msg_in.add_enum_default_repeat(static_cast<Enum1>((++i % 3) + 1));
+        EmbeddedMsg1* em_msg = msg_in.add_msg_default_repeat();
+        em_msg->set_val(++i + 0.3);
+        em_msg->mutable_msg()->set_val(++i);
+    }
+    return msg_in;
+}
+
+void run_shared(const dccl::Codec& codec, int num_iterations)
+{
+    const TestMsg msg_in = make_test_msg();
+    std::string expected;
+    codec.encode(&expected, msg_in);
+
+    for (int m = 0; m < num_iterations; ++m)
+    {
+        std::string bytes;
+        codec.encode(&bytes, msg_in);
+        assert(bytes == expected);
+        assert(codec.size(msg_in) == bytes.size());
+        decode_check(codec, bytes, msg_in);
+    }
+}
+
+void decode_check(const dccl::Codec& codec, const std::string& encoded, TestMsg msg_in)
 {
     TestMsg msg_out;
     codec.decode(encoded, &msg_out);
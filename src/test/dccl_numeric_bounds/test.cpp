@@ -94,5 +94,40 @@ int main(int /*argc*/, char* /*argv*/ [])
         assert(msg_out_neg.b() == test_value[3]);
     }
 
+    // integer fields are quantized without floating point
+    {
+        dccl::Codec strict_codec;
+        strict_codec.set_strict(true);
+        strict_codec.load<LargeIntegerMsg>();
+
+        const dccl::int64 two_60 = 1152921504606846976ll;
+        LargeIntegerMsg msg_in_int, msg_out_int;
+        msg_in_int.set_a(two_60 + 1);
+        msg_in_int.set_b(two_60 + 1019);
+
+        std::string enc;
+        strict_codec.encode(&enc, msg_in_int);
+        strict_codec.decode(enc, &msg_out_int);
+        std::cout << "msg_out: " << msg_out_int.ShortDebugString() << std::endl;
+        assert(msg_out_int.a() == two_60 + 1);
+        assert(msg_out_int.b() == two_60 + 1016);
+
+        // one below min would compare equal to min as a double
+        for (dccl::int64 a : {two_60 - 1, two_60 + 1025})
+        {
+            msg_in_int.set_a(a);
+            bool out_of_range = false;
+            try
+            {
+                strict_codec.encode(&enc, msg_in_int);
+            }
+            catch (dccl::OutOfRangeException& e)
+            {
+                out_of_range = true;
+            }
+            assert(out_of_range);
+        }
+    }
+
     std::cout << "all tests passed" << std::endl;
 }
@@ -0,0 +1,235 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests the range coder and the "dccl.range" codec
+
+#include <cstdlib>
+#include <ctime>
+
+#include "../../arithmetic/field_codec_range.h"
+#include "../../binary.h"
+#include "../../codec.h"
+#include "test.pb.h"
+
+using namespace dccl::test::range;
+using dccl::arith::Model;
+
+// random model for the symbols [0, symbols) with values 0, 1, 2, ... and a total frequency <= 2^16
+dccl::arith::protobuf::ArithmeticModel random_model(int symbols, bool adaptive)
+{
+    dccl::arith::protobuf::ArithmeticModel model;
+    model.set_name("model");
+    model.set_is_adaptive(adaptive);
+
+    Model::freq_type each_max_freq =
+        dccl::arith::RangeFieldCodecBase<>::MAX_FREQUENCY / (symbols + 2) / (adaptive ? 2 : 1);
+
+    model.set_eof_frequency(rand() % each_max_freq + 1);
+    model.set_out_of_range_frequency(rand() % 2 ? rand() % each_max_freq + 1 : 0);
+    for (int i = 0; i < symbols; ++i)
+    {
+        // skewed, so there is something to compress
+        model.add_frequency((i % 4 == 0) ? each_max_freq : rand() % (each_max_freq / 8) + 1);
+        model.add_value_bound(i);
+    }
+    model.add_value_bound(symbols);
+    return model;
+}
+
+// pick a symbol with the probability given by the model
+int random_symbol(const dccl::arith::protobuf::ArithmeticModel& model)
+{
+    Model::freq_type total = 0;
+    for (auto freq : model.frequency()) total += freq;
+    Model::freq_type r = rand() % total;
+    for (int i = 0, n = model.frequency_size(); i < n; ++i)
+    {
+        if (r < model.frequency(i))
+            return i;
+        r -= model.frequency(i);
+    }
+    return 0;
+}
+
+int main(int /*argc*/, char* /*argv*/ [])
+{
+    dccl::dlog.connect(dccl::logger::WARN_PLUS, &std::cerr);
+
+    unsigned seed = time(nullptr);
+    std::cout << "seed: " << seed << std::endl;
+    srand(seed);
+
+    // encoder and decoder on their own
+    for (int trial = 0; trial < 200; ++trial)
+    {
+        int symbols = rand() % 300 + 1;
+        std::vector<Model::freq_type> freqs;
+        Model::freq_type total = 0;
+        for (int i = 0; i < symbols; ++i)
+        {
+            freqs.push_back(rand() % (65536 / symbols) + 1);
+            total += freqs.back();
+        }
+
+        std::vector<int> in;
+        dccl::arith::RangeEncoder encoder;
+        for (int i = 0, n = rand() % 1000; i < n; ++i)
+        {
+            int symbol = rand() % symbols;
+            in.push_back(symbol);
+            Model::freq_type start = 0;
+            for (int j = 0; j < symbol; ++j) start += freqs[j];
+            encoder.encode(start, freqs[symbol], total);
+        }
+        std::string bytes = encoder.finish();
+        assert(bytes.empty() || bytes.back() != 0);
+
+        dccl::arith::RangeDecoder decoder(bytes);
+        for (int symbol : in)
+        {
+            Model::freq_type c_freq = decoder.get_freq(total);
+            Model::freq_type start = 0;
+            int decoded = 0;
+            while (start + freqs[decoded] <= c_freq) start += freqs[decoded++];
+            assert(decoded == symbol);
+            decoder.decode(start, freqs[decoded]);
+        }
+    }
+
+    // static models: round trip, and compare with the arithmetic coder
+    for (int trial = 0; trial < 20; ++trial)
+    {
+        dccl::Codec codec;
+        codec.load_library(DCCL_ARITHMETIC_NAME);
+
+        dccl::arith::protobuf::ArithmeticModel model = random_model(rand() % 300 + 1, false);
+        dccl::arith::ModelManager::set_model(codec, model);
+        codec.load<RangeTestMsg>();
+        codec.load<ArithmeticTestMsg>();
+
+        RangeTestMsg msg_in;
+        ArithmeticTestMsg arith_msg_in;
+        for (int i = 0, n = rand() % 500; i < n; ++i)
+        {
+            int value = random_symbol(model);
+            msg_in.add_value(value);
+            arith_msg_in.add_value(value);
+        }
+
+        std::string bytes, arith_bytes;
+        codec.encode(&bytes, msg_in);
+        codec.encode(&arith_bytes, arith_msg_in);
+
+        std::cout << msg_in.value_size() << " values: range coded " << bytes.size()
+                  << " bytes, arithmetic coded " << arith_bytes.size() << " bytes" << std::endl;
+
+        // byte count prefix, byte alignment and flushing
+        assert(bytes.size() <= arith_bytes.size() + 4);
+
+        RangeTestMsg msg_out;
+        codec.decode(bytes, &msg_out);
+        assert(msg_in.SerializeAsString() == msg_out.SerializeAsString());
+    }
+
+    // adaptive model: a sequence of messages
+    {
+        dccl::Codec codec;
+        codec.load_library(DCCL_ARITHMETIC_NAME);
+
+        dccl::arith::protobuf::ArithmeticModel model = random_model(20, true);
+        dccl::arith::ModelManager::set_model(codec, model);
+        codec.load<RangeTestMsg>();
+
+        // the encoder and decoder models adapt independently (in step)
+        for (int m = 0; m < 10; ++m)
+        {
+            RangeTestMsg msg_in, msg_out;
+            for (int i = 0, n = rand() % 500; i < n; ++i) msg_in.add_value(rand() % 3);
+            // out of range (ends the field if the model has no out of range frequency)
+            msg_in.add_value(100);
+
+            std::string bytes;
+            codec.encode(&bytes, msg_in);
+            codec.decode(bytes, &msg_out);
+
+            if (model.out_of_range_frequency() == 0)
+                msg_in.mutable_value()->RemoveLast();
+            assert(msg_out.value_size() == msg_in.value_size());
+            for (int j = 0, n = msg_in.value_size() - 1; j < n; ++j)
+                assert(msg_out.value(j) == msg_in.value(j));
+        }
+    }
+
+    // single (non-repeated) enum
+    {
+        dccl::Codec codec;
+        codec.load_library(DCCL_ARITHMETIC_NAME);
+
+        dccl::arith::protobuf::ArithmeticModel model;
+        model.set_name("enum_model");
+        model.set_eof_frequency(0);
+        model.set_out_of_range_frequency(0);
+        model.add_value_bound(1);
+        model.add_frequency(10);
+        model.add_value_bound(2);
+        model.add_frequency(2);
+        model.add_value_bound(3);
+        model.add_frequency(1);
+        model.add_value_bound(4);
+        dccl::arith::ModelManager::set_model(codec, model);
+        codec.load<RangeSingleEnumTestMsg>();
+
+        for (Enum1 value : {ENUM_A, ENUM_B, ENUM_C})
+        {
+            RangeSingleEnumTestMsg msg_in, msg_out;
+            msg_in.set_value(value);
+            std::string bytes;
+            codec.encode(&bytes, msg_in);
+            codec.decode(bytes, &msg_out);
+            assert(msg_out.value() == value);
+        }
+    }
+
+    // models with a total frequency too large for the range coder are rejected
+    {
+        dccl::Codec codec;
+        codec.load_library(DCCL_ARITHMETIC_NAME);
+
+        dccl::arith::protobuf::ArithmeticModel model = random_model(10, false);
+        model.set_frequency(0, dccl::arith::RangeFieldCodecBase<>::MAX_FREQUENCY);
+        dccl::arith::ModelManager::set_model(codec, model);
+
+        bool caught = false;
+        try
+        {
+            codec.load<RangeTestMsg>();
+        }
+        catch (const dccl::Exception& e)
+        {
+            std::cout << "Expected exception: " << e.what() << std::endl;
+            caught = true;
+        }
+        assert(caught);
+    }
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -0,0 +1,196 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+// tests the binary trace of encoded/decoded fields (dccl::TraceBuffer)
+
+#include <sstream>
+
+#include "../../codec.h"
+#include "test.pb.h"
+
+using namespace dccl::test::trace;
+using dccl::TraceRecord;
+
+// all but the DECODE flag
+bool same_field(const TraceRecord& a, const TraceRecord& b)
+{
+    return a.bit_offset == b.bit_offset && a.bit_length == b.bit_length &&
+           a.field_number == b.field_number && a.codec_id == b.codec_id && a.part == b.part &&
+           (a.flags & ~TraceRecord::DECODE) == (b.flags & ~TraceRecord::DECODE) &&
+           a.depth == b.depth;
+}
+
+int main(int /*argc*/, char* /*argv*/ [])
+{
+    dccl::dlog.connect(dccl::logger::ALL, &std::cerr);
+
+    dccl::Codec codec;
+    codec.load<TestMsg>();
+
+    TestMsg msg_in;
+    msg_in.set_source(5);
+    msg_in.set_depth(123.4);
+    msg_in.set_name("trace");
+    msg_in.mutable_child()->set_a(42);
+    msg_in.mutable_child()->set_b(true);
+    msg_in.add_values(1);
+    msg_in.add_values(6);
+
+    auto trace = std::make_shared<dccl::TraceBuffer>();
+    codec.set_trace(trace);
+
+    std::string bytes;
+    codec.encode(&bytes, msg_in);
+    std::vector<TraceRecord> encoded = trace->records();
+    trace->clear();
+    assert(trace->records().empty());
+
+    TestMsg msg_out;
+    codec.decode(bytes, &msg_out);
+    assert(msg_out.SerializeAsString() == msg_in.SerializeAsString());
+    std::vector<TraceRecord> decoded = trace->records();
+
+    std::vector<std::string> names = trace->codec_names();
+    dccl::TraceBuffer::render(std::cout, names, encoded);
+    dccl::TraceBuffer::render(std::cout, names, decoded);
+
+    // message (head), source, message (body), depth, name, child, child.a, child.b, values
+    assert(encoded.size() == 9);
+    assert(decoded.size() == encoded.size());
+    for (std::size_t i = 0, n = encoded.size(); i < n; ++i)
+    {
+        assert(!(encoded[i].flags & TraceRecord::DECODE));
+        assert(decoded[i].flags & TraceRecord::DECODE);
+        assert(same_field(encoded[i], decoded[i]));
+    }
+
+    // each part starts with the message itself, which contains all of its fields
+    std::size_t body_begin = 2;
+    assert(encoded[0].field_number == 0 && encoded[0].part == dccl::HEAD);
+    assert(encoded[0].bit_offset == 0 && encoded[0].depth == 0);
+    assert(encoded[1].field_number == 1 && encoded[1].part == dccl::HEAD);
+    assert(encoded[body_begin].field_number == 0 && encoded[body_begin].part == dccl::BODY);
+    assert(encoded[body_begin].bit_offset == 0);
+
+    for (std::size_t i = 0, n = encoded.size(); i < n; ++i)
+    {
+        const TraceRecord& record = encoded[i];
+        assert(record.bit_offset != TraceRecord::UNKNOWN_OFFSET);
+        assert(names.at(record.codec_id).size() > 0);
+        if (record.depth == 0)
+            continue;
+
+        // the closest earlier record one level up is the parent
+        std::size_t parent = i;
+        while (encoded[--parent].depth != record.depth - 1) {}
+        assert(record.part == encoded[parent].part);
+        assert(record.bit_offset >= encoded[parent].bit_offset);
+        assert(record.bit_offset + record.bit_length <=
+               encoded[parent].bit_offset + encoded[parent].bit_length);
+
+        // siblings are consecutive
+        if (encoded[i - 1].depth == record.depth)
+            assert(record.bit_offset >= encoded[i - 1].bit_offset + encoded[i - 1].bit_length);
+    }
+    assert(encoded[5].field_number == 4 && encoded[6].depth == 2 && encoded[7].depth == 2);
+    assert(encoded[8].field_number == 5 && (encoded[8].flags & TraceRecord::REPEATED));
+
+    assert((encoded[0].bit_length + encoded[body_begin].bit_length) <=
+           codec.size(msg_in) * dccl::BITS_IN_BYTE);
+
+    // binary format round trip
+    std::stringstream ss;
+    trace->write(ss);
+    std::vector<std::string> read_names;
+    std::vector<TraceRecord> read_records;
+    dccl::TraceBuffer::read(ss, &read_names, &read_records);
+    assert(read_names == names);
+    assert(read_records.size() == decoded.size());
+    for (std::size_t i = 0, n = decoded.size(); i < n; ++i)
+    {
+        assert(same_field(read_records[i], decoded[i]));
+        assert(read_records[i].flags == decoded[i].flags);
+    }
+
+    std::stringstream bad("not a trace");
+    try
+    {
+        dccl::TraceBuffer::read(bad, &read_names, &read_records);
+        assert(false);
+    }
+    catch (dccl::Exception& e)
+    {
+    }
+
+    // ring buffer keeps the newest records
+    auto small_trace = std::make_shared<dccl::TraceBuffer>(4);
+    codec.set_trace(small_trace);
+    std::string small_bytes;
+    codec.encode(&small_bytes, msg_in);
+    std::vector<TraceRecord> newest = small_trace->records();
+    assert(newest.size() == 4);
+    assert(small_trace->dropped() == encoded.size() - 4);
+    for (std::size_t i = 0; i < newest.size(); ++i)
+        assert(same_field(newest[i], encoded[encoded.size() - 4 + i]));
+
+    // codec ids cached in the codecs are per buffer: alternate between two buffers (whose
+    // names are added in a different order) and check each record still names the right codec
+    codec.load<OtherMsg>();
+    OtherMsg other;
+    other.set_flag(true);
+    other.set_label("abc");
+    auto trace_a = std::make_shared<dccl::TraceBuffer>();
+    auto trace_b = std::make_shared<dccl::TraceBuffer>();
+    codec.set_trace(trace_b);
+    codec.encode(&bytes, other);
+    std::size_t other_size = trace_b->records().size();
+    assert(trace_b->codec_names() != names);
+    for (int i = 0; i < 2; ++i)
+    {
+        codec.set_trace(trace_a);
+        codec.encode(&bytes, msg_in);
+        codec.set_trace(trace_b);
+        codec.encode(&bytes, msg_in);
+    }
+    for (const auto& alt : {trace_a, trace_b})
+    {
+        std::vector<TraceRecord> alt_records = alt->records();
+        std::vector<std::string> alt_names = alt->codec_names();
+        if (alt == trace_b)
+            alt_records.erase(alt_records.begin(), alt_records.begin() + other_size);
+        assert(alt_records.size() == 2 * encoded.size());
+        for (std::size_t i = 0; i < alt_records.size(); ++i)
+        {
+            const TraceRecord& expected = encoded[i % encoded.size()];
+            assert(alt_names.at(alt_records[i].codec_id) == names.at(expected.codec_id));
+        }
+    }
+
+    // disabled
+    codec.set_trace(nullptr);
+    small_trace->clear();
+    codec.encode(&bytes, msg_in);
+    codec.decode(bytes, &msg_out);
+    assert(small_trace->records().empty());
+
+    std::cout << "all tests passed" << std::endl;
+}
@@ -25,6 +25,14 @@
 
 #include "../../logger.h"
 
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if DCCL_THREAD_SUPPORT
+#include <thread>
+#endif
+
 /// asserts false if called - used for testing proper short-circuiting of logger calls
 inline std::ostream& stream_assert(std::ostream& os)
 {
@@ -39,6 +47,18 @@ void info(const std::string& log_message, dccl::logger::Verbosity /*verbosity*/,
     printf("%s\n", log_message.c_str());
 }
 
+#if DCCL_THREAD_SUPPORT
+// logs from its destructor, after the main thread's dlog has been destroyed
+struct LogAtExit
+{
+    ~LogAtExit()
+    {
+        using dccl::dlog;
+        dlog.is(dccl::logger::WARN) && dlog << stream_assert << std::endl;
+    }
+} log_at_exit;
+#endif
+
 int main(int /*argc*/, char* /*argv*/ [])
 {
     using dccl::dlog;
@@ -96,5 +116,61 @@ int main(int /*argc*/, char* /*argv*/ [])
     dlog.is(WARN) && dlog << "warn ok" << std::endl;
     dlog.disconnect(ALL);
 
+#if DCCL_THREAD_SUPPORT
+    std::cout << "logging from several threads" << std::endl;
+    {
+        int lines = 0;
+        dlog.connect(WARN, [&lines](const std::string& msg, Verbosity, Group) {
+            // each line is delivered whole
+            assert(msg.compare(0, 12, "thread line ") == 0 && msg.size() <= 15);
+            ++lines;
+        });
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([]() {
+                for (int i = 0; i < 1000; ++i)
+                    dlog.is(WARN) && dlog << "thread line " << i << std::endl;
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        assert(lines == 4000);
+        dlog.disconnect(ALL);
+    }
+#endif
+
+    std::cout << "slot throwing" << std::endl;
+    {
+        std::vector<std::string> shown;
+        dlog.connect(WARN, [&shown](const std::string& msg, Verbosity, Group) {
+            if (msg == "throw")
+                throw std::runtime_error("slot failed");
+            shown.push_back(msg);
+        });
+
+        auto& sinks = dccl::internal::LogSinks::instance();
+        bool caught = false;
+        try
+        {
+            sinks.post("throw", 5, WARN, GENERAL);
+        }
+        catch (const std::runtime_error&)
+        {
+            caught = true;
+        }
+        assert(caught);
+
+        // later lines are still displayed (reusing the released records)
+        for (int i = 0; i < 3; ++i) sinks.post("after", 5, WARN, GENERAL);
+        assert(shown == std::vector<std::string>(3, "after"));
+        dlog.disconnect(ALL);
+    }
+
+#if DCCL_THREAD_SUPPORT
+    // still connected when log_at_exit is destroyed
+    dlog.connect(WARN, &info);
+#endif
+
     std::cout << "All tests passed." << std::endl;
 }
@@ -0,0 +1,81 @@
+// Copyright 2012-2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+
+// tests removing dlog statements at compile time with DCCL_LOG_LEVEL (set to INFO for this test)
+
+#include <cassert>
+
+#include "../../logger.h"
+
+using namespace dccl::logger;
+
+// statements above INFO are removed at compile time
+static_assert(compiled_in(WARN), "WARN should be compiled in");
+static_assert(compiled_in(INFO), "INFO should be compiled in");
+static_assert(!compiled_in(DEBUG1), "DEBUG1 should be compiled out");
+static_assert(!compiled_in(DEBUG2), "DEBUG2 should be compiled out");
+static_assert(!compiled_in(DEBUG3), "DEBUG3 should be compiled out");
+
+// masks are compiled in if any of their levels are
+static_assert(compiled_in(ALL), "ALL includes INFO");
+static_assert(compiled_in(DEBUG1_PLUS), "DEBUG1_PLUS includes INFO");
+static_assert(compiled_in(DEBUG3_PLUS), "DEBUG3_PLUS includes INFO");
+static_assert(compiled_in(WARN_PLUS), "WARN_PLUS includes WARN");
+static_assert(!compiled_in(static_cast<Verbosity>(DEBUG2 | DEBUG3)), "DEBUG2 and DEBUG3 are both above INFO");
+static_assert(!compiled_in(UNKNOWN), "UNKNOWN has no levels");
+
+/// asserts false if called - used for testing that the statement was removed
+inline std::ostream& stream_assert(std::ostream& os)
+{
+    bool failed_to_remove_logging_statement = false;
+    assert(failed_to_remove_logging_statement);
+    return os;
+}
+
+int lines = 0;
+void count(const std::string& /*msg*/, Verbosity /*verbosity*/, Group /*group*/) { ++lines; }
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+    using dccl::dlog;
+
+    // even with every level connected at run time
+    dlog.connect(ALL, &count);
+
+    dlog.is(DEBUG3) && dlog << stream_assert << std::endl;
+    dlog.is(DEBUG2) && dlog << stream_assert << std::endl;
+    dlog.is(DEBUG1) && dlog << stream_assert << std::endl;
+    assert(lines == 0);
+
+    dlog.is(INFO) && dlog << "info ok" << std::endl;
+    dlog.is(WARN) && dlog << "warn ok" << std::endl;
+    assert(lines == 2);
+
+    // composite masks: checked against the levels they contain
+    assert(dlog.check(DEBUG1_PLUS));
+    assert(!dlog.check(static_cast<Verbosity>(DEBUG1 | DEBUG2)));
+
+    dlog.disconnect(ALL);
+
+    std::cout << "all tests passed" << std::endl;
+}
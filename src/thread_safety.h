@@ -26,11 +26,22 @@
 #if DCCL_THREAD_SUPPORT
 #include <atomic>
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
 namespace dccl
 {
 extern std::recursive_mutex g_dynamic_protobuf_manager_mutex;
 extern std::recursive_mutex g_dlog_mutex;
+
+namespace internal
+{
+// reader/writer lock for caches that are read on every encode/decode but only written when loading
+#ifdef DCCL_HAS_CPP17
+using SharedMutex = std::shared_mutex;
+#else
+using SharedMutex = std::shared_timed_mutex;
+#endif
+} // namespace internal
 } // namespace dccl
 
 #define DCCL_LOCK_DYNAMIC_PROTOBUF_MANAGER_MUTEX \
@@ -0,0 +1,255 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+
+#include "exception.h"
+#include "field_codec.h"
+#include "trace.h"
+
+namespace
+{
+const char TRACE_MAGIC[] = "DCCLTRC1";
+constexpr std::size_t TRACE_MAGIC_SIZE = sizeof(TRACE_MAGIC) - 1;
+
+// source of TraceBuffer::serial_ (0 is never used, so it never matches an unset cached codec id)
+std::atomic<dccl::uint64> next_trace_serial{1};
+
+// all integers are written little-endian, independent of the host
+template <typename Int> void write_int(std::ostream& os, Int value)
+{
+    for (std::size_t i = 0; i < sizeof(Int); ++i)
+        os.put(static_cast<char>((static_cast<dccl::uint64>(value) >> (8 * i)) & 0xFF));
+}
+
+template <typename Int> Int read_int(std::istream& is)
+{
+    dccl::uint64 value = 0;
+    for (std::size_t i = 0; i < sizeof(Int); ++i)
+    {
+        int c = is.get();
+        if (c == std::char_traits<char>::eof())
+            throw(dccl::Exception("Trace ends unexpectedly"));
+        value |= static_cast<dccl::uint64>(c) << (8 * i);
+    }
+    return static_cast<Int>(value);
+}
+} // namespace
+
+constexpr dccl::uint32 dccl::TraceRecord::UNKNOWN_OFFSET;
+
+dccl::TraceBuffer::TraceBuffer(std::size_t capacity)
+    : slots_(capacity), serial_(next_trace_serial++)
+{
+    if (capacity == 0)
+        throw(Exception("TraceBuffer capacity must be greater than zero"));
+}
+
+std::vector<dccl::TraceRecord> dccl::TraceBuffer::records() const
+{
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<std::mutex> l(mutex_);
+#endif
+    std::vector<TraceRecord> records;
+    uint64 begin = std::max(cleared_, next_ > slots_.size() ? next_ - slots_.size() : 0);
+    for (uint64 sequence = begin; sequence < next_; ++sequence)
+    {
+        const Slot& slot = slots_[sequence % slots_.size()];
+        // skip records that were started but never finished (e.g. the codec threw)
+        if (slot.sequence == sequence)
+            records.push_back(slot.record);
+    }
+    return records;
+}
+
+std::vector<std::string> dccl::TraceBuffer::codec_names() const
+{
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<std::mutex> l(mutex_);
+#endif
+    return codec_names_;
+}
+
+dccl::uint64 dccl::TraceBuffer::dropped() const
+{
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<std::mutex> l(mutex_);
+#endif
+    uint64 total = next_ - cleared_;
+    return total > slots_.size() ? total - slots_.size() : 0;
+}
+
+void dccl::TraceBuffer::clear()
+{
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<std::mutex> l(mutex_);
+#endif
+    cleared_ = next_;
+}
+
+std::uint16_t dccl::TraceBuffer::codec_id(const FieldCodecBase& codec)
+{
+    // the serial and id are stored together, so a single relaxed load is consistent
+    uint64 cached = codec.trace_codec_id_.load(std::memory_order_relaxed);
+    if ((cached >> 16) == serial_)
+        return static_cast<std::uint16_t>(cached & 0xFFFF);
+
+    std::uint16_t id;
+    {
+#if DCCL_THREAD_SUPPORT
+        std::lock_guard<std::mutex> l(mutex_);
+#endif
+        std::string name = codec.name();
+        auto it = codec_ids_.find(name);
+        if (it == codec_ids_.end())
+        {
+            it = codec_ids_.insert(std::make_pair(name, codec_names_.size())).first;
+            codec_names_.push_back(name);
+        }
+        id = it->second;
+    }
+    codec.trace_codec_id_.store((serial_ << 16) | id, std::memory_order_relaxed);
+    return id;
+}
+
+dccl::uint64 dccl::TraceBuffer::start(const FieldCodecBase& codec, std::uint16_t* codec_id)
+{
+    *codec_id = this->codec_id(codec);
+
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<std::mutex> l(mutex_);
+#endif
+    // invalidate the slot until finish() is called
+    uint64 sequence = next_++;
+    slots_[sequence % slots_.size()].sequence = static_cast<uint64>(-1);
+    return sequence;
+}
+
+void dccl::TraceBuffer::finish(uint64 sequence, const TraceRecord& record)
+{
+#if DCCL_THREAD_SUPPORT
+    std::lock_guard<std::mutex> l(mutex_);
+#endif
+    // overwritten by newer records (or cleared) while this field was being encoded/decoded
+    if (sequence < cleared_ || next_ - sequence > slots_.size())
+        return;
+
+    Slot& slot = slots_[sequence % slots_.size()];
+    slot.sequence = sequence;
+    slot.record = record;
+}
+
+void dccl::TraceBuffer::write(std::ostream& os) const
+{
+    std::vector<std::string> names = codec_names();
+    std::vector<TraceRecord> recs = records();
+
+    os.write(TRACE_MAGIC, TRACE_MAGIC_SIZE);
+    write_int<uint32>(os, names.size());
+    for (const std::string& name : names)
+    {
+        write_int<std::uint16_t>(os, name.size());
+        os.write(name.data(), name.size());
+    }
+
+    write_int<uint32>(os, recs.size());
+    for (const TraceRecord& record : recs)
+    {
+        write_int<uint32>(os, record.bit_offset);
+        write_int<uint32>(os, record.bit_length);
+        write_int<uint32>(os, record.field_number);
+        write_int<std::uint16_t>(os, record.codec_id);
+        write_int<unsigned char>(os, record.part);
+        write_int<unsigned char>(os, record.flags);
+        write_int<unsigned char>(os, record.depth);
+    }
+}
+
+void dccl::TraceBuffer::read(std::istream& is, std::vector<std::string>* codec_names,
+                             std::vector<TraceRecord>* records)
+{
+    char magic[TRACE_MAGIC_SIZE];
+    if (!is.read(magic, TRACE_MAGIC_SIZE) ||
+        !std::equal(magic, magic + TRACE_MAGIC_SIZE, TRACE_MAGIC))
+        throw(Exception("Not a DCCL trace (bad magic number)"));
+
+    codec_names->clear();
+    for (auto i = 0u, n = read_int<uint32>(is); i < n; ++i)
+    {
+        std::string name(read_int<std::uint16_t>(is), '\0');
+        if (!is.read(&name[0], name.size()))
+            throw(Exception("Trace ends unexpectedly"));
+        codec_names->push_back(name);
+    }
+
+    records->clear();
+    for (auto i = 0u, n = read_int<uint32>(is); i < n; ++i)
+    {
+        TraceRecord record;
+        record.bit_offset = read_int<uint32>(is);
+        record.bit_length = read_int<uint32>(is);
+        record.field_number = read_int<uint32>(is);
+        record.codec_id = read_int<std::uint16_t>(is);
+        record.part = read_int<unsigned char>(is);
+        record.flags = read_int<unsigned char>(is);
+        record.depth = read_int<unsigned char>(is);
+
+        if (record.codec_id >= codec_names->size())
+            throw(Exception("Trace record refers to unknown codec id " +
+                            std::to_string(record.codec_id)));
+        records->push_back(record);
+    }
+}
+
+void dccl::TraceBuffer::render(std::ostream& os, const std::vector<std::string>& codec_names,
+                               const std::vector<TraceRecord>& records)
+{
+    os << "op     part  offset  length  field\n";
+    for (const TraceRecord& record : records)
+    {
+        const char* op = (record.flags & TraceRecord::DECODE) ? "decode" : "encode";
+        const char* part = record.part == HEAD ? "head" : (record.part == BODY ? "body" : "?");
+        os << std::left << std::setw(7) << op << std::setw(6) << part << std::right << std::setw(6);
+
+        if (record.bit_offset == TraceRecord::UNKNOWN_OFFSET)
+            os << "?";
+        else
+            os << record.bit_offset;
+
+        os << std::setw(8) << record.bit_length << "  " << std::string(2 * record.depth, ' ');
+
+        if (record.field_number == 0)
+            os << "(message)";
+        else
+            os << record.field_number;
+
+        if (record.flags & TraceRecord::REPEATED)
+            os << "[]";
+
+        os << " " << (record.codec_id < codec_names.size() ? codec_names[record.codec_id] : "?")
+           << "\n";
+    }
+}
@@ -0,0 +1,137 @@
+// Copyright 2023:
+//   GobySoft, LLC (2013-)
+//   Community contributors (see AUTHORS file)
+// File authors:
+//   Toby Schneider <toby@gobysoft.org>
+//
+//
+// This file is part of the Dynamic Compact Control Language Library
+// ("DCCL").
+//
+// DCCL is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// DCCL is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DCCL.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef DCCLTRACE20231017H
+#define DCCLTRACE20231017H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+#include "thread_safety.h"
+
+namespace dccl
+{
+class FieldCodecBase;
+
+/// \brief One field encoded or decoded by a FieldCodec, as recorded in a TraceBuffer
+struct TraceRecord
+{
+    /// \brief bit_offset of fields whose position in the message is not known (fields encoded or decoded inside a non-streaming codec)
+    static constexpr uint32 UNKNOWN_OFFSET = 0xFFFFFFFF;
+
+    enum Flags : unsigned char
+    {
+        DECODE = 1 << 0,
+        REPEATED = 1 << 1
+    };
+
+    /// \brief Offset (in bits) of the field from the start of the part (head: after the DCCL ID, body: after the head)
+    uint32 bit_offset{UNKNOWN_OFFSET};
+    /// \brief Number of bits used by the field (including any nested fields)
+    uint32 bit_length{0};
+    /// \brief Field number, or 0 for the message itself
+    uint32 field_number{0};
+    /// \brief Index of the codec's name in TraceBuffer::codec_names()
+    std::uint16_t codec_id{0};
+    /// \brief MessagePart (HEAD or BODY)
+    unsigned char part{0};
+    /// \brief Combination of Flags
+    unsigned char flags{0};
+    /// \brief Nesting depth (0 for the message itself)
+    unsigned char depth{0};
+};
+
+/// \brief Fixed size ring buffer of TraceRecords, filled by Codec::encode() and Codec::decode() when given to Codec::set_trace()
+///
+/// This is a much cheaper alternative to the DEBUG2/DEBUG3 encode/decode log output for examining the layout of messages in production, as each field only stores a small fixed size record (no string formatting). Once full, the oldest records are overwritten. The contents can be written in a compact binary form using write() and rendered offline using render() (or the `dccl_trace` tool).
+class TraceBuffer
+{
+  public:
+    /// \param capacity Number of records kept (must be greater than zero)
+    explicit TraceBuffer(std::size_t capacity = 4096);
+
+    /// \brief Current contents, oldest first
+    std::vector<TraceRecord> records() const;
+
+    /// \brief Names of the codecs referred to by TraceRecord::codec_id
+    std::vector<std::string> codec_names() const;
+
+    /// \brief Number of records that have been overwritten since the last clear()
+    uint64 dropped() const;
+
+    /// \brief Remove all records (codec names are kept)
+    void clear();
+
+    /// \brief Write the codec names and records in the binary trace format
+    void write(std::ostream& os) const;
+
+    /// \brief Read the binary trace format produced by write()
+    ///
+    /// \throw Exception if the input is not a valid trace
+    static void read(std::istream& is, std::vector<std::string>* codec_names,
+                     std::vector<TraceRecord>* records);
+
+    /// \brief Write a human readable table of the given records, one line per record
+    static void render(std::ostream& os, const std::vector<std::string>& codec_names,
+                       const std::vector<TraceRecord>& records);
+
+    /// \brief Reserve the next record for a field about to be encoded or decoded by `codec` (used by FieldCodecBase)
+    ///
+    /// \return Sequence number to pass to finish()
+    uint64 start(const FieldCodecBase& codec, std::uint16_t* codec_id);
+
+    /// \brief Index of the codec's name in codec_names(), added the first time the codec is traced into this buffer and then cached in the codec (so only looked up by name again if the codec is used with another TraceBuffer in between)
+    std::uint16_t codec_id(const FieldCodecBase& codec);
+
+    /// \brief Store the record reserved by start() (dropped if it has since been overwritten)
+    void finish(uint64 sequence, const TraceRecord& record);
+
+  private:
+    struct Slot
+    {
+        // sequence number of the record stored, or -1 if empty or not yet finished
+        uint64 sequence{static_cast<uint64>(-1)};
+        TraceRecord record;
+    };
+
+    std::vector<Slot> slots_;
+    // unique to this TraceBuffer (never reused, unlike its address), identifying it in the ids cached by the codecs
+    const uint64 serial_;
+    uint64 next_{0};
+    uint64 cleared_{0};
+
+    // keyed by codec name, not codec object: several codecs share a name (e.g. one per field type) and an object's address may be reused by a different codec once it is removed. Only used the first time each codec is traced (see codec_id())
+    std::unordered_map<std::string, std::uint16_t> codec_ids_;
+    std::vector<std::string> codec_names_;
+
+#if DCCL_THREAD_SUPPORT
+    mutable std::mutex mutex_;
+#endif
+};
+
+} // namespace dccl
+
+#endif